@@ -37,6 +37,7 @@
 #include "hal/interrupt.h"
 #include "core/spi_master.h"
 #include "core/rotary.h"
+#include "core/rtimer.h"
 #include "drivers/mcp4922.h"
 
 // NOTE: the default fuse values defined in avr-libc are incorrect (see the 
@@ -144,6 +145,7 @@ int main(void)
   init_pins();
   clock_init();
   process_init();
+  rtimer_init();
   spim_init();
   rot_init(&rot0);
   mcp4922_init();
@@ -128,7 +128,7 @@ void init_lcd(void)
   hd44780_init();
   hd44780_lcd_setup(&lcd, &LCD_DATA_PORT, &LCD_CTRL_PORT, LCD_FIRST_DATA_PIN,
 		    LCD_E_PIN, LCD_RS_PIN, LCD_RW_PIN, lcd_instr_buf,
-		    LCD_INSTR_BUF_SIZE);
+		    LCD_INSTR_BUF_SIZE, NULL);
   hd44780_lcd_init(&lcd, HD44780_TWO_ROWS);
   hd44780_lcd_set_entry_mode(&lcd, HD44780_RIGHT, NO_SHIFT_DISPLAY);
   hd44780_lcd_set_display(&lcd, ENABLE_DISPLAY, DISABLE_CURSOR,
@@ -178,16 +178,16 @@ PROCESS_THREAD(spi_handler)
     if (spis_get_rx_type() == IOPANEL_REQUEST_TYPE &&
 	spis_get_rx_size() == sizeof(struct iopanel_request)) {
       struct iopanel_request* pkt = (struct iopanel_request*)spis_get_rx_buf();
-      psu_status.flags = pkt->flags;
-      psu_status.set_voltage = pkt->set_voltage;
-      psu_status.set_current = pkt->set_current;
-      psu_status.voltage = pkt->voltage;
-      psu_status.current = pkt->current;
+      psu_status.flags = pkt->d.normal.mode_flags;
+      psu_status.set_voltage = pkt->d.normal.set_voltage;
+      psu_status.set_current = pkt->d.normal.set_current;
+      psu_status.voltage = pkt->d.normal.voltage;
+      psu_status.current = pkt->d.normal.current;
     }
 
-    response.set_flags = 0;
-    response.set_voltage = knob_get_value(&knob_v);
-    response.set_current = knob_get_value(&knob_c);
+    response.d.normal.mode_flags = 0;
+    response.d.normal.set_voltage = knob_get_value(&knob_v);
+    response.d.normal.set_current = knob_get_value(&knob_c);
     spis_send_response(IOPANEL_RESPONSE_TYPE, (uint8_t*)&response,
 		       sizeof(struct iopanel_response));
 
@@ -292,6 +292,8 @@ int main(void)
   iomon_event_enable(&rot_tick);
 
   while (true) {
-    process_execute();
+    if (! process_execute()) {
+      process_idle();
+    }
   }
 }
@@ -32,8 +32,10 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "core/adc.h"
 #include "core/crc16.h"
 #include "core/eeprom.h"
+#include "core/process.h"
 #include "core/pwlf.h"
 
 #include "util/debug.h"
@@ -44,6 +46,9 @@
 
 #define CAL_EVENT_PROCESS_STARTED 0
 
+#define ADC_VOLTAGE_CHANNEL ADC_CHANNEL_0
+#define ADC_CURRENT_CHANNEL ADC_CHANNEL_1
+
 /********* EEPROM *********/
 static uint8_t EEMEM EE_adc_to_mvolt_count;
 static pwlf_pair EEMEM EE_adc_to_mvolt_pairs[CALIBRATION_NODES];
@@ -85,12 +90,14 @@ cal_process_start(cal_process* p, cal_process_type type)
    return CAL_PROCESS_INVALID_TYPE; 
   }
   adc_init_status adc_stat = 
-    adc_init(&(p->adc), channel, ADC_RESOLUTION_16BIT, ADC_SKIP_15, NULL);
+    adc_init(&(p->adc), channel, ADC_RESOLUTION_16BIT, ADC_SKIP_15);
   if (adc_stat != ADC_INIT_OK) {
     return CAL_PROCESS_ADC_INIT_ERROR;
   }
+  // Calibration measurements are taken from noise reduction sleep
+  adc_set_noise_reduction(&(p->adc), true);
   process_post_event_status proc_stat =
-    process_post_event(&calibration_process, CAL_EVENT_PROCESS_STARTED, NULL);
+    process_post_event(&dac_calibration_process, CAL_EVENT_PROCESS_STARTED, 0);
   if (proc_stat != PROCESS_POST_EVENT_OK) {
     return CAL_PROCESS_EVENT_ERROR;
   }
@@ -118,7 +125,7 @@ cal_process_adc_next(cal_process* p, uint16_t val)
   }
 
   uint8_t step = cal_process_get_step_number(p);
-  uin16_t adc_val = adc_get_value(&(p->adc));
+  uint16_t adc_val = adc_get_value(&(p->adc));
   if (step > 0) {
     uint16_t prev_val = pwlf_get_y(&(p->table), step - 1);
     if (val <= prev_val) {
@@ -131,7 +138,7 @@ cal_process_adc_next(cal_process* p, uint16_t val)
     }
   }
 
-  pwlf_add_node(&(p->table), adc_value, val);
+  pwlf_add_node(&(p->table), adc_val, val);
   //TODO: set DAC for next step
 
   return CAL_PROCESS_OK;
@@ -147,7 +154,7 @@ cal_process_cancel(cal_process* p)
 
   p->state = CAL_PROCESS_IDLE;
   pwlf_clear(&(p->table));
-  adc_disable(&(p->adc))
+  adc_disable(&(p->adc));
   current_process = NULL;
   return CAL_PROCESS_OK;
 }
@@ -167,19 +174,23 @@ cal_process_commit(cal_process* p)
     dst = &adc_to_mvolt;
     break;
   case CAL_PROCESS_CURRENT_ADC:
-    dst = &adc_to_mamps;
+    dst = &adc_to_mamp;
     break;
   case CAL_PROCESS_VOLTAGE_DAC:
     dst = &mvolt_to_dac;
     break;
   case CAL_PROCESS_CURRENT_DAC:
-    dst = &mamps_to_dac;
+    dst = &mamp_to_dac;
     break;
   default:
     p->state = CAL_PROCESS_ERROR;
     return CAL_PROCESS_INVALID_STATE;
   }
-  pwlf_copy(&(p->table), dst);
+  pwlf_clear(dst);
+  uint8_t i;
+  for (i = 0; i < pwlf_get_count(&(p->table)); ++i) {
+    pwlf_add_node(dst, pwlf_get_x(&(p->table), i), pwlf_get_y(&(p->table), i));
+  }
   pwlf_clear(&(p->table));
   adc_disable(&(p->adc));
   p->state = CAL_PROCESS_IDLE;
@@ -25,6 +25,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "core/adc.h"
 #include "core/pwlf.h"
 
 /**
@@ -28,6 +28,13 @@
 
 #include "control.h"
 
+#include <stdint.h>
+
+#include "core/adc.h"
+#include "core/process.h"
+#include "drivers/mcp4922.h"
+#include "hal/gpio.h"
+
 #define DAC_CS      B,1
 #define ADC_VOLTAGE_CHANNEL ADC_CHANNEL_0
 #define ADC_CURRENT_CHANNEL ADC_CHANNEL_1
@@ -38,23 +45,28 @@ PROCESS(ctrl_process);
 
 static uint16_t channel_output[CTRL_NB_CHANNELS];
 
-static const adc adcs[CTRL_NB_CHANNELS];
+static adc adcs[CTRL_NB_CHANNELS];
+static adc_group input_group;
 static const mcp4922_channel ch_to_dac[] =
 {
   MCP4922_CHANNEL_A, // VOLTAGE CHANNEL
   MCP4922_CHANNEL_B, // CURRENT CHANNEL
 };
 
-
 void ctrl_init(void)
 {
+  // Voltage and current are sampled as a group, so products of both are not
+  // skewed during load transients
+  adc_group_init(&input_group, NULL);
   adc_init(&adcs[CTRL_CH_VOLTAGE0], ADC_VOLTAGE_CHANNEL, ADC_RESOLUTION_15BIT,
-	   ADC_SKIP_0, NULL);
-  adc_enable(&adcs[CTRL_CH_VOLTAGE0]);
+	   ADC_SKIP_0);
+  adc_group_add(&input_group, &adcs[CTRL_CH_VOLTAGE0]);
 
   adc_init(&adcs[CTRL_CH_CURRENT0], ADC_CURRENT_CHANNEL, ADC_RESOLUTION_15BIT,
-	   ADC_SKIP_0, NULL);
-  adc_enable(&adcs[CTRL_CH_CURRENT0]);
+	   ADC_SKIP_0);
+  adc_group_add(&input_group, &adcs[CTRL_CH_CURRENT0]);
+
+  adc_group_enable(&input_group);
 
   process_start(&ctrl_process);
 }
@@ -81,6 +93,13 @@ ctrl_get_input(ctrl_channel ch)
 }
 
 
+void ctrl_get_inputs(uint16_t inputs[CTRL_NB_CHANNELS])
+{
+  // The group members were added in channel order
+  adc_group_get_values(&input_group, inputs);
+}
+
+
 PROCESS_THREAD(ctrl_process)
 {
   PROCESS_BEGIN();
@@ -91,11 +110,14 @@ PROCESS_THREAD(ctrl_process)
   mcp4922_pkt_init(&packet);
 
   while (true) {
+    // The packet can only be reconfigured once it has left the queue
     PROCESS_WAIT_EVENT_UNTIL(ev == CTRL_EVENT_SET_OUTPUT_CHANGED && 
-			     !mcp4922_pkt_is_in_transmission(&packet));
+			     !mcp4922_pkt_is_queued(&packet));
     ch = (ctrl_channel)data;
     mcp4922_pkt_set(&packet, GET_BIT(DAC_CS), &GET_PORT(DAC_CS),
 		    ch_to_dac[ch], channel_output[ch]);
     mcp4922_pkt_queue(&packet);
   }
+
+  PROCESS_END();
 }
@@ -28,6 +28,8 @@
  * @date 22 Jul 2015
  */
 
+#include <stdbool.h>
+#include <stdint.h>
 
 typedef enum {
   CTRL_CH_VOLTAGE0,
@@ -43,7 +45,7 @@ typedef enum {
  *  * adc
  *  * mcp4922
  */
-void ctrl_init(void)
+void ctrl_init(void);
 
 
 /**
@@ -62,5 +64,16 @@ void ctrl_set_output(ctrl_channel ch, uint16_t val);
  */
 uint16_t ctrl_get_input(ctrl_channel ch);
 
+/**
+ * Return the current values of all channels.
+ *
+ * The values are sampled back-to-back and come from the same set of
+ * measurements, so they can be combined into power and energy figures.
+ *
+ * @param inputs Buffer that receives the value of each channel, indexed by
+ *               channel
+ */
+void ctrl_get_inputs(uint16_t inputs[CTRL_NB_CHANNELS]);
+
 
 #endif
@@ -31,11 +31,13 @@
 #include <stdlib.h>
 
 #include "calibration.h"
+#include "control.h"
 #include "apps/psu/packets.h"
 #include "core/adc.h"
 #include "core/etimer.h"
 #include "core/process.h"
 #include "core/pwlf.h"
+#include "core/rtimer.h"
 #include "core/spi_master.h"
 #include "drivers/mcp4922.h"
 #include "hal/fuses.h"
@@ -55,6 +57,9 @@ FUSES =
 
 
 #define DAC_CS      B,1
+#define IOPANEL_CS  B,2
+
+#define IOPANEL_UPDATE_RATE CLK_NEAREST(10 * CLOCK_MSEC)
 
 #define DAC_MIN 0x0000
 #define DAC_MAX 0x0FFF
@@ -91,6 +96,9 @@ static struct {
 static inline
 void init_pins(void)
 {
+  // Deselect the SPI slaves before driving their chip select lines
+  SET_PIN(DAC_CS);
+  SET_PIN(IOPANEL_CS);
   SET_PIN_DIR_OUTPUT(DAC_CS);
   SET_PIN_DIR_OUTPUT(IOPANEL_CS);
 }
@@ -100,13 +108,13 @@ void init_pins(void)
 static inline
 int16_t get_voltage_reading(void)
 {
-  return cal_adc_to_mvolt(ctrl_get_value(CTRL_CH_VOLTAGE0));
+  return cal_adc_to_mvolt(ctrl_get_input(CTRL_CH_VOLTAGE0));
 }
 
 static inline
 int16_t get_current_reading(void)
 {
-  return cal_adc_to_mamp(ctrl_get_value(CTRL_CH_CURRENT0));
+  return cal_adc_to_mamp(ctrl_get_input(CTRL_CH_CURRENT0));
 }
 
 static inline
@@ -149,11 +157,11 @@ PROCESS_THREAD(iopanel_update_process)
     PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&tmr));
 
     if (! spim_trx_is_queued((spim_trx*)&trx)) {
-      request.flags = psu_status.flags;
-      request.set_voltage = psu_status.set_voltage;
-      request.set_current = psu_status.set_current;
-      request.voltage = get_voltage_reading();
-      request.current = get_current_reading();
+      request.d.normal.mode_flags = psu_status.flags;
+      request.d.normal.set_voltage = psu_status.set_voltage;
+      request.d.normal.set_current = psu_status.set_current;
+      request.d.normal.voltage = get_voltage_reading();
+      request.d.normal.current = get_current_reading();
 
       spim_trx_queue((spim_trx*)&trx);
 
@@ -180,8 +188,8 @@ PROCESS_THREAD(iopanel_update_process)
 
       // Data exchanged successfully with IO panel. Now we will update the
       // psu state according to the values received from the IO panel.      
-      psu_status.set_voltage = response.set_voltage;
-      psu_status.set_current = response.set_current;
+      psu_status.set_voltage = response.d.normal.set_voltage;
+      psu_status.set_current = response.d.normal.set_current;
 
       // Immediately update the DAC values according to the psu status
       ctrl_set_output(CTRL_CH_VOLTAGE0, mvolt_to_dac(psu_status.set_voltage));
@@ -202,8 +210,10 @@ int main(void)
   cal_init();
   process_init();
   init_etimer();
+  rtimer_init();
   spim_init();
   init_adc();
+  process_set_idle_hook(adc_sleep_idle);
   mcp4922_init();
   ctrl_init();
 
@@ -212,6 +222,8 @@ int main(void)
   process_start(&iopanel_update_process);
 
   while (true) {
-    process_execute();
+    if (! process_execute()) {
+      process_idle();
+    }
   }
 }
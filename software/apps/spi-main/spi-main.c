@@ -30,6 +30,7 @@
 
 #include "core/clock.h"
 #include "core/process.h"
+#include "core/rtimer.h"
 #include "core/spi_master.h"
 #include "core/timer.h"
 #include "hal/interrupt.h"
@@ -110,6 +111,7 @@ int main(void)
   init_pins();
   clock_init();
   process_init();
+  rtimer_init();
   spim_init();
 
   process_start(&spi_transmitter);
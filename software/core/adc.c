@@ -35,20 +35,82 @@
 #include <stdint.h>
 #include <util/atomic.h>
 
+#include "core/adc_filter.h"
+#include "core/clock.h"
+#include "core/etimer.h"
+#include "core/events.h"
 #include "core/process.h"
+#include "core/rtimer.h"
+#include "core/spi_master.h"
 #include "hal/adc.h"
 #include "hal/interrupt.h"
+#include "hal/sleep.h"
+#include "util/bit.h"
 #include "util/int.h"
 
-PROCESS(adc_process);
+process_topic adc_measurement_topic;
 
-#define SAMPLE_BUFFER_SIZE 8 // Must be at least 3 and preferably a power of 2
-
-#define EVENT_ADC_LIST_CHANGED         (process_event_t)0x00
-#define EVENT_ADC_CONVERSION_COMPLETE  (process_event_t)0x01
+#define SAMPLE_BUFFER_SIZE 4 // Must be at least 3 and preferably a power of 2
 
+// Both are also used by the ADC ISR, so they must only be modified in atomic
+// blocks
 static adc* adcs;
 static adc* next_adc_to_consider;
+// Number of ADCs in the list that share the slots without a target rate
+static uint8_t nb_best_effort;
+
+// Schedule of the enabled ADCs with a target rate. A new frame is built in
+// the inactive buffer and then swapped in atomically, so the ADC ISR never
+// sees a partial frame.
+#define FRAME_SIZE ADC_CONF_FRAME_SIZE
+static adc* frames[2][FRAME_SIZE];
+static adc** volatile frame;
+static uint8_t frame_pos; // Only used by the ADC ISR
+static uint16_t reserved_slots;
+
+// Completed measurements are published from the ADC ISR
+static process_isr_queue isr_queue;
+
+// The running capture, if any. Capture samples are queued in the sample buffer
+// as the capture_slot placeholder, whose channel is the capture channel.
+static adc_capture* volatile capture;
+static adc capture_slot;
+static bool capture_turn;
+// Placeholder for slots that are only converted to keep the capture samples
+// evenly spaced. Its samples_remaining stays 0, so the ISR discards them.
+static adc filler_slot;
+// Capture slots that were already converting when the capture was started may
+// have sampled the channel of a previous capture, so they are discarded
+static uint8_t capture_discard;
+
+// The members of a group are queued back-to-back. This is the next member to
+// queue after the one that was queued last, or NULL. Only used by the ADC ISR
+// and by adc_group_disable().
+static adc* next_group_member;
+
+// Conversions from noise reduction sleep. The free-running pipeline is first
+// drained and stopped, then a single conversion is done from sleep, after which
+// the pipeline is restarted.
+typedef enum {
+  QUIET_OFF,
+  QUIET_DRAINING,   // The ISR only queues the rest of the current group
+  QUIET_STOPPING,   // Auto triggering is off, one conversion is still running
+  QUIET_STOPPED,
+  QUIET_CONVERTING, // Converting quiet_adc from noise reduction sleep
+} quiet_state_t;
+static volatile uint8_t quiet_state;
+static adc* quiet_adc;
+static uint8_t quiet_turn; // Only used by adc_sleep_idle()
+
+// Noise reduction sleep halts the I/O clock, and with it the clock timer, from
+// the moment the CPU stops until the conversion completes. This takes about
+// 13.5 ADC clock cycles of 64 CPU cycles each, which the clock is advanced by
+// afterwards. The remainder is carried over to the next conversion, so the
+// clock does not drift.
+#define QUIET_CONVERSION_CYCLES (27 * 64 / 2)
+#define QUIET_CONVERSION_TICKS \
+  ((QUIET_CONVERSION_CYCLES + CLOCK_TMR_PRESCALER - 1) / CLOCK_TMR_PRESCALER)
+static uint16_t quiet_lost_cycles; // Only used by adc_sleep_idle()
 
 static volatile uint8_t sample_buffer_head = 0;
 static volatile uint8_t sample_buffer_count = 2;
@@ -58,12 +120,29 @@ void init_adc(void)
 {
   adcs = NULL;
   next_adc_to_consider = NULL;
+  nb_best_effort = 0;
+  frame = frames[0];
+  frame_pos = 0;
+  reserved_slots = 0;
   sample_buffer_head = 0;
   sample_buffer_count = 2;
+  capture = NULL;
+  capture_turn = false;
+  capture_discard = 0;
+  next_group_member = NULL;
+  quiet_state = QUIET_OFF;
+  quiet_adc = NULL;
+  quiet_turn = 0;
+  quiet_lost_cycles = 0;
   uint8_t i;
   for (i = 0; i < SAMPLE_BUFFER_SIZE; ++i) {
     sample_buffer[i] = NULL;
   }
+  for (i = 0; i < FRAME_SIZE; ++i) {
+    frames[0][i] = NULL;
+  }
+  process_isr_queue_init(&isr_queue, PROCESS_EVENT_PRIORITY_NORMAL);
+  process_topic_init(&adc_measurement_topic);
 
   ADC_SET_VREF(AREF);
   ADC_SET_ADJUST(RIGHT);
@@ -74,8 +153,6 @@ void init_adc(void)
   ADC_CC_INTERRUPT_ENABLE();
   ADC_ENABLE();
   ADC_START_CONVERSION();
-
-  process_start(&adc_process);
 }
 
 static bool
@@ -117,7 +194,7 @@ bool adc_in_list(adc* adc0)
 
 adc_init_status
 adc_init(adc* adc, adc_channel channel, adc_resolution resolution,
-	 adc_skip skip, process* process)
+	 adc_skip skip)
 {
   if (adc_in_list(adc)) {
     return ADC_INIT_ALREADY_IN_LIST;
@@ -136,10 +213,141 @@ adc_init(adc* adc, adc_channel channel, adc_resolution resolution,
   adc->channel = channel;
   adc->resolution = resolution;
   adc->skip = skip;
-  adc->process = process;
+  adc->slots = 0;
+  adc->filters = NULL;
+  adc->trip = NULL;
+  adc->group = NULL;
+  adc->group_next = NULL;
+  adc->noise_reduction = false;
   return ADC_INIT_OK;
 }
 
+void adc_trip_init(adc_trip* trip, uint16_t limit, adc_trip_callback f,
+		   void* ptr)
+{
+  trip->limit = limit;
+  trip->f = f;
+  trip->ptr = ptr;
+  trip->tripped = false;
+}
+
+bool adc_set_trip(adc* adc0, adc_trip* trip)
+{
+  if (adc_in_list(adc0)) {
+    return false;
+  }
+
+  adc0->trip = trip;
+  return true;
+}
+
+bool adc_trip_is_tripped(adc_trip* trip)
+{
+  return trip->tripped;
+}
+
+void adc_trip_rearm(adc_trip* trip)
+{
+  trip->tripped = false;
+}
+
+adc_set_rate_status adc_set_rate(adc* adc0, uint16_t rate)
+{
+  if (adc_in_list(adc0)) {
+    return ADC_SET_RATE_ENABLED;
+  }
+  if (adc0->group != NULL) {
+    return ADC_SET_RATE_IN_GROUP;
+  }
+  if (adc0->noise_reduction) {
+    return ADC_SET_RATE_NOISE_REDUCTION;
+  }
+
+  uint32_t conversions = (uint32_t)rate << (2 * adc0->resolution);
+  if (conversions > ADC_CONVERSION_RATE) {
+    return ADC_SET_RATE_TOO_HIGH;
+  }
+
+  // Round up, so the ADC is measured at least at the target rate
+  adc0->slots = (conversions * FRAME_SIZE + ADC_CONVERSION_RATE - 1)
+    / ADC_CONVERSION_RATE;
+  return ADC_SET_RATE_OK;
+}
+
+bool adc_rates_fit(void)
+{
+  return reserved_slots <= FRAME_SIZE;
+}
+
+// Must not be called from the ADC ISR
+static void
+build_frame(void)
+{
+  adc** next_frame = (frame == frames[0]) ? frames[1] : frames[0];
+  uint8_t i;
+  for (i = 0; i < FRAME_SIZE; ++i) {
+    next_frame[i] = NULL;
+  }
+
+  adc* a;
+  for (a = adcs; a != NULL; a = a->next) {
+    if (a->slots == 0) {
+      continue;
+    }
+
+    uint16_t n = a->slots;
+    if (reserved_slots > FRAME_SIZE) {
+      // Overcommitted, every ADC gets a proportional share
+      n = n * FRAME_SIZE / reserved_slots;
+      if (n == 0) {
+	n = 1;
+      }
+    }
+
+    // Spread the slots evenly over the frame, starting from the first free
+    // slot
+    uint8_t start = 0;
+    while (start < FRAME_SIZE && next_frame[start] != NULL) {
+      start += 1;
+    }
+    if (start == FRAME_SIZE) {
+      break;
+    }
+    for (i = 0; i < n; ++i) {
+      uint8_t pos = (start + (i * FRAME_SIZE) / n) & (FRAME_SIZE - 1);
+      uint8_t probes = 1;
+      while (next_frame[pos] != NULL && probes < FRAME_SIZE) {
+	pos = (pos + 1) & (FRAME_SIZE - 1);
+	probes += 1;
+      }
+      if (next_frame[pos] != NULL) {
+	break;
+      }
+      next_frame[pos] = a;
+    }
+  }
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    frame = next_frame;
+    frame_pos = 0;
+  }
+}
+
+bool adc_add_filter(adc* adc0, adc_filter* f)
+{
+  if (adc_in_list(adc0)) {
+    return false;
+  }
+
+  adc_filter** s = &(adc0->filters);
+  while (*s != NULL) {
+    s = &((*s)->next);
+  }
+  f->next = NULL;
+  *s = f;
+  return true;
+}
+
 /*static inline
 bool adc_is_ready(adc* adc)
 {
@@ -168,6 +376,21 @@ adc_channel adc_get_channel(adc* adc)
   return adc->channel;
 }
 
+// Group members other than the first one are only queued right after the
+// member before them
+static inline bool
+is_group_follower(adc* adc)
+{
+  return adc->group != NULL && adc->group->adcs != adc;
+}
+
+// Whether an ADC takes turns in the slots that are not reserved
+static inline bool
+is_best_effort(adc* adc)
+{
+  return adc->slots == 0 && ! is_group_follower(adc) && ! adc->noise_reduction;
+}
+
 bool adc_enable(adc* adc0)
 {
   // Find position in ADC list
@@ -179,20 +402,34 @@ bool adc_enable(adc* adc0)
     a = &((*a)->next);
   }
 
-  // Initialize ADC
-  adc0->next_value = 0;
-  reset_samples_remaining(adc0);
-
-  // Add new ADC to list
-  adc0->next = *a;
-  *a = adc0;
-
   // Disable digital input on channel to save power
   ADC_DIGITAL_INPUT_DISABLE(adc_get_channel(adc0));
 
-  // Notify the ADC process that the ADC list has changed
-  process_post_event(&adc_process, EVENT_ADC_LIST_CHANGED, PROCESS_DATA_NULL);
+  // The filter history may be stale, the ISR does not use it before the ADC
+  // is in the list
+  adc_filter* f;
+  for (f = adc0->filters; f != NULL; f = f->next) {
+    adc_filter_reset(f);
+  }
 
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    // Initialize ADC
+    adc0->next_value = 0;
+    reset_samples_remaining(adc0);
+
+    // Add new ADC to list, the ISR will start sampling it from the next
+    // conversion onwards
+    adc0->next = *a;
+    *a = adc0;
+    if (is_best_effort(adc0)) {
+      nb_best_effort += 1;
+    }
+  }
+
+  if (adc0->slots != 0) {
+    reserved_slots += adc0->slots;
+    build_frame();
+  }
   return true;
 }
 
@@ -213,19 +450,27 @@ bool adc_disable(adc* adc0)
     return false;
   }
 
-  // Make sure we do not consider this ADC for the next channel to queue.
-  if (next_adc_to_consider == adc0) {
-    next_adc_to_consider = adc0->next;
-  }
   ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-    // Prevent the ISR from messing with this ADC structure
+    // Make sure we do not consider this ADC for the next channel to queue.
+    if (next_adc_to_consider == adc0) {
+      next_adc_to_consider = adc0->next;
+    }
+
+    // Prevent the ISR from using samples that are still queued for this ADC
     adc0->samples_remaining = 0;
+
+    // Remove ADC from list
+    *a = (*a)->next;
+    adc0->next = NULL;
+    if (is_best_effort(adc0)) {
+      nb_best_effort -= 1;
+    }
   }
 
-  // Remove ADC from list
-  *a = (*a)->next;
-  adc0->next = NULL;
-  
+  if (adc0->slots != 0) {
+    reserved_slots -= adc0->slots;
+    build_frame();
+  }
 
   // Check channel of next ADC in list
   only_adc_for_channel = only_adc_for_channel &&
@@ -241,33 +486,326 @@ bool adc_disable(adc* adc0)
 
 uint16_t adc_get_value(adc* adc)
 {
-  return adc->value;
+  // The value is updated by the ADC ISR, retry if it changed while reading
+  uint16_t value;
+  do {
+    value = adc->value;
+  } while (value != adc->value);
+  return value;
+}
+
+void adc_group_init(adc_group* g, process* p)
+{
+  g->adcs = NULL;
+  g->p = p;
+  g->seq = 0;
+}
+
+adc_group_add_status adc_group_add(adc_group* g, adc* adc0)
+{
+  if (adc_in_list(adc0) || (g->adcs != NULL && adc_in_list(g->adcs))) {
+    return ADC_GROUP_ADD_ENABLED;
+  }
+  if (adc0->group != NULL) {
+    return ADC_GROUP_ADD_ALREADY_IN_GROUP;
+  }
+  if (g->adcs != NULL && g->adcs->resolution != adc0->resolution) {
+    return ADC_GROUP_ADD_RESOLUTION_MISMATCH;
+  }
+  if (adc0->slots != 0) {
+    return ADC_GROUP_ADD_HAS_RATE;
+  }
+  if (adc0->noise_reduction) {
+    return ADC_GROUP_ADD_NOISE_REDUCTION;
+  }
+
+  adc** a = &g->adcs;
+  while (*a != NULL) {
+    a = &((*a)->group_next);
+  }
+  *a = adc0;
+  adc0->group = g;
+  adc0->group_next = NULL;
+  return ADC_GROUP_ADD_OK;
+}
+
+bool adc_group_enable(adc_group* g)
+{
+  if (g->adcs == NULL || adc_in_list(g->adcs)) {
+    return false;
+  }
+
+  // The ISR must not queue the first member before the others are enabled
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    adc* a;
+    for (a = g->adcs; a != NULL; a = a->group_next) {
+      adc_enable(a);
+    }
+  }
+  return true;
+}
+
+bool adc_group_disable(adc_group* g)
+{
+  if (g->adcs == NULL || ! adc_in_list(g->adcs)) {
+    return false;
+  }
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    adc* a;
+    for (a = g->adcs; a != NULL; a = a->group_next) {
+      adc_disable(a);
+    }
+    if (next_group_member != NULL && next_group_member->group == g) {
+      next_group_member = NULL;
+    }
+  }
+  return true;
+}
+
+uint8_t adc_group_get_values(adc_group* g, uint16_t* values)
+{
+  // Retry while the ADC ISR is updating the members, or if it started doing so
+  // while reading
+  uint8_t seq;
+  uint8_t n;
+  do {
+    seq = g->seq;
+    n = 0;
+    adc* a;
+    for (a = g->adcs; a != NULL; a = a->group_next) {
+      values[n++] = a->value;
+    }
+  } while ((seq & 1) != 0 || seq != g->seq);
+  return n;
+}
+
+bool adc_set_noise_reduction(adc* adc0, bool noise_reduction)
+{
+  if (adc_in_list(adc0) || adc0->group != NULL || adc0->slots != 0) {
+    return false;
+  }
+  adc0->noise_reduction = noise_reduction;
+  return true;
+}
+
+// Returns the next enabled ADC to convert from noise reduction sleep, or NULL.
+// The ISR does not modify the ADC list, so it can be read here as it is.
+static adc*
+find_next_quiet_adc(void)
+{
+  uint8_t nb = 0;
+  adc* a;
+  for (a = adcs; a != NULL; a = a->next) {
+    if (a->noise_reduction) {
+      nb += 1;
+    }
+  }
+  if (nb == 0) {
+    return NULL;
+  }
+
+  uint8_t i = quiet_turn % nb;
+  quiet_turn = i + 1;
+  for (a = adcs; a != NULL; a = a->next) {
+    if (a->noise_reduction) {
+      if (i == 0) {
+	break;
+      }
+      i -= 1;
+    }
+  }
+  return a;
+}
+
+// Sleep until the ADC ISR has moved to the given state.
+// Must be called with interrupts disabled, returns with interrupts disabled.
+static void
+sleep_until(quiet_state_t state)
+{
+  while (quiet_state != state) {
+    SLEEP_ENABLE();
+    ENABLE_INTERRUPTS();
+    SLEEP_CPU();
+    SLEEP_DISABLE();
+    DISABLE_INTERRUPTS();
+  }
 }
 
+static inline bool
+capture_is_running(adc_capture* c)
+{
+  return c != NULL &&
+    (c->state == ADC_CAPTURE_ARMED || c->state == ADC_CAPTURE_TRIGGERED);
+}
+
+// Noise reduction sleep also halts the rtimer, the SPI master and the capture
+// samples, and it delays any interrupt that does not wake the MCU from it.
+// Must be called with interrupts disabled.
+static bool
+can_convert_quietly(void)
+{
+  return ! process_is_work_pending()
+    && ! spim_is_busy()
+    && ! rtimer_is_any_scheduled()
+    && ! etimer_is_due_within(QUIET_CONVERSION_TICKS)
+    && ! capture_is_running(capture);
+}
+
+// Must be called with interrupts disabled, right after waking up from noise
+// reduction sleep
+static void
+advance_clock(void)
+{
+  quiet_lost_cycles += QUIET_CONVERSION_CYCLES;
+  clock_advance(quiet_lost_cycles / CLOCK_TMR_PRESCALER);
+  quiet_lost_cycles %= CLOCK_TMR_PRESCALER;
+}
+
+void adc_sleep_idle(void)
+{
+  if (! can_convert_quietly()) {
+    process_sleep_idle();
+    return;
+  }
+  adc* q = find_next_quiet_adc();
+  if (q == NULL) {
+    process_sleep_idle();
+    return;
+  }
+
+  // Let the ISR complete the conversions that are already queued
+  quiet_state = QUIET_DRAINING;
+  SLEEP_SET_MODE(IDLE);
+  sleep_until(QUIET_STOPPED);
+
+  // The interrupts that ran while draining may have posted work or set timers.
+  // The measurement then keeps its turn for the next time the MCU is idle.
+  if (can_convert_quietly()) {
+    // Entering noise reduction sleep starts a single conversion
+    quiet_adc = q;
+    ADC_SET_CHANNEL(adc_get_channel(q));
+    quiet_state = QUIET_CONVERTING;
+    SLEEP_SET_MODE(ADC);
+    sleep_until(QUIET_STOPPED);
+    advance_clock();
+  } else {
+    quiet_turn -= 1;
+  }
+
+  // Restart the free-running pipeline the same way init_adc() starts it
+  quiet_state = QUIET_OFF;
+  ADC_SET_CHANNEL(ADC_CHANNEL_GND);
+  ADC_AUTO_TRIGGER_ENABLE();
+  ADC_START_CONVERSION();
+  ENABLE_INTERRUPTS();
+}
+
+adc_capture_init_status
+adc_capture_init(adc_capture* c, adc_channel channel,
+		 adc_capture_trigger trigger, uint16_t level, uint16_t* buf,
+		 uint16_t size, uint16_t pre_trigger, process* p)
+{
+  if (! is_valid_adc_channel(channel)) {
+    return ADC_CAPTURE_INIT_INVALID_CHANNEL;
+  }
+  if (buf == NULL || size == 0) {
+    return ADC_CAPTURE_INIT_INVALID_BUFFER;
+  }
+  if (pre_trigger >= size) {
+    return ADC_CAPTURE_INIT_INVALID_PRE_TRIGGER;
+  }
+
+  c->channel = channel;
+  c->trigger = trigger;
+  c->level = level;
+  c->buf = buf;
+  c->size = size;
+  c->pre_trigger = pre_trigger;
+  c->p = p;
+  c->state = ADC_CAPTURE_IDLE;
+  return ADC_CAPTURE_INIT_OK;
+}
+
+bool adc_capture_start(adc_capture* c)
+{
+  bool result = false;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if (! capture_is_running(capture)) {
+      c->head = 0;
+      c->count = 0;
+      c->state = ADC_CAPTURE_ARMED;
+      capture_slot.channel = c->channel;
+      filler_slot.channel = c->channel;
+      capture_discard = 2;
+      capture = c;
+      result = true;
+    }
+  }
+  return result;
+}
+
+bool adc_capture_stop(adc_capture* c)
+{
+  bool result = false;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if (capture == c && capture_is_running(c)) {
+      c->state = ADC_CAPTURE_IDLE;
+      capture = NULL;
+      result = true;
+    }
+  }
+  return result;
+}
+
+adc_capture_state adc_capture_get_state(adc_capture* c)
+{
+  return c->state;
+}
+
+uint16_t adc_capture_get_sample(adc_capture* c, uint16_t i)
+{
+  // The buffer is full, so the oldest sample is at the head
+  uint16_t idx = c->head + i;
+  if (idx >= c->size) {
+    idx -= c->size;
+  }
+  return c->buf[idx];
+}
+
+
 static inline bool
 should_skip(adc* adc, uint8_t period)
 {
-  return (adc->skip & period) != 0;
+  // ADCs with a target rate are only sampled in their reserved slots
+  return ! is_best_effort(adc) || (adc->skip & period) != 0;
 }
 
 static inline void
 set_value(adc* adc)
 {
+  uint16_t value;
   if (adc->resolution <= ADC_RESOLUTION_13BIT) {
     uint8_t shift = 6 - (2 * adc->resolution);
-    adc->value = adc->next_value << shift;
+    value = adc->next_value << shift;
   } else {
     uint8_t shift = (2 * adc->resolution) - 6;
-    adc->value = adc->next_value >> (uint24_t)shift;
+    value = adc->next_value >> (uint24_t)shift;
+  }
+
+  adc_filter* f;
+  for (f = adc->filters; f != NULL; f = f->next) {
+    value = adc_filter_apply(f, value);
   }
+  adc->value = value;
 }
 
 static inline adc*
-find_next_adc_to_queue(void)
+find_next_best_effort_adc(void)
 {
   static uint8_t period = 0;
   adc* adc = next_adc_to_consider;
-  while(adcs != NULL) {
+  while(nb_best_effort > 0) {
     while(adc != NULL && should_skip(adc, period)) {
       adc = adc->next;
     }
@@ -285,58 +823,204 @@ find_next_adc_to_queue(void)
   return NULL;
 }
 
+static inline adc*
+find_next_adc_to_queue(void)
+{
+  adc* adc = frame[frame_pos];
+  frame_pos = (frame_pos + 1) & (FRAME_SIZE - 1);
+  if (adc != NULL) {
+    return adc;
+  }
+
+  // Slots that are not reserved are shared by the ADCs without a target rate
+  return find_next_best_effort_adc();
+}
+
+// The members of a group follow the first member without interruption
+static inline adc*
+find_next_measurement_to_queue(void)
+{
+  adc* next = next_group_member;
+  if (next == NULL) {
+    next = find_next_adc_to_queue();
+    if (next == NULL || next->group == NULL) {
+      return next;
+    }
+  }
+  next_group_member = next->group_next;
+  return next;
+}
+
+// While a capture is running, it gets every other slot, so its samples are
+// evenly spaced. The other slots that are not needed for ADC measurements are
+// filled with conversions that are discarded.
+static inline adc*
+find_next_to_queue(void)
+{
+  if (capture_is_running(capture)) {
+    capture_turn = ! capture_turn;
+    if (capture_turn) {
+      return &capture_slot;
+    }
+    adc* next = find_next_measurement_to_queue();
+    return (next != NULL) ? next : &filler_slot;
+  }
+  return find_next_measurement_to_queue();
+}
+
+// Must only be called from the ADC ISR
+static inline void
+queue(adc* adc)
+{
+  uint8_t sample_buffer_tail =
+    (sample_buffer_head + sample_buffer_count) % SAMPLE_BUFFER_SIZE;
+  sample_buffer[sample_buffer_tail] = adc;
+  sample_buffer_count += 1;
+}
+
+// Must only be called from the ADC ISR
 static inline
 void fill_sample_buffer(void)
 {
   while (sample_buffer_count < SAMPLE_BUFFER_SIZE) {
-    adc* next = find_next_adc_to_queue();
+    adc* next = find_next_to_queue();
     if (next == NULL) {
       return;
     }
+    queue(next);
+  }
+}
 
-    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-      uint8_t sample_buffer_tail =
-	(sample_buffer_head + sample_buffer_count) % SAMPLE_BUFFER_SIZE;
-      sample_buffer[sample_buffer_tail] = next;
-      sample_buffer_count += 1;
+// While draining, only the rest of a group is queued, so its members keep
+// the same number of samples. Once nothing is queued anymore, auto triggering
+// is turned off. Must only be called from the ADC ISR.
+static inline void
+drain_sample_buffer(void)
+{
+  while (next_group_member != NULL
+	 && sample_buffer_count < SAMPLE_BUFFER_SIZE) {
+    queue(next_group_member);
+    next_group_member = next_group_member->group_next;
+  }
+
+  uint8_t i;
+  for (i = 0; i < SAMPLE_BUFFER_SIZE; ++i) {
+    if (sample_buffer[i] != NULL) {
+      return;
     }
   }
+  ADC_AUTO_TRIGGER_DISABLE();
+  quiet_state = QUIET_STOPPING;
 }
 
+// Must only be called from the ADC ISR
 static inline void
-handle_completed_conversion(adc* adc0)
+complete_measurement(adc* adc0)
 {
-  if (adc0 != NULL && adc0->samples_remaining == 0) {
-    // We have enough samples for a full measurement
-    set_value(adc0);
-    adc0->next_value = 0;
-    reset_samples_remaining(adc0);
-    if (adc0->process != NULL) {
-      process_post_event(adc0->process, ADC_MEASUREMENT_COMPLETED,
-			 (process_data_t)adc0);
+  set_value(adc0);
+  adc0->next_value = 0;
+  reset_samples_remaining(adc0);
+
+  adc_group* g = adc0->group;
+  if (g == NULL) {
+    process_publish_isr(&isr_queue, &adc_measurement_topic,
+			bv8(adc_get_channel(adc0)), (process_data_t)adc0);
+    return;
+  }
+
+  // The sequence number is odd from the completion of the first member until
+  // that of the last one
+  if (g->adcs == adc0) {
+    g->seq += 1;
+  }
+  if (adc0->group_next == NULL) {
+    g->seq += 1;
+    if (g->p != NULL) {
+      process_post_isr_event(&isr_queue, g->p, ADC_GROUP_COMPLETED,
+			     (process_data_t)g);
     }
   }
 }
 
-PROCESS_THREAD(adc_process)
+
+static inline bool
+is_triggered(adc_capture* c, uint16_t sample)
 {
-  PROCESS_BEGIN();
+  switch (c->trigger) {
+  case ADC_CAPTURE_TRIGGER_RISING:
+    return c->count >= 2 && c->previous < c->level && sample >= c->level;
+  case ADC_CAPTURE_TRIGGER_FALLING:
+    return c->count >= 2 && c->previous >= c->level && sample < c->level;
+  default:
+    return true;
+  }
+}
 
-  while(true) {
-    PROCESS_WAIT_EVENT();
+// Must only be called from the ADC ISR
+static inline void
+add_capture_sample(adc_capture* c, uint16_t sample)
+{
+  c->buf[c->head] = sample;
+  c->head += 1;
+  if (c->head == c->size) {
+    c->head = 0;
+  }
+  if (c->count < c->size) {
+    c->count += 1;
+  }
 
-    fill_sample_buffer();
-    if (ev == EVENT_ADC_CONVERSION_COMPLETE) {
-      handle_completed_conversion((adc*)data);
+  if (c->state == ADC_CAPTURE_ARMED) {
+    if (c->count > c->pre_trigger && is_triggered(c, sample)) {
+      c->state = ADC_CAPTURE_TRIGGERED;
+      c->remaining = c->size - c->pre_trigger - 1;
     }
+  } else {
+    c->remaining -= 1;
   }
+  c->previous = sample;
 
-  PROCESS_END();
+  if (c->state == ADC_CAPTURE_TRIGGERED && c->remaining == 0) {
+    c->state = ADC_CAPTURE_COMPLETE;
+    capture = NULL;
+    if (c->p != NULL) {
+      process_post_isr_event(&isr_queue, c->p, ADC_CAPTURE_COMPLETED,
+			     (process_data_t)c);
+    }
+  }
 }
 
 
+// Must only be called from the ADC ISR
+static inline void
+add_sample(adc* adc, uint16_t sample)
+{
+  adc_trip* trip = adc->trip;
+  if (trip != NULL && sample > trip->limit && ! trip->tripped) {
+    trip->tripped = true;
+    trip->f(adc, trip->ptr);
+  }
+  adc->next_value += sample;
+  adc->samples_remaining -= 1;
+  if (adc->samples_remaining == 0) {
+    // We have enough samples for a full measurement
+    complete_measurement(adc);
+  }
+}
+
+// Samples are accumulated here, so the scheduler is only involved once per
+// measurement instead of once per conversion.
 INTERRUPT(ADC_CONVERSION_COMPLETE_VECT)
 {
+  uint8_t state = quiet_state;
+  if (state >= QUIET_STOPPING) {
+    // The free-running pipeline is stopped
+    if (state == QUIET_CONVERTING && quiet_adc->samples_remaining > 0) {
+      add_sample(quiet_adc, ADC_GET_VALUE());
+    }
+    quiet_state = QUIET_STOPPED;
+    return;
+  }
+
   uint8_t current = sample_buffer_head;
   uint8_t count = sample_buffer_count;
 
@@ -353,21 +1037,22 @@ INTERRUPT(ADC_CONVERSION_COMPLETE_VECT)
 
   // Read sample from completed conversion
   adc* current_adc = sample_buffer[current];
-  if (current_adc != NULL) {
+  if (current_adc == &capture_slot) {
+    // Captures that have been stopped or completed are no longer running
+    if (capture_discard > 0) {
+      capture_discard -= 1;
+    } else if (capture_is_running(capture)) {
+      add_capture_sample(capture, ADC_GET_VALUE());
+    }
+    sample_buffer[current] = NULL;
+  } else if (current_adc != NULL) {
+    // ADCs that have been disabled have no samples remaining
     if (current_adc->samples_remaining > 0) {
-      uint16_t sample = ADC_GET_VALUE();
-      current_adc->next_value += sample;
-      current_adc->samples_remaining -= 1;      
-    } else {
-      current_adc = NULL;
+      add_sample(current_adc, ADC_GET_VALUE());
     }
     sample_buffer[current] = NULL;
   }
 
-  // Notify the ADC process that a sample has been taken
-  process_post_event(&adc_process, EVENT_ADC_CONVERSION_COMPLETE,
-		     (process_data_t)current_adc);
-
   // Shift the queue, but make sure we keep a window of at least 2 entries
   if (count > 2) {
     count = count - 1;
@@ -376,4 +1061,11 @@ INTERRUPT(ADC_CONVERSION_COMPLETE_VECT)
 
   sample_buffer_count = count;
   sample_buffer_head = current;
+
+  // Queue the ADCs to sample next
+  if (state == QUIET_DRAINING) {
+    drain_sample_buffer();
+  } else {
+    fill_sample_buffer();
+  }
 }
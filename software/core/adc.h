@@ -34,10 +34,48 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "core/adc_filter.h"
 #include "core/process.h"
 #include "hal/adc.h"
 #include "util/int.h"
 
+#ifndef F_CPU
+#warning "F_CPU not defined in adc.h!"
+#endif
+
+/**
+ * Number of conversions per second of the free-running ADC, which runs at
+ * F_CPU/64 and takes 13 ADC clock cycles per conversion.
+ */
+#define ADC_CONVERSION_RATE (F_CPU / 64 / 13)
+
+/**
+ * Number of CPU clock cycles between two samples of a running capture (see
+ * adc_capture_init()), i.e. two free-running conversions.
+ */
+#define ADC_CAPTURE_SAMPLE_PERIOD (2 * 64 * 13)
+
+/**
+ * Number of samples per second of a running capture.
+ */
+#define ADC_CAPTURE_SAMPLE_RATE (ADC_CONVERSION_RATE / 2)
+
+/**
+ * Number of conversion slots in the schedule of ADC measurements with a
+ * target rate (see adc_set_rate()). Each slot corresponds to
+ * ADC_CONVERSION_RATE/ADC_CONF_FRAME_SIZE conversions per second. The
+ * schedule is double buffered, so it takes 2*ADC_CONF_FRAME_SIZE pointers of
+ * RAM.
+ */
+#ifndef ADC_CONF_FRAME_SIZE
+#define ADC_CONF_FRAME_SIZE 32
+#endif
+
+#if ADC_CONF_FRAME_SIZE > 128 || \
+  (ADC_CONF_FRAME_SIZE & (ADC_CONF_FRAME_SIZE - 1)) != 0
+#error "ADC_CONF_FRAME_SIZE must be a power of 2 of at most 128"
+#endif
+
 typedef enum {
   ADC_RESOLUTION_10BIT = 0,
   ADC_RESOLUTION_11BIT,
@@ -57,18 +95,87 @@ typedef enum {
 } adc_skip;
 
 
+struct adc;
+
+/**
+ * Function called from the ADC ISR when an ADC trips.
+ */
+typedef void (*adc_trip_callback)(struct adc* adc, void* ptr);
+
+/**
+ * A raw sample threshold on an ADC. A sample above the limit trips it, and it
+ * then stays tripped until it is rearmed, so its callback runs only once.
+ */
+struct adc_trip {
+  uint16_t limit;
+  adc_trip_callback f;
+  void* ptr;
+  volatile bool tripped;
+};
+typedef struct adc_trip adc_trip;
+
+struct adc_group;
+
 struct adc {
-  uint16_t value;
+  volatile uint16_t value;
   volatile uint24_t next_value;
   adc_channel channel;
   adc_resolution resolution;
   uint16_t samples_remaining;
   adc_skip skip;
-  process* process;
+  uint8_t slots; // Reserved slots per frame, 0 if the ADC has no target rate
+  adc_filter* filters;
+  adc_trip* trip;
+  struct adc_group* group;
+  struct adc* group_next; // Next member of the group, in conversion order
+  bool noise_reduction;
   struct adc* next;
 };
 typedef struct adc adc;
 
+/**
+ * A set of ADC measurements that are converted back-to-back and completed
+ * together. The sequence number is odd while the ADC ISR is updating the
+ * values of the members.
+ */
+struct adc_group {
+  adc* adcs;
+  process* p;
+  volatile uint8_t seq;
+};
+typedef struct adc_group adc_group;
+
+
+typedef enum {
+  ADC_CAPTURE_TRIGGER_NONE,
+  ADC_CAPTURE_TRIGGER_RISING,
+  ADC_CAPTURE_TRIGGER_FALLING,
+} adc_capture_trigger;
+
+typedef enum {
+  ADC_CAPTURE_IDLE,
+  ADC_CAPTURE_ARMED,
+  ADC_CAPTURE_TRIGGERED,
+  ADC_CAPTURE_COMPLETE,
+} adc_capture_state;
+
+struct adc_capture {
+  adc_channel channel;
+  adc_capture_trigger trigger;
+  uint16_t level;
+  uint16_t* buf;
+  uint16_t size;
+  uint16_t pre_trigger;
+  process* p;
+  // Only modified by the ADC ISR while the capture is running
+  volatile adc_capture_state state;
+  uint16_t head;
+  uint16_t count;
+  uint16_t remaining;
+  uint16_t previous;
+};
+typedef struct adc_capture adc_capture;
+
 
 typedef enum {
   ADC_INIT_OK,
@@ -79,6 +186,47 @@ typedef enum {
 } adc_init_status;
 
 
+typedef enum {
+  ADC_SET_RATE_OK,
+  ADC_SET_RATE_ENABLED,
+  ADC_SET_RATE_TOO_HIGH,
+  ADC_SET_RATE_IN_GROUP,
+  ADC_SET_RATE_NOISE_REDUCTION,
+} adc_set_rate_status;
+
+
+typedef enum {
+  ADC_GROUP_ADD_OK,
+  ADC_GROUP_ADD_ENABLED,
+  ADC_GROUP_ADD_ALREADY_IN_GROUP,
+  ADC_GROUP_ADD_RESOLUTION_MISMATCH,
+  ADC_GROUP_ADD_HAS_RATE,
+  ADC_GROUP_ADD_NOISE_REDUCTION,
+} adc_group_add_status;
+
+
+typedef enum {
+  ADC_CAPTURE_INIT_OK,
+  ADC_CAPTURE_INIT_INVALID_CHANNEL,
+  ADC_CAPTURE_INIT_INVALID_BUFFER,
+  ADC_CAPTURE_INIT_INVALID_PRE_TRIGGER,
+} adc_capture_init_status;
+
+
+/**
+ * Topic to which the ADC module publishes an ADC_MEASUREMENT_COMPLETED message
+ * whenever a new measurement is available. Each message is tagged with the bit
+ * of its ADC channel, so processes can subscribe to a subset of the channels.
+ * The message data is a pointer to the ADC structure.
+ *
+ * Samples are accumulated by the ADC interrupt service routine, which only
+ * publishes a message when a full measurement has been taken. Messages are
+ * posted through an ISR queue, so subscribers are notified with some delay and
+ * the value of the ADC may already have been updated with a later measurement
+ * by the time they read it.
+ */
+extern process_topic adc_measurement_topic;
+
 /**
  * Initialize the ADC module.
  */
@@ -92,8 +240,6 @@ void init_adc(void);
  * @param channel     The ADC channel to measure
  * @param resolution  The ADC resolution to achieve using oversampling
  * @param skip        The number of sample slots to skip each period
- * @param process     The process to notify when a new measurement is
- *                    available (can be NULL)
  * @return ADC_INIT_OK if the structure was initialized successfully, 
  *         ADC_INIT_ALREADY_IN_LIST if the specified ADC structure is already
  *         enabled, ADC_INIT_INVALID_CHANNEL if the specified channel is
@@ -103,8 +249,148 @@ void init_adc(void);
  */
 adc_init_status
 adc_init(adc* adc, adc_channel channel, adc_resolution resolution,
-	 adc_skip skip, process* process); 
+	 adc_skip skip);
+
+
+/**
+ * Set the target measurement rate of an ADC measurement.
+ *
+ * By default, ADC measurements have no target rate. They take turns in the
+ * conversion slots that are not reserved, sampling each ADC once per period
+ * unless its skip mask says otherwise.
+ *
+ * An ADC measurement with a target rate instead gets enough reserved slots in
+ * a fixed frame of ADC_CONF_FRAME_SIZE conversions to be measured at least
+ * that often. The reserved slots are spread evenly over the frame, so picking
+ * the ADC to sample next takes constant time. The skip mask of an ADC with a
+ * target rate is ignored. If the enabled ADCs reserve more slots than there
+ * are in the frame, each of them gets a proportional share, and
+ * adc_rates_fit() returns false.
+ *
+ * @param adc  The ADC measurement structure of which to set the target rate
+ * @param rate The target number of measurements per second, or 0 to remove
+ *             the target rate
+ * @return ADC_SET_RATE_OK if the target rate was set successfully,
+ *         ADC_SET_RATE_ENABLED if the ADC measurement is enabled,
+ *         ADC_SET_RATE_TOO_HIGH if the rate needs more conversions per
+ *         second than ADC_CONVERSION_RATE at the ADC's resolution,
+ *         ADC_SET_RATE_IN_GROUP if the ADC measurement is a member of a
+ *         group, or ADC_SET_RATE_NOISE_REDUCTION if it is converted from
+ *         noise reduction sleep.
+ */
+adc_set_rate_status adc_set_rate(adc* adc, uint16_t rate);
+
+/**
+ * Returns whether the target rates of the enabled ADC measurements fit within
+ * ADC_CONVERSION_RATE.
+ *
+ * ADC measurements without a target rate only use the slots that are left, so
+ * they do not count towards the budget. They are not sampled at all if all
+ * slots are reserved.
+ *
+ * @return true if all enabled ADC measurements with a target rate get the
+ *         number of slots they need, false otherwise.
+ */
+bool adc_rates_fit(void);
+
+/**
+ * Initialize an ADC trip structure.
+ *
+ * @param trip  The trip structure to initialize
+ * @param limit The raw 10-bit sample value above which the trip fires
+ * @param f     The function to call from the ADC ISR when the trip fires
+ * @param ptr   Opaque pointer passed to the callback function
+ */
+void adc_trip_init(adc_trip* trip, uint16_t limit, adc_trip_callback f,
+		   void* ptr);
+
+/**
+ * Set the trip of an ADC measurement.
+ *
+ * The raw samples of the ADC are compared against the trip's limit in the ADC
+ * ISR, before they are averaged. A sample above the limit calls the trip's
+ * callback right away, so it can take protective action without waiting for
+ * the measurement to complete and for a process to handle it. The callback
+ * runs in the ADC ISR, so it should be short. Because conversions are
+ * pipelined, a sample is read out two conversions (about 100 us) after its
+ * channel was selected.
+ *
+ * @param adc  The ADC measurement structure of which to set the trip
+ * @param trip An initialized trip structure, or NULL to remove the trip
+ * @return true if the trip was set successfully, false if the ADC measurement
+ *         is enabled.
+ */
+bool adc_set_trip(adc* adc, adc_trip* trip);
+
+/**
+ * Returns whether an ADC trip has fired since it was initialized or rearmed.
+ *
+ * @param trip The trip structure
+ * @return true if the trip has fired, false otherwise.
+ */
+bool adc_trip_is_tripped(adc_trip* trip);
 
+/**
+ * Rearm an ADC trip that has fired.
+ *
+ * @param trip The trip structure to rearm
+ */
+void adc_trip_rearm(adc_trip* trip);
+
+/**
+ * Mark an ADC measurement as precision-critical.
+ *
+ * A precision-critical ADC measurement is not sampled by the free-running
+ * conversions. Instead, adc_sleep_idle() converts it from ADC noise reduction
+ * sleep, which stops the CPU and I/O clocks during the conversion, so each
+ * sample has more effective bits and the measurement needs fewer of them.
+ * Such measurements are therefore only sampled while the MCU is idle, and only
+ * if adc_sleep_idle() is installed as the idle hook.
+ *
+ * @param adc             The ADC measurement structure to mark
+ * @param noise_reduction true to convert the ADC measurement from noise
+ *                        reduction sleep, false to sample it normally
+ * @return true if the mode was set successfully, false if the ADC measurement
+ *         is enabled, is a member of a group or has a target rate.
+ */
+bool adc_set_noise_reduction(adc* adc, bool noise_reduction);
+
+/**
+ * Idle hook that converts precision-critical ADC measurements from ADC noise
+ * reduction sleep (see process_set_idle_hook()).
+ *
+ * If there are enabled precision-critical measurements, the hook lets the
+ * conversions that are already queued complete, stops the free-running
+ * conversions and takes one sample of the next precision-critical measurement
+ * in noise reduction sleep. Free-running operation resumes before the hook
+ * returns. The timers that run from the I/O clock are halted during the
+ * sleeping conversion, so the hook advances the clock by the conversion time
+ * afterwards (see clock_advance()).
+ *
+ * The hook behaves like the default idle hook if there are no enabled
+ * precision-critical measurements, or if halting the I/O clock would delay
+ * other work: when events or poll requests are pending, when the SPI master is
+ * busy, when an rtimer is scheduled, when an event timer expires within one
+ * conversion time or when a capture is running. These conditions are checked
+ * again after the queued conversions have completed, in which case the hook
+ * returns without converting.
+ */
+void adc_sleep_idle(void);
+
+/**
+ * Add a filter stage to an ADC measurement.
+ *
+ * Each completed measurement is passed through the ADC's filter stages in the
+ * order in which they were added, before it becomes available through
+ * adc_get_value(). The stages run in the ADC ISR. Their history is reset
+ * whenever the ADC measurement is enabled.
+ *
+ * @param adc The ADC measurement structure to which to add the stage
+ * @param f   An initialized filter stage that is not used by any other ADC
+ * @return true if the stage was added successfully, false if the ADC
+ *         measurement is enabled.
+ */
+bool adc_add_filter(adc* adc, adc_filter* f);
 
 /**
  * Returns the channel of an ADC measurement structure.
@@ -138,11 +424,171 @@ bool adc_disable(adc* adc);
  * Although the accuracy of the measurement depends on the number of
  * configured oversamples, the measurement is always returned as a 16-bit
  * value. If the accuracy is less than 16 bits, some of the least significant
- * bits will be zero.
+ * bits will be zero. The measurement has passed through the ADC's filter
+ * stages, if any.
  *
  * @param adc The ADC structure of which to return the latest measurement
  * @return The latest measurement of the specified ADC channel.
  */
 uint16_t adc_get_value(adc* adc);
 
+
+/**
+ * Initialize an ADC group structure.
+ *
+ * The members of a group are converted back-to-back, one sample of each in
+ * the order in which they were added, whenever the group gets a conversion
+ * slot. All members have the same resolution, so their measurements are
+ * taken over the same interval and complete together. Instead of publishing
+ * one ADC_MEASUREMENT_COMPLETED message per member, the group posts a single
+ * ADC_GROUP_COMPLETED event when the last member completes.
+ *
+ * While a capture is running, a capture slot is interleaved between each two
+ * members, to keep the capture samples evenly spaced (see adc_capture_init()).
+ * The samples of consecutive members are then two conversions apart instead
+ * of one, which doubles the skew between them.
+ *
+ * The first member is scheduled like a normal ADC measurement without a
+ * target rate, using its skip mask. The skip masks of the other members are
+ * ignored.
+ *
+ * @param g The group structure to initialize
+ * @param p Process to notify with an ADC_GROUP_COMPLETED event whenever a new
+ *          set of measurements is available, or NULL
+ */
+void adc_group_init(adc_group* g, process* p);
+
+/**
+ * Add an ADC measurement to a group.
+ *
+ * A group member must only be enabled and disabled through its group.
+ *
+ * @param g   The group to which to add the ADC measurement
+ * @param adc An initialized ADC measurement structure
+ * @return ADC_GROUP_ADD_OK if the ADC measurement was added successfully,
+ *         ADC_GROUP_ADD_ENABLED if the group or the ADC measurement is
+ *         enabled, ADC_GROUP_ADD_ALREADY_IN_GROUP if the ADC measurement is
+ *         already a member of a group, ADC_GROUP_ADD_RESOLUTION_MISMATCH if
+ *         its resolution differs from that of the other members,
+ *         ADC_GROUP_ADD_HAS_RATE if it has a target rate, or
+ *         ADC_GROUP_ADD_NOISE_REDUCTION if it is converted from noise
+ *         reduction sleep.
+ */
+adc_group_add_status adc_group_add(adc_group* g, adc* adc);
+
+/**
+ * Enable all members of an ADC group.
+ *
+ * The members are enabled atomically, so their measurements start at the same
+ * conversion slot.
+ *
+ * @param g The group to enable
+ * @return true if the group was enabled successfully, false if it was already
+ *         enabled or has no members.
+ */
+bool adc_group_enable(adc_group* g);
+
+/**
+ * Disable all members of an ADC group.
+ *
+ * @param g The group to disable
+ * @return true if the group was disabled successfully, false if it was
+ *         already disabled.
+ */
+bool adc_group_disable(adc_group* g);
+
+/**
+ * Copies the latest measurements of all members of a group.
+ *
+ * The measurements all come from the same completed set, even if the ADC ISR
+ * completes a new set while they are being copied.
+ *
+ * @param g      The group of which to return the latest measurements
+ * @param values Buffer with room for one value per member, which receives the
+ *               values in the order in which the members were added
+ * @return The number of members
+ */
+uint8_t adc_group_get_values(adc_group* g, uint16_t* values);
+
+
+/**
+ * Initialize an ADC capture structure.
+ *
+ * A capture takes raw 10-bit samples of a single channel, without averaging,
+ * into a ring buffer. While a capture is running, it gets every other
+ * conversion slot, so it samples at half of the free-running conversion rate
+ * (ADC_CAPTURE_SAMPLE_RATE) while the enabled ADC measurements continue at
+ * half of their normal rate. The samples are always evenly spaced, one
+ * ADC_CAPTURE_SAMPLE_PERIOD apart, even if no ADC measurements are enabled or
+ * if measurements are enabled or disabled during the capture. The capture
+ * slots are also interleaved with the members of ADC groups.
+ *
+ * Samples are stored continuously until the trigger condition is met, after
+ * which the remainder of the buffer is filled. The trigger is only checked
+ * once at least pre_trigger samples have been stored, so the completed buffer
+ * always holds exactly pre_trigger samples from before the trigger sample.
+ *
+ * @param c           The capture structure to initialize
+ * @param channel     The ADC channel to capture
+ * @param trigger     The trigger condition. ADC_CAPTURE_TRIGGER_NONE triggers
+ *                    as soon as the pre-trigger samples have been stored.
+ * @param level       The sample value a rising or falling edge must cross
+ * @param buf         Buffer for the samples
+ * @param size        Number of samples in the buffer
+ * @param pre_trigger Number of samples to keep from before the trigger, must
+ *                    be smaller than size
+ * @param p           Process to notify with an ADC_CAPTURE_COMPLETED event
+ *                    when the capture is complete, or NULL
+ * @return ADC_CAPTURE_INIT_OK if the structure was initialized successfully,
+ *         ADC_CAPTURE_INIT_INVALID_CHANNEL if the specified channel is
+ *         invalid, ADC_CAPTURE_INIT_INVALID_BUFFER if the buffer is NULL or
+ *         empty, or ADC_CAPTURE_INIT_INVALID_PRE_TRIGGER if pre_trigger is
+ *         not smaller than size.
+ */
+adc_capture_init_status
+adc_capture_init(adc_capture* c, adc_channel channel,
+		 adc_capture_trigger trigger, uint16_t level, uint16_t* buf,
+		 uint16_t size, uint16_t pre_trigger, process* p);
+
+/**
+ * Start a capture.
+ *
+ * Only one capture can be running at a time. The first two capture slots after
+ * starting are discarded, because they may still have sampled the channel of
+ * a previous capture.
+ *
+ * @param c The capture to start
+ * @return true if the capture was started, false if another capture is
+ *         already running.
+ */
+bool adc_capture_start(adc_capture* c);
+
+/**
+ * Stop a running capture before it is complete.
+ *
+ * @param c The capture to stop
+ * @return true if the capture was stopped, false if it was not running.
+ */
+bool adc_capture_stop(adc_capture* c);
+
+/**
+ * Returns the state of a capture.
+ *
+ * @param c The capture of which to return the state
+ * @return The state of the specified capture
+ */
+adc_capture_state adc_capture_get_state(adc_capture* c);
+
+/**
+ * Returns a sample of a completed capture.
+ *
+ * Samples are indexed in chronological order, so the trigger sample has
+ * index pre_trigger.
+ *
+ * @param c The completed capture
+ * @param i The index of the sample, smaller than the size of the buffer
+ * @return The sample with the specified index
+ */
+uint16_t adc_capture_get_sample(adc_capture* c, uint16_t i);
+
 #endif
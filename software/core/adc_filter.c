@@ -0,0 +1,213 @@
+/*
+ * adc_filter.c
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file adc_filter.c
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ */
+
+#include "adc_filter.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+static void
+init(adc_filter* f, adc_filter_type type, uint8_t param, uint16_t* window)
+{
+  f->type = type;
+  f->param = param;
+  f->window = window;
+  f->next = NULL;
+  adc_filter_reset(f);
+}
+
+adc_filter_init_status
+adc_filter_iir_init(adc_filter* f, uint8_t shift)
+{
+  if (shift < 1 || shift > ADC_FILTER_IIR_MAX_SHIFT) {
+    return ADC_FILTER_INIT_INVALID_PARAMETER;
+  }
+
+  init(f, ADC_FILTER_IIR, shift, NULL);
+  return ADC_FILTER_INIT_OK;
+}
+
+adc_filter_init_status
+adc_filter_median_init(adc_filter* f, uint16_t* window, uint8_t taps)
+{
+  if (taps != 3 && taps != 5) {
+    return ADC_FILTER_INIT_INVALID_PARAMETER;
+  }
+  if (window == NULL) {
+    return ADC_FILTER_INIT_INVALID_BUFFER;
+  }
+
+  init(f, ADC_FILTER_MEDIAN, taps, window);
+  return ADC_FILTER_INIT_OK;
+}
+
+adc_filter_init_status
+adc_filter_moving_average_init(adc_filter* f, uint16_t* window,
+			       uint8_t log2_length)
+{
+  if (log2_length < 1 ||
+      log2_length > ADC_FILTER_MOVING_AVERAGE_MAX_LOG2_LENGTH) {
+    return ADC_FILTER_INIT_INVALID_PARAMETER;
+  }
+  if (window == NULL) {
+    return ADC_FILTER_INIT_INVALID_BUFFER;
+  }
+
+  init(f, ADC_FILTER_MOVING_AVERAGE, log2_length, window);
+  return ADC_FILTER_INIT_OK;
+}
+
+void adc_filter_reset(adc_filter* f)
+{
+  f->primed = false;
+  f->pos = 0;
+  f->acc = 0;
+}
+
+
+static inline uint16_t
+apply_iir(adc_filter* f, uint16_t x)
+{
+  uint8_t shift = f->param;
+  if (! f->primed) {
+    f->acc = (uint32_t)x << shift;
+  } else {
+    // acc holds the output scaled by 2^shift, so the fraction is not lost
+    f->acc = f->acc - (f->acc >> shift) + x;
+  }
+  return f->acc >> shift;
+}
+
+static inline void
+swap_if_greater(uint16_t* a, uint16_t* b)
+{
+  if (*a > *b) {
+    uint16_t tmp = *a;
+    *a = *b;
+    *b = tmp;
+  }
+}
+
+static inline uint16_t
+median3(uint16_t a, uint16_t b, uint16_t c)
+{
+  swap_if_greater(&a, &b);
+  swap_if_greater(&b, &c);
+  swap_if_greater(&a, &b);
+  return b;
+}
+
+static inline uint16_t
+median5(const uint16_t* w)
+{
+  uint16_t a = w[0], b = w[1], c = w[2], d = w[3], e = w[4];
+  // The lowest of the first four values is below at least three others, so it
+  // cannot be the median. Replace it by e.
+  swap_if_greater(&a, &b);
+  swap_if_greater(&c, &d);
+  if (a < c) {
+    a = e;
+    swap_if_greater(&a, &b);
+  } else {
+    c = e;
+    swap_if_greater(&c, &d);
+  }
+  // The median is now the second lowest of the four remaining values
+  if (a < c) {
+    return (b < c) ? b : c;
+  } else {
+    return (d < a) ? d : a;
+  }
+}
+
+static inline uint16_t
+apply_median(adc_filter* f, uint16_t x)
+{
+  uint8_t taps = f->param;
+  uint8_t i;
+  if (! f->primed) {
+    for (i = 0; i < taps; ++i) {
+      f->window[i] = x;
+    }
+    return x;
+  }
+
+  f->window[f->pos] = x;
+  f->pos += 1;
+  if (f->pos == taps) {
+    f->pos = 0;
+  }
+
+  if (taps == 3) {
+    return median3(f->window[0], f->window[1], f->window[2]);
+  } else {
+    return median5(f->window);
+  }
+}
+
+static inline uint16_t
+apply_moving_average(adc_filter* f, uint16_t x)
+{
+  uint8_t log2_length = f->param;
+  uint8_t length = 1 << log2_length;
+  uint8_t i;
+  if (! f->primed) {
+    for (i = 0; i < length; ++i) {
+      f->window[i] = x;
+    }
+    f->acc = (uint32_t)x << log2_length;
+    return x;
+  }
+
+  // Keep a running sum instead of adding up the entire window every time
+  f->acc = f->acc - f->window[f->pos] + x;
+  f->window[f->pos] = x;
+  f->pos = (f->pos + 1) & (length - 1);
+  return f->acc >> log2_length;
+}
+
+uint16_t adc_filter_apply(adc_filter* f, uint16_t x)
+{
+  uint16_t y;
+  switch (f->type) {
+  case ADC_FILTER_IIR:
+    y = apply_iir(f, x);
+    break;
+  case ADC_FILTER_MEDIAN:
+    y = apply_median(f, x);
+    break;
+  case ADC_FILTER_MOVING_AVERAGE:
+    y = apply_moving_average(f, x);
+    break;
+  default:
+    y = x;
+    break;
+  }
+  f->primed = true;
+  return y;
+}
@@ -0,0 +1,132 @@
+/*
+ * adc_filter.h
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_ADC_FILTER_H
+#define CORE_ADC_FILTER_H
+
+/**
+ * @file adc_filter.h
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ *
+ * Integer filter stages for ADC measurements.
+ *
+ * A filter stage takes one 16-bit value per completed measurement and
+ * produces one filtered 16-bit value, so stages can be chained. The first
+ * value after initialization or a reset primes the stage's entire history,
+ * so a stage does not have to settle from zero.
+ *
+ * Filtering is a cheaper way to get a steady reading than a higher ADC
+ * resolution, which takes four times as many conversions per extra bit.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ADC_FILTER_IIR_MAX_SHIFT 8
+#define ADC_FILTER_MOVING_AVERAGE_MAX_LOG2_LENGTH 6
+
+typedef enum {
+  ADC_FILTER_IIR,
+  ADC_FILTER_MEDIAN,
+  ADC_FILTER_MOVING_AVERAGE,
+} adc_filter_type;
+
+struct adc_filter {
+  adc_filter_type type;
+  // IIR: shift, median: number of taps, moving average: log2 of the length
+  uint8_t param;
+  bool primed;
+  uint8_t pos;
+  // IIR: output << shift, moving average: sum of the window
+  uint32_t acc;
+  uint16_t* window;
+  struct adc_filter* next;
+};
+typedef struct adc_filter adc_filter;
+
+
+typedef enum {
+  ADC_FILTER_INIT_OK,
+  ADC_FILTER_INIT_INVALID_PARAMETER,
+  ADC_FILTER_INIT_INVALID_BUFFER,
+} adc_filter_init_status;
+
+
+/**
+ * Initialize a single-pole IIR low-pass filter stage.
+ *
+ * Each value moves the output 1/2^shift of the way towards the input, which
+ * corresponds to a time constant of about 2^shift measurements.
+ *
+ * @param f     The filter stage to initialize
+ * @param shift The filter coefficient, between 1 and ADC_FILTER_IIR_MAX_SHIFT
+ * @return ADC_FILTER_INIT_OK if the stage was initialized successfully, or
+ *         ADC_FILTER_INIT_INVALID_PARAMETER if the shift is out of range.
+ */
+adc_filter_init_status
+adc_filter_iir_init(adc_filter* f, uint8_t shift);
+
+/**
+ * Initialize a median filter stage, to reject single spikes.
+ *
+ * @param f      The filter stage to initialize
+ * @param window A buffer of taps values
+ * @param taps   The number of taps, either 3 or 5
+ * @return ADC_FILTER_INIT_OK if the stage was initialized successfully,
+ *         ADC_FILTER_INIT_INVALID_PARAMETER if the number of taps is
+ *         invalid, or ADC_FILTER_INIT_INVALID_BUFFER if the window is NULL.
+ */
+adc_filter_init_status
+adc_filter_median_init(adc_filter* f, uint16_t* window, uint8_t taps);
+
+/**
+ * Initialize a moving average filter stage.
+ *
+ * @param f           The filter stage to initialize
+ * @param window      A buffer of 2^log2_length values
+ * @param log2_length Log2 of the number of values to average, between 1 and
+ *                    ADC_FILTER_MOVING_AVERAGE_MAX_LOG2_LENGTH
+ * @return ADC_FILTER_INIT_OK if the stage was initialized successfully,
+ *         ADC_FILTER_INIT_INVALID_PARAMETER if the length is out of range,
+ *         or ADC_FILTER_INIT_INVALID_BUFFER if the window is NULL.
+ */
+adc_filter_init_status
+adc_filter_moving_average_init(adc_filter* f, uint16_t* window,
+			       uint8_t log2_length);
+
+/**
+ * Reset a filter stage, so its history is primed again by the next value.
+ *
+ * @param f The filter stage to reset
+ */
+void adc_filter_reset(adc_filter* f);
+
+/**
+ * Pass a value through a single filter stage.
+ *
+ * @param f The filter stage
+ * @param x The value to filter
+ * @return The filtered value
+ */
+uint16_t adc_filter_apply(adc_filter* f, uint16_t x);
+
+#endif
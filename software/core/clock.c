@@ -27,17 +27,39 @@
 
 #include "clock.h"
 
+#include <stdbool.h>
 #include <util/atomic.h>
 
 #include "hal/interrupt.h"
 #include "util/int.h"
 
-#if TMR_SIZE(CLOCK_TMR) != 8
-#error "The clock currently only supports 8-bit timers."
+#define CNTR_BITS TMR_SIZE(CLOCK_TMR)
+
+#if CNTR_BITS == 8
+typedef uint24_t clock_upper_t;
+#else
+typedef uint16_t clock_upper_t;
 #endif
 
+static volatile clock_upper_t clock_upper;
 
-static volatile uint24_t clock_upper;
+// A 16-bit counter is read through the timer's TEMP register, which is shared
+// with every ISR that accesses a 16-bit register of the same timer. Such an
+// ISR could overwrite TEMP between the reads of the low and the high byte, so
+// interrupts are disabled during the read.
+static inline clock_cntr_t
+get_cntr(void)
+{
+#if CNTR_BITS == 16
+  clock_cntr_t cntr;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    cntr = TMR_GET_CNTR(CLOCK_TMR);
+  }
+  return cntr;
+#else
+  return TMR_GET_CNTR(CLOCK_TMR);
+#endif
+}
 
 void clock_init()
 {
@@ -51,26 +73,63 @@ void clock_init()
 }
 
 
-static clock_time_t previous = 0;
+// The upper part of the clock is read without disabling interrupts: if the
+// overflow interrupt changes it while the counter is being read, the read is
+// retried. Since the interrupt always changes the least significant byte of
+// the upper part, a torn read of a multi-byte upper part is detected as well.
+// This does not cover the counter itself, see get_cntr().
 clock_time_t clock_get_time()
 {
-  clock_time_t result;
-  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-    uint8_t cntr = TMR_GET_CNTR(CLOCK_TMR);
-    if (TMR_IS_INTERRUPT_FLAG_SET(CLOCK_TMR, OVF) && cntr == 0) {
-      // Timer has just overflowed and interrupt has not been handled yet
-      result = ((clock_time_t)(clock_upper + 1) << 8);
-    } else {
-      result = ((clock_time_t)clock_upper << 8) | cntr;
-    }
+  clock_upper_t upper;
+  clock_cntr_t cntr;
+  bool overflowed;
+  do {
+    upper = clock_upper;
+    cntr = get_cntr();
+    // When interrupts are disabled, the overflow interrupt may be pending. With
+    // a small prescaler, the counter may have advanced past 0 by now.
+    overflowed = TMR_IS_INTERRUPT_FLAG_SET(CLOCK_TMR, OVF) &&
+                 cntr <= TMR_MAX_VALUE(CLOCK_TMR) / 2;
+  } while (upper != clock_upper);
+
+  if (overflowed) {
+    upper += 1;
   }
+  return ((clock_time_t)upper << CNTR_BITS) | cntr;
+}
 
-  previous = result;
-  return result;
+
+clock_time_t clock_get_time_fast()
+{
+  clock_upper_t upper;
+  clock_cntr_t cntr;
+  do {
+    upper = clock_upper;
+    cntr = get_cntr();
+  } while (upper != clock_upper);
+
+  return ((clock_time_t)upper << CNTR_BITS) | cntr;
+}
+
+
+void clock_advance(clock_cntr_t ticks)
+{
+  clock_cntr_t cntr = TMR_GET_CNTR(CLOCK_TMR);
+  clock_cntr_t advanced = cntr + ticks;
+  TMR_SET_CNTR(CLOCK_TMR, advanced);
+  if (advanced < cntr) {
+    // The overflow is counted here. If the counter overflowed by itself just
+    // after it was read, the pending interrupt would count it a second time.
+    if (cntr == TMR_MAX_VALUE(CLOCK_TMR)) {
+      TMR_CLEAR_INTERRUPT_FLAG(CLOCK_TMR, OVF);
+    }
+    clock_upper += 1;
+  }
 }
 
 
-// This interrupt takes 46 cycles when clock_upper is 24-bits wide
+// This interrupt takes 46 cycles when clock_upper is 24-bits wide, and less
+// when it is 16-bits wide
 INTERRUPT(TMR_INTERRUPT_VECT(CLOCK_TMR, OVF))
 {
   clock_upper += 1;
@@ -29,7 +29,17 @@
  *
  * The clock is a monotic counter that is incremented periodically. It can be
  * used as a reference for short to medium periods of time (it overflows every
- * 19 hours at an MCU clock speed of 16MHz)
+ * 19 hours at an MCU clock speed of 16MHz with the default configuration)
+ *
+ * The lower bits of the clock are the counter of a hardware timer, the upper
+ * bits are counted in software on every timer overflow. By default, the clock
+ * runs on the 8-bit TIMER0 with a prescaler of 256. It can also run on the
+ * 16-bit TIMER1 with a smaller prescaler, which gives a finer resolution at a
+ * lower overflow interrupt rate. For example, with CLOCK_CONF_TMR set to
+ * TIMER1 and CLOCK_CONF_TMR_PRESCALER set to 8, the clock ticks every 0.5 us
+ * and overflows every 36 minutes, while the overflow interrupt only fires
+ * every 33 ms instead of every 4 ms. That configuration can share TIMER1 with
+ * the PROCESS_STATS run time measurements, which also use a prescaler of 8.
  */
 
 
@@ -43,8 +53,30 @@
 
 typedef uint32_t clock_time_t;
 
-#define CLOCK_TMR            TIMER0
-#define CLOCK_TMR_PRESCALER  256
+/**
+ * The hardware timer that drives the clock. Besides its overflow interrupt, its
+ * compare match channels are used by the io_monitor (OCA) and etimer (OCB)
+ * modules.
+ */
+#ifndef CLOCK_CONF_TMR
+#define CLOCK_CONF_TMR            TIMER0
+#endif
+
+#ifndef CLOCK_CONF_TMR_PRESCALER
+#define CLOCK_CONF_TMR_PRESCALER  256
+#endif
+
+#define CLOCK_TMR            CLOCK_CONF_TMR
+#define CLOCK_TMR_PRESCALER  CLOCK_CONF_TMR_PRESCALER
+
+// Type of the hardware part of the clock
+#if TMR_SIZE(CLOCK_TMR) == 8
+typedef uint8_t clock_cntr_t;
+#elif TMR_SIZE(CLOCK_TMR) == 16
+typedef uint16_t clock_cntr_t;
+#else
+#error "The clock timer must be an 8-bit or a 16-bit timer."
+#endif
 
 #define CLOCK_SEC    ((double)F_CPU/CLOCK_TMR_PRESCALER)  /** 1 second */
 #define CLOCK_MSEC   (CLOCK_SEC/1000.0)                   /** 1 millisecond */
@@ -64,10 +96,40 @@ void clock_init(void);
 /**
  * Return the current clock time.
  *
- * The clock ticks every 256 CPU clock cycles and hence overflows every 
- * (256 * 2^32)/F_CPU seconds. For F_CPU=16MHz, the clock ticks every 16 us
- * and overflows every 19 hours.
+ * The clock ticks every CLOCK_TMR_PRESCALER CPU clock cycles and hence
+ * overflows every (CLOCK_TMR_PRESCALER * 2^32)/F_CPU seconds. For F_CPU=16MHz
+ * and the default prescaler of 256, the clock ticks every 16 us and overflows
+ * every 19 hours.
+ *
+ * This function does not disable interrupts when the clock runs on an 8-bit
+ * timer. On a 16-bit timer, it disables them briefly while reading the
+ * counter. It can be called from any context, including interrupt service
+ * routines and atomic blocks.
  */
 clock_time_t clock_get_time(void);
 
+
+/**
+ * Return the current clock time, for callers that run with interrupts enabled.
+ *
+ * This is a cheaper variant of clock_get_time() that does not check for a
+ * pending overflow interrupt. It relies on that interrupt being handled as soon
+ * as the timer overflows, so it must not be called from interrupt service
+ * routines or from code that runs with interrupts disabled.
+ */
+clock_time_t clock_get_time_fast(void);
+
+
+/**
+ * Advance the clock by a number of ticks.
+ *
+ * This compensates for periods in which the clock timer was halted, such as
+ * ADC noise reduction sleep. The number of ticks must be much smaller than the
+ * range of the clock timer's counter. Must be called with interrupts
+ * disabled.
+ *
+ * @param ticks The number of ticks by which to advance the clock
+ */
+void clock_advance(clock_cntr_t ticks);
+
 #endif
@@ -28,83 +28,192 @@
 
 #include "etimer.h"
 
+#include <util/atomic.h>
+
 #include "core/events.h"
 #include "core/process.h"
 #include "core/timer.h"
+#include "hal/interrupt.h"
+#include "hal/timers.h"
+#include "util/log.h"
 
 PROCESS(etimer_process);
 
-static etimer* queue;
+// Binary min-heap of pending timers, ordered by expiration time
+static etimer* heap[ETIMER_CONF_MAX_PENDING];
+static uint8_t heap_size;
+
+// Expiration time of the first timer in the heap, checked by the compare match
+// interrupt
+static volatile clock_time_t next_expiration;
 
 void init_etimer(void)
 {
-  queue = NULL;
+  heap_size = 0;
+  TMR_INTERRUPT_DISABLE(CLOCK_TMR, OCB);
   process_start(&etimer_process);
 }
 
+// True iff the clock has reached the given time
+static inline bool
+reached(clock_time_t time)
+{
+  return (clock_time_t)(clock_get_time() - time) <= CLOCK_TIME_MAX / 2;
+}
+
+
+static inline clock_time_t
+expiration_time(etimer* t)
+{
+  return t->tmr.start + t->tmr.delay;
+}
+
+// Timers are compared by the difference between their expiration times, which
+// is correct across clock overflows as long as all pending timers expire
+// within CLOCK_TIME_MAX/2 ticks of each other.
+static inline bool
+expires_before(etimer* a, etimer* b)
+{
+  return (clock_time_t)(expiration_time(a) - expiration_time(b)) >
+    CLOCK_TIME_MAX / 2;
+}
+
+static inline bool
+is_pending(etimer* t)
+{
+  return t->heap_index < heap_size && heap[t->heap_index] == t;
+}
+
+static inline void
+place(etimer* t, uint8_t i)
+{
+  heap[i] = t;
+  t->heap_index = i;
+}
 
+// Move the timer at index i towards the root until the heap order holds
 static void
-remove_from_queue(etimer* t)
+sift_up(uint8_t i)
 {
-  etimer** pt = &queue;
-  while (*pt != NULL && *pt != t) {
-    pt = &((*pt)->next);
+  etimer* t = heap[i];
+  while (i > 0) {
+    uint8_t parent = (i - 1) / 2;
+    if (! expires_before(t, heap[parent])) {
+      break;
+    }
+    place(heap[parent], i);
+    i = parent;
   }
+  place(t, i);
+}
 
-  if (*pt == t) {
-    // Remove from queue
-    *pt = (*pt)->next;
+// Move the timer at index i towards the leaves until the heap order holds
+static void
+sift_down(uint8_t i)
+{
+  etimer* t = heap[i];
+  while (true) {
+    uint8_t child = 2 * i + 1;
+    if (child >= heap_size) {
+      break;
+    }
+    if (child + 1 < heap_size && expires_before(heap[child + 1], heap[child])) {
+      child += 1;
+    }
+    if (! expires_before(heap[child], t)) {
+      break;
+    }
+    place(heap[child], i);
+    i = child;
   }
+  place(t, i);
 }
 
-static inline
-void insert(etimer* t, etimer** pt)
+static void
+remove_from_heap(etimer* t)
 {
-  t->next = *pt;
-  *pt = t;
+  uint8_t i = t->heap_index;
+  heap_size -= 1;
+  if (i < heap_size) {
+    // Fill the hole with the last timer, which may have to move either way
+    etimer* last = heap[heap_size];
+    place(last, i);
+    sift_up(i);
+    sift_down(last->heap_index);
+  }
 }
 
-
-// Only call this function if you know that either t is not in the queue, or
-// that t can stay in the same position or needs to move backward in the queue.
+// Program the compare match interrupt to wake the etimer process when the
+// first timer expires. The compare match only involves the hardware part of
+// the clock, so it fires once every timer period until the timer has expired.
 static void
-insert_into_queue(etimer* t, clock_time_t now)
-{
-  clock_time_t remaining = etimer_remaining_at(t, now);
-
-  // Find appropriate location in queue
-  etimer** pt = &queue;
-  while (*pt != NULL && remaining >= etimer_remaining_at(*pt, now)) {
-    if (*pt == t) {
-      // Remove from queue
-      *pt = (*pt)->next;
-    } else {
-      pt = &((*pt)->next);
+arm(void)
+{
+  TMR_INTERRUPT_DISABLE(CLOCK_TMR, OCB);
+  if (heap_size == 0) {
+    return;
+  }
+
+  next_expiration = expiration_time(heap[0]);
+  if (! reached(next_expiration)) {
+#if TMR_SIZE(CLOCK_TMR) == 16
+    // The 16-bit write goes through the timer's TEMP register, which the
+    // clock's ISRs also use
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      TMR_SET_OCR(CLOCK_TMR, OCB, (clock_cntr_t)next_expiration);
+    }
+#else
+    TMR_SET_OCR(CLOCK_TMR, OCB, (clock_cntr_t)next_expiration);
+#endif
+    TMR_CLEAR_INTERRUPT_FLAG(CLOCK_TMR, OCB);
+    TMR_INTERRUPT_ENABLE(CLOCK_TMR, OCB);
+    if (! reached(next_expiration)) {
+      return;
     }
+    // The compare match may have been missed while programming it
+  }
+  process_poll(&etimer_process);
+}
+
+// Must be called after changing the expiration time of t
+static void
+schedule(etimer* t)
+{
+  etimer* first = (heap_size > 0) ? heap[0] : NULL;
+  if (is_pending(t)) {
+    sift_down(t->heap_index);
+    sift_up(t->heap_index);
+  } else if (heap_size < ETIMER_CONF_MAX_PENDING) {
+    place(t, heap_size);
+    heap_size += 1;
+    sift_up(t->heap_index);
+  } else {
+    LOG_COUNTER_INC(ETIMER_QUEUE_FULL);
+    return;
   }
 
-  // Insert at correct position in queue
-  insert(t, pt);
+  if (heap[0] == t || first == t) {
+    arm();
+  }
 }
 
 void etimer_set(etimer* t, clock_time_t delay, process* p)
 {
-  remove_from_queue(t);
   timer_set(&(t->tmr), delay);
   t->p = p;
-  insert_into_queue(t, t->tmr.start);
+  schedule(t);
 }
 
 void etimer_reset(etimer* t)
 {
   timer_reset(&(t->tmr));
-  insert_into_queue(t, clock_get_time());
+  schedule(t);
 }
 
 void etimer_restart(etimer* t)
 {
   timer_restart(&(t->tmr));
-  insert_into_queue(t, t->tmr.start);
+  schedule(t);
 }
 
 bool etimer_expired_at(etimer* t, clock_time_t time)
@@ -117,6 +226,11 @@ bool etimer_expired(etimer* t)
   return timer_expired(&(t->tmr));
 }
 
+bool etimer_is_due_within(clock_time_t delay)
+{
+  return heap_size != 0 && reached(expiration_time(heap[0]) - delay);
+}
+
 clock_time_t etimer_remaining(etimer* t)
 {
   return timer_remaining(&(t->tmr));
@@ -127,22 +241,39 @@ clock_time_t etimer_remaining_at(etimer* t, clock_time_t time)
   return timer_remaining_at(&(t->tmr), time);
 }
 
+INTERRUPT(TMR_INTERRUPT_VECT(CLOCK_TMR, OCB))
+{
+  if (reached(next_expiration)) {
+    TMR_INTERRUPT_DISABLE(CLOCK_TMR, OCB);
+    process_poll(&etimer_process);
+  }
+}
+
 PROCESS_THREAD(etimer_process)
 {
   PROCESS_BEGIN();
 
   while(true) {
-    PROCESS_YIELD();
+    // Only woken up when the first timer expires
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);
 
-    etimer* t = queue;
-    clock_time_t now = clock_get_time();
-    while (t != NULL && etimer_expired_at(t, now)) {
+    clock_time_t now = clock_get_time_fast();
+    while (heap_size > 0 && etimer_expired_at(heap[0], now)) {
+      etimer* t = heap[0];
       if (t->p != NULL) {
-	process_post_event(t->p, EVENT_TIMER_EXPIRED, (process_data_t)t);
+	// A timer event is late once another period has passed after expiring,
+	// which gives short timers a tight deadline.
+	clock_time_t deadline = t->tmr.start + 2 * t->tmr.delay;
+	if (process_post_deadline_event(t->p, EVENT_TIMER_EXPIRED,
+					(process_data_t)t, deadline)
+	    != PROCESS_POST_EVENT_OK) {
+	  // Keep the timer pending and try again next time
+	  break;
+	}
       }
-      t = t->next;
+      remove_from_heap(t);
     }
-    queue = t;
+    arm();
   }
 
   PROCESS_END();
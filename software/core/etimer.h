@@ -34,21 +34,39 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #include "core/clock.h"
 #include "core/timer.h"
 #include "core/process.h"
 
+/**
+ * Maximum number of event timers that can be pending at the same time. Pending
+ * timers are kept in a binary heap, so setting a timer and handling an expired
+ * timer take O(log n) time, and checking for expired timers takes O(1) time.
+ */
+#ifndef ETIMER_CONF_MAX_PENDING
+#define ETIMER_CONF_MAX_PENDING 16
+#endif
+
+#if ETIMER_CONF_MAX_PENDING > 255
+#error "ETIMER_CONF_MAX_PENDING must be at most 255"
+#endif
+
 struct etimer {
   timer tmr;
   process* p;
-  struct etimer* next;
+  uint8_t heap_index; // Only meaningful while the timer is pending
 };
 typedef struct etimer etimer;
 
 /**
  * Initialize the even timer module.
  *
+ * The etimer process only runs when the first pending timer expires. It is
+ * woken up by the OCB compare match interrupt of the clock timer, so this
+ * module must be the only user of that channel.
+ *
  * Modules that should be initialized first:
  *  * clock
  *  * process
@@ -60,7 +78,9 @@ void init_etimer(void);
  * Set an event timer to expire after a given delay.
  *
  * The specified delay should be significantly shorter than CLOCK_TIME_MAX, to
- * avoid the clock overflowing before the timer expiration can be detected.
+ * avoid the clock overflowing before the timer expiration can be detected. If
+ * ETIMER_CONF_MAX_PENDING other timers are already pending, the timer is not
+ * scheduled and the ETIMER_QUEUE_FULL log counter is incremented.
  *
  * @param t     The event timer to set
  * @param delay The delay in clock ticks after which the timer will expire
@@ -113,6 +133,16 @@ bool etimer_expired_at(etimer* t, clock_time_t time);
 bool etimer_expired(etimer* t);
 
 
+/**
+ * Return whether the first pending event timer expires within a given delay.
+ *
+ * @param delay The delay in clock ticks
+ * @return true if a pending event timer expires within the specified delay
+ *         or has already expired, false otherwise
+ */
+bool etimer_is_due_within(clock_time_t delay);
+
+
 /**
  * Return the time between a given moment and the moment the event timer
  * expires.
@@ -35,7 +35,7 @@
 enum {
   // Process
   PROCESS_EVENT_INIT = 0x80,
-  PROCESS_EVENT_CONTINUE,
+  PROCESS_EVENT_POLL,
 
   // SPI Master
   SPIM_TRX_COMPLETED_SUCCESSFULLY,
@@ -48,6 +48,8 @@ enum {
 
   // ADC
   ADC_MEASUREMENT_COMPLETED,
+  ADC_CAPTURE_COMPLETED,
+  ADC_GROUP_COMPLETED,
 
   // Event Timer
   EVENT_TIMER_EXPIRED,
@@ -37,23 +37,26 @@
 
 #define NB_PORTS 3
 
-PROCESS(event_dispatcher);
-
 #define READ_INTERVAL CLOCK_MSEC // Interrupt every millisecond
 
-#define INT_TO_PORT_CHANGED_EVENT(i) ((process_event_t)i)
-
-static iomon_event* iomon_event_list_head[NB_PORTS];
+// Pin changes of each port are published to the port's topic, tagged with the
+// bit vector of pins that changed.
+static process_topic port_topic[NB_PORTS];
 static uint8_t port_mask[NB_PORTS];
+static process_isr_queue isr_queue;
 
 void iomon_init()
 {
   for (uint8_t p = 0; p < NB_PORTS; ++p) {
-    iomon_event_list_head[p] = NULL;
+    process_topic_init(&port_topic[p]);
     port_mask[p] = 0x00;
   }
-  process_start(&event_dispatcher);
-  TMR_SET_OCR(CLOCK_TMR, OCA, READ_INTERVAL);
+  process_isr_queue_init(&isr_queue, PROCESS_EVENT_PRIORITY_NORMAL);
+  // A 16-bit write goes through the timer's TEMP register, which the clock's
+  // ISRs also use
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    TMR_SET_OCR(CLOCK_TMR, OCA, READ_INTERVAL);
+  }
   TMR_INTERRUPT_ENABLE(CLOCK_TMR, OCA); // Enable OCA interrupt
 }
 
@@ -66,29 +69,20 @@ iomon_event_init(iomon_event* e, iomon_port port, uint8_t mask,
   }
 
   e->port = port;
-  e->mask = mask;
-  e->process = p;
-  e->event = ev;
+  process_subscription_init(&e->subscription, p, ev, mask);
   return IOMON_EVENT_INIT_OK;
 }
 
 
 iomon_event_enable_status iomon_event_enable(iomon_event* e)
 {
-  iomon_event** ev = &iomon_event_list_head[e->port];
-  while (*ev != NULL && *ev != e) {
-    ev = &((*ev)->next);
-  }
-
-  if (*ev == e) {
+  if (! process_subscribe(&port_topic[e->port], &e->subscription)) {
     return IOMON_EVENT_ALREADY_ENABLED;
   }
 
-  *ev = e;
-  e->next = NULL;
   ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
     //TODO: check asm to see if this block is needed
-    port_mask[e->port] |= e->mask;
+    port_mask[e->port] |= e->subscription.mask;
   }
  
   return IOMON_EVENT_ENABLE_OK;
@@ -97,23 +91,14 @@ iomon_event_enable_status iomon_event_enable(iomon_event* e)
 
 iomon_event_disable_status iomon_event_disable(iomon_event* e)
 {
-  bool found = false;
-  uint8_t new_port_mask = 0x00;
-  iomon_event** ev = &iomon_event_list_head[e->port];
-  while (*ev != NULL) {
-    if (*ev == e) {
-      // Remove from list
-      *ev = e->next;
-      found = true;
-    } else {
-      new_port_mask |= (*ev)->mask;
-    
-      ev = &((*ev)->next);
-    }
+  process_topic* t = &port_topic[e->port];
+  if (! process_unsubscribe(t, &e->subscription)) {
+    return IOMON_EVENT_ALREADY_DISABLED;
   }
 
-  if (! found) {
-    return IOMON_EVENT_ALREADY_DISABLED;
+  uint8_t new_port_mask = 0x00;
+  for (process_subscription* s = t->subscribers; s != NULL; s = s->next) {
+    new_port_mask |= s->mask;
   }
 
   ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
@@ -150,32 +135,8 @@ INTERRUPT(TMR_INTERRUPT_VECT(CLOCK_TMR, OCA))
     uint8_t toggled = delta & ~(counter1[p] | counter0[p]);
     if (toggled) {
       debounced[p] ^= toggled; 
-      process_post_event(&event_dispatcher, INT_TO_PORT_CHANGED_EVENT(p),
-			 PACK_PROCESS_DATA(debounced[p],toggled));
+      process_publish_isr(&isr_queue, &port_topic[p], toggled,
+			  PACK_PROCESS_DATA(debounced[p],toggled));
     }
   }
 }
-
-
-PROCESS_THREAD(event_dispatcher)
-{
-  PROCESS_BEGIN();
-
-  while (true) {
-    PROCESS_WAIT_EVENT();
-
-    if (ev < NB_PORTS) {
-      uint8_t toggled = UNPACK_PROCESS_DATA1(data);
-
-      iomon_event* e = iomon_event_list_head[ev];
-      while (e != NULL) {
-	if (toggled & e->mask) {
-	  process_post_event(e->process, e->event, data);
-	}
-	e = e->next;
-      }
-    }
-  }
-
-  PROCESS_END();
-}
@@ -44,12 +44,9 @@ typedef enum {
   IOMON_PORTD = 2,
 } iomon_port;
 
-typedef struct iomon_event {
+typedef struct {
   iomon_port port;
-  uint8_t mask;
-  process* process;
-  process_event_t event;
-  struct iomon_event* next;
+  process_subscription subscription;
 } iomon_event;
 
 typedef enum {
@@ -37,112 +37,693 @@
 #include <stdlib.h>
 #include <util/atomic.h>
 #include "core/clock.h"
+#include "hal/cpufunc.h"
+#include "hal/interrupt.h"
+#include "hal/sleep.h"
+#include "util/bit.h"
 #include "util/log.h"
 
+#ifdef PROCESS_STATS
+#include <string.h>
+#include "hal/timers.h"
+
+// Free-running timer used to measure run times. It can be shared with other
+// modules, as long as they keep it in normal mode with a prescaler of 8.
+#ifndef PROCESS_CONF_STATS_TMR
+#define PROCESS_CONF_STATS_TMR TIMER1
+#endif
+#define STATS_TMR_PRESCALER 8
+
+#if TMR_SIZE(PROCESS_CONF_STATS_TMR) != 16
+#error "The process statistics timer must be a 16-bit timer"
+#endif
+
+// Timer tokens are not numeric, so map them to ids to compare them in #if
+#define STATS_TMR_ID_TIMER0 0
+#define STATS_TMR_ID_TIMER1 1
+#define STATS_TMR_ID_TIMER2 2
+#define STATS_TMR_ID(tmr) CAT(STATS_TMR_ID_,tmr)
+
+#if STATS_TMR_ID(PROCESS_CONF_STATS_TMR) == STATS_TMR_ID(CLOCK_TMR) && \
+    CLOCK_TMR_PRESCALER != STATS_TMR_PRESCALER
+#error "The clock shares the process statistics timer, but not its prescaler"
+#endif
+
+// Clock ticks after which the statistics timer may have overflowed
+#define STATS_TMR_MAX_CLOCK_TICKS \
+  ((UINT16_MAX * (uint32_t)STATS_TMR_PRESCALER) / CLOCK_TMR_PRESCALER)
+#endif
+
 // Should preferably be a power of 2
 #define PROCESS_CONF_EVENT_QUEUE_SIZE 16
 
-struct event {
-  process* p;
-  process_event_t ev;
-  process_data_t data;
-};
+#define ISR_QUEUE_MASK (PROCESS_CONF_ISR_QUEUE_SIZE - 1)
+
+#define FLAG_POLL_REQUESTED _BV(0)
 
 struct event_queue {
-  struct event queue[PROCESS_CONF_EVENT_QUEUE_SIZE];
+  struct process_queued_event queue[PROCESS_CONF_EVENT_QUEUE_SIZE];
   volatile uint8_t count;
   uint8_t first;
+  uint8_t max_count;
 };
 
 static struct event_queue queues[NB_PROCESS_EVENT_PRIORITIES];
 
+// Bit i is set iff queues[i] is not empty. Only modified in atomic blocks.
+static volatile uint8_t ready_queues;
+
+// Sorted by priority
+static process_isr_queue* isr_queues;
+
+// FIFO list of processes with a pending poll request
+static process* poll_list_head;
+static process* poll_list_tail;
+
+static uint16_t nb_direct_sends;
+static uint16_t nb_deferred_sends;
+
+#ifdef PROCESS_CONF_DEADLINE_EVENTS
+struct deadline_event {
+  struct process_queued_event e;
+  clock_time_t deadline;
+};
+
+// Unordered; new events are only appended, so the main context can search the
+// queue without masking interrupts.
+static struct deadline_event deadline_queue[PROCESS_CONF_DEADLINE_QUEUE_SIZE];
+static volatile uint8_t deadline_count;
+static uint16_t nb_missed_deadlines;
+#endif
+
+static process_idle_hook idle_hook = process_sleep_idle;
+static clock_time_t idle_time;
+static clock_time_t idle_reset_time;
+
 void process_init(void)
 {
   int i;
   for (i = 0; i < NB_PROCESS_EVENT_PRIORITIES; ++i) {
     queues[i].count = 0;
     queues[i].first = 0;
+    queues[i].max_count = 0;
   }
+  ready_queues = 0;
+  isr_queues = NULL;
+  poll_list_head = NULL;
+  poll_list_tail = NULL;
+  nb_direct_sends = 0;
+  nb_deferred_sends = 0;
+#ifdef PROCESS_CONF_DEADLINE_EVENTS
+  deadline_count = 0;
+  nb_missed_deadlines = 0;
+#endif
+  idle_hook = process_sleep_idle;
+  process_reset_idle_time();
+
+#ifdef PROCESS_STATS
+  TMR_SET_MODE(PROCESS_CONF_STATS_TMR, NORMAL);
+  TMR_SET_PRESCALER(PROCESS_CONF_STATS_TMR, STATS_TMR_PRESCALER);
+#endif
 }
 
 
+static inline bool
+in_poll_list(process* p)
+{
+  for (process* q = poll_list_head; q != NULL; q = q->poll_next) {
+    if (q == p) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void process_start(process* p)
 {
   // Initialize the protothread
   PT_INIT(&p->pt);
 
+  // Discard a poll request that was pending when the module was initialized
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if ((p->flags & FLAG_POLL_REQUESTED) && ! in_poll_list(p)) {
+      p->flags &= ~FLAG_POLL_REQUESTED;
+    }
+  }
+
   // Synchronously send INIT event
+  p->running = true;
   p->thread(p, PROCESS_EVENT_INIT, PROCESS_DATA_NULL);
+  p->running = false;
 }
 
 // Can be called from an interrupt:
 static inline process_post_event_status
-post_event(process* p, struct event_queue* q, process_event_t ev,
-	   process_data_t data)
+post_event(process* p, uint8_t pri, process_event_t ev, process_data_t data)
 {
-  uint8_t i;
+  struct event_queue* q = &queues[pri];
   ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
     if (q->count == PROCESS_CONF_EVENT_QUEUE_SIZE) {
       LOG_COUNTER_INC(EVENT_QUEUE_FULL);
       return PROCESS_POST_EVENT_QUEUE_FULL;
     }
 
-    i = (q->first + q->count) % PROCESS_CONF_EVENT_QUEUE_SIZE;
+    // The event must be complete before the queue is marked as ready, since
+    // process_execute() only looks at the bitmap.
+    uint8_t i = (q->first + q->count) % PROCESS_CONF_EVENT_QUEUE_SIZE;
+    q->queue[i].p = p;
+    q->queue[i].ev = ev;
+    q->queue[i].data = data;
+#ifdef PROCESS_STATS
+    q->queue[i].posted = (uint16_t)clock_get_time();
+#endif
     q->count += 1;
+    if (q->count > q->max_count) {
+      q->max_count = q->count;
+    }
+    ready_queues |= bv8(pri);
   }
-  q->queue[i].p = p;
-  q->queue[i].ev = ev;
-  q->queue[i].data = data;
-  
+
   return PROCESS_POST_EVENT_OK;
 }
 
 process_post_event_status
 process_post_event(process* p, process_event_t ev, process_data_t data)
 {
-  return post_event(p, &queues[0], ev, data);
+  return post_event(p, PROCESS_EVENT_PRIORITY_NORMAL, ev, data);
 }
 
 process_post_event_status
 process_post_priority_event(process* p, process_event_t ev, process_data_t data,
 		   process_event_priority pri)
 {
-  if (pri >= NB_PROCESS_EVENT_PRIORITIES) {
+  if ((unsigned int)pri >= NB_PROCESS_EVENT_PRIORITIES) {
+    return PROCESS_POST_EVENT_INVALID_PRIORITY;
+  }
+  return post_event(p, pri, ev, data);
+}
+
+#ifdef PROCESS_CONF_DEADLINE_EVENTS
+// True iff clock time a lies before clock time b, taking wrap-around into
+// account
+static inline bool
+time_before(clock_time_t a, clock_time_t b)
+{
+  return (clock_time_t)(a - b) > CLOCK_TIME_MAX / 2;
+}
+#endif
+
+process_post_event_status
+process_post_deadline_event(process* p, process_event_t ev,
+			    process_data_t data, clock_time_t deadline)
+{
+#ifdef PROCESS_CONF_DEADLINE_EVENTS
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if (deadline_count == PROCESS_CONF_DEADLINE_QUEUE_SIZE) {
+      LOG_COUNTER_INC(EVENT_QUEUE_FULL);
+      return PROCESS_POST_EVENT_QUEUE_FULL;
+    }
+
+    struct deadline_event* d = &deadline_queue[deadline_count];
+    d->e.p = p;
+    d->e.ev = ev;
+    d->e.data = data;
+#ifdef PROCESS_STATS
+    d->e.posted = (uint16_t)clock_get_time();
+#endif
+    d->deadline = deadline;
+    deadline_count += 1;
+  }
+  return PROCESS_POST_EVENT_OK;
+#else
+  return post_event(p, PROCESS_EVENT_PRIORITY_NORMAL, ev, data);
+#endif
+}
+
+
+
+process_post_event_status
+process_isr_queue_init(process_isr_queue* q, process_event_priority pri)
+{
+  if ((unsigned int)pri >= NB_PROCESS_EVENT_PRIORITIES) {
     return PROCESS_POST_EVENT_INVALID_PRIORITY;
   }
-  return post_event(p, &queues[pri], ev, data);
+
+  // Unregister the queue if it was registered before
+  process_isr_queue** iq = &isr_queues;
+  while (*iq != NULL) {
+    if (*iq == q) {
+      *iq = q->next;
+      break;
+    }
+    iq = &((*iq)->next);
+  }
+
+  q->head = 0;
+  q->tail = 0;
+  q->priority = pri;
+
+  // Insert after all queues with the same or a higher priority
+  iq = &isr_queues;
+  while (*iq != NULL && (*iq)->priority <= pri) {
+    iq = &((*iq)->next);
+  }
+  q->next = *iq;
+  *iq = q;
+
+  return PROCESS_POST_EVENT_OK;
+}
+
+// Must only be called by the producer of the ISR queue
+process_post_event_status
+process_post_isr_event(process_isr_queue* q, process* p, process_event_t ev,
+		       process_data_t data)
+{
+  const uint8_t head = q->head;
+  if ((uint8_t)(head - q->tail) == PROCESS_CONF_ISR_QUEUE_SIZE) {
+    LOG_COUNTER_INC(ISR_EVENT_QUEUE_FULL);
+    return PROCESS_POST_EVENT_QUEUE_FULL;
+  }
+
+  struct process_queued_event* e = &(q->events[head & ISR_QUEUE_MASK]);
+  e->p = p;
+  e->ev = ev;
+  e->data = data;
+#ifdef PROCESS_STATS
+  e->posted = (uint16_t)clock_get_time();
+#endif
+  // Publish the event only after it has been written completely. The event
+  // is not volatile, so the barrier keeps the compiler from moving its stores
+  // past the store of the head index.
+  _MemoryBarrier();
+  q->head = head + 1;
+
+  return PROCESS_POST_EVENT_OK;
+}
+
+void process_poll(process* p)
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if (! (p->flags & FLAG_POLL_REQUESTED)) {
+      p->flags |= FLAG_POLL_REQUESTED;
+      p->poll_next = NULL;
+      if (poll_list_tail == NULL) {
+	poll_list_head = p;
+      } else {
+	poll_list_tail->poll_next = p;
+      }
+      poll_list_tail = p;
+    }
+  }
+}
+
+// Must only be called by the consumer of the ISR queue
+static inline bool
+isr_queue_pop(process_isr_queue* q, struct process_queued_event* e)
+{
+  const uint8_t tail = q->tail;
+  if (tail == q->head) {
+    return false;
+  }
+
+  // The slot must not be read before the head index shows it is written, and
+  // may only be reused by the producer after it has been copied
+  _MemoryBarrier();
+  *e = q->events[tail & ISR_QUEUE_MASK];
+  _MemoryBarrier();
+  q->tail = tail + 1;
+  return true;
+}
+
+
+#ifdef PROCESS_STATS
+static inline uint16_t
+get_stats_tmr(void)
+{
+#if STATS_TMR_ID(PROCESS_CONF_STATS_TMR) == STATS_TMR_ID(CLOCK_TMR)
+  // The clock's ISRs also access this timer's 16-bit registers, which go
+  // through a single shared TEMP register
+  uint16_t cntr;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    cntr = TMR_GET_CNTR(PROCESS_CONF_STATS_TMR);
+  }
+  return cntr;
+#else
+  return TMR_GET_CNTR(PROCESS_CONF_STATS_TMR);
+#endif
+}
+
+static inline void
+record_run_time(process_stats* stats, uint16_t run_time)
+{
+  stats->nb_dispatches += 1;
+  stats->total_run_time += run_time;
+  if (run_time > stats->max_run_time) {
+    stats->max_run_time = run_time;
+  }
+
+  uint8_t bin = 0;
+  run_time >>= 5;
+  while (run_time != 0 && bin < PROCESS_STATS_HISTOGRAM_SIZE - 1) {
+    bin += 1;
+    run_time >>= 1;
+  }
+  if (stats->histogram[bin] < UINT16_MAX) {
+    stats->histogram[bin] += 1;
+  }
+}
+
+static inline void
+record_latency(struct process_queued_event* e)
+{
+  process_stats* stats = &(e->p->stats);
+  const uint16_t latency = (uint16_t)clock_get_time_fast() - e->posted;
+  stats->nb_latencies += 1;
+  stats->total_latency += latency;
+  if (latency > stats->max_latency) {
+    stats->max_latency = latency;
+  }
+}
+#else
+static inline void
+record_latency(struct process_queued_event* e)
+{ }
+#endif
+
+static inline void
+dispatch(process* p, process_event_t ev, process_data_t data)
+{
+  p->running = true;
+#ifdef PROCESS_STATS
+  const clock_time_t clock_before = clock_get_time_fast();
+  const uint16_t tmr_before = get_stats_tmr();
+#endif
+  p->thread(p, ev, data);
+#ifdef PROCESS_STATS
+  uint16_t run_time = get_stats_tmr() - tmr_before;
+  const clock_time_t duration = clock_get_time_fast() - clock_before;
+  if (duration >= STATS_TMR_MAX_CLOCK_TICKS) {
+    run_time = UINT16_MAX;
+  }
+  p->time += duration;
+  record_run_time(&(p->stats), run_time);
+#endif
+  p->running = false;
+}
+
+
+process_post_event_status
+process_send_event(process* p, process_event_t ev, process_data_t data)
+{
+  if (p->running) {
+    // Calling the process' thread again would corrupt its state
+    nb_deferred_sends += 1;
+    return post_event(p, PROCESS_EVENT_PRIORITY_NORMAL, ev, data);
+  }
+
+  nb_direct_sends += 1;
+  dispatch(p, ev, data);
+  return PROCESS_POST_EVENT_OK;
+}
+
+
+// Fans out a message published to a topic. The event carries the message tags.
+static PT_THREAD(topic_thread(process* p, process_event_t tags,
+			      process_data_t data))
+{
+  process_subscription* s = ((process_topic*)p)->subscribers;
+  while (s != NULL) {
+    // The subscriber may unsubscribe while handling the message
+    process_subscription* next = s->next;
+    if (s->mask & tags) {
+      if (s->p->running) {
+	post_event(s->p, PROCESS_EVENT_PRIORITY_NORMAL, s->ev, data);
+      } else {
+	dispatch(s->p, s->ev, data);
+      }
+    }
+    s = next;
+  }
+  return PT_WAITING;
+}
+
+void process_topic_init(process_topic* t)
+{
+  t->dispatcher.thread = topic_thread;
+  t->dispatcher.flags = 0;
+  t->dispatcher.running = false;
+  t->dispatcher.poll_next = NULL;
+  process_reset_stats(&t->dispatcher);
+  t->subscribers = NULL;
 }
 
+void process_subscription_init(process_subscription* s, process* p,
+			       process_event_t ev, uint8_t mask)
+{
+  s->p = p;
+  s->ev = ev;
+  s->mask = mask;
+}
+
+bool process_subscribe(process_topic* t, process_subscription* s)
+{
+  process_subscription** sp = &t->subscribers;
+  while (*sp != NULL) {
+    if (*sp == s) {
+      return false;
+    }
+    sp = &((*sp)->next);
+  }
 
+  s->next = NULL;
+  *sp = s;
+  return true;
+}
 
-void process_execute(void)
+bool process_unsubscribe(process_topic* t, process_subscription* s)
 {
-  // Find first non-empty queue
-  int qi = 0;
-  while (qi < NB_PROCESS_EVENT_PRIORITIES && queues[qi].count == 0) {
-    qi += 1;
+  process_subscription** sp = &t->subscribers;
+  while (*sp != NULL) {
+    if (*sp == s) {
+      *sp = s->next;
+      return true;
+    }
+    sp = &((*sp)->next);
+  }
+
+  return false;
+}
+
+process_post_event_status
+process_publish(process_topic* t, uint8_t tags, process_data_t data)
+{
+  if (t->subscribers == NULL) {
+    return PROCESS_POST_EVENT_OK;
+  }
+  return post_event(&t->dispatcher, PROCESS_EVENT_PRIORITY_NORMAL, tags, data);
+}
+
+process_post_event_status
+process_publish_isr(process_isr_queue* q, process_topic* t, uint8_t tags,
+		    process_data_t data)
+{
+  if (t->subscribers == NULL) {
+    return PROCESS_POST_EVENT_OK;
+  }
+  return process_post_isr_event(q, &t->dispatcher, tags, data);
+}
+
+
+#ifdef PROCESS_CONF_DEADLINE_EVENTS
+static inline bool
+execute_deadline_event(void)
+{
+  // Interrupts only append events, so the first deadline_count entries do not
+  // change while searching.
+  const uint8_t count = deadline_count;
+  if (count == 0) {
+    return false;
+  }
+
+  uint8_t earliest = 0;
+  for (uint8_t i = 1; i < count; ++i) {
+    if (time_before(deadline_queue[i].deadline,
+		    deadline_queue[earliest].deadline)) {
+      earliest = i;
+    }
+  }
+
+  struct deadline_event d;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    d = deadline_queue[earliest];
+    deadline_count -= 1;
+    deadline_queue[earliest] = deadline_queue[deadline_count];
   }
-  if (qi == NB_PROCESS_EVENT_PRIORITIES) {
+
+  if (time_before(d.deadline, clock_get_time_fast())) {
+    nb_missed_deadlines += 1;
+    LOG_COUNTER_INC(PROCESS_DEADLINE_MISSED);
+  }
+  record_latency(&d.e);
+  dispatch(d.e.p, d.e.ev, d.e.data);
+  return true;
+}
+#endif
+
+static inline bool
+execute_event(void)
+{
+#ifdef PROCESS_CONF_DEADLINE_EVENTS
+  if (execute_deadline_event()) {
+    return true;
+  }
+#endif
+
+  // Find the highest-priority non-empty queue. Reading the bitmap is atomic
+  // and bits are only cleared by this function, so the queue cannot become
+  // empty before it is accessed below.
+  const uint8_t ready = ready_queues;
+  const uint8_t qi = ctz8(ready); // NB_PROCESS_EVENT_PRIORITIES <= 8
+  struct process_queued_event e;
+
+  // Events from ISR queues take precedence over regular events of the same
+  // priority. There is only one ISR queue per interrupt source, so this list
+  // is short.
+  process_isr_queue* iq = isr_queues;
+  while (iq != NULL && iq->priority <= qi) {
+    if (isr_queue_pop(iq, &e)) {
+      record_latency(&e);
+      dispatch(e.p, e.ev, e.data);
+      return true;
+    }
+    iq = iq->next;
+  }
+
+  if (ready == 0) {
     // No events to process
-    return;
+    return false;
   }
 
   // Process one event from the selected queue
-  struct event e;
   struct event_queue* q = &queues[qi];
   ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
     e = q->queue[q->first];
     q->count -= 1;
     q->first = (q->first + 1) % PROCESS_CONF_EVENT_QUEUE_SIZE;
+    if (q->count == 0) {
+      ready_queues &= ~bv8(qi);
+    }
+  }
+  record_latency(&e);
+  dispatch(e.p, e.ev, e.data);
+  return true;
+}
+
+static inline bool
+execute_poll(void)
+{
+  // Avoid masking interrupts if no polls are pending. The pointer read is not
+  // atomic, so it is checked again below.
+  if (poll_list_head == NULL) {
+    return false;
+  }
+
+  struct process_queued_event e;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    e.p = poll_list_head;
+    if (e.p == NULL) {
+      return false;
+    }
+    poll_list_head = e.p->poll_next;
+    if (poll_list_head == NULL) {
+      poll_list_tail = NULL;
+    }
+    // Clear the flag before dispatching, so the process can poll itself
+    e.p->flags &= ~FLAG_POLL_REQUESTED;
+  }
+  e.ev = PROCESS_EVENT_POLL;
+  e.data = PROCESS_DATA_NULL;
+  dispatch(e.p, e.ev, e.data);
+  return true;
+}
+
+
+bool process_execute(void)
+{
+  bool executed = execute_event();
+  executed |= execute_poll();
+  return executed;
+}
+
+
+static inline bool
+work_pending(void)
+{
+  if (ready_queues != 0 || poll_list_head != NULL) {
+    return true;
+  }
+#ifdef PROCESS_CONF_DEADLINE_EVENTS
+  if (deadline_count != 0) {
+    return true;
   }
-#ifdef PROCESS_STATS
-  clock_time_t clock_before = clock_get_time();
-#endif
-  e.p->thread(e.p, e.ev, e.data);
-#ifdef PROCESS_STATS
-  clock_time_t duration = clock_get_time() - clock_before;
-  e.p->time += duration;
 #endif
+  process_isr_queue* iq = isr_queues;
+  while (iq != NULL) {
+    if (iq->head != iq->tail) {
+      return true;
+    }
+    iq = iq->next;
+  }
+  return false;
+}
+
+bool process_is_work_pending(void)
+{
+  return work_pending();
+}
+
+void process_sleep_idle(void)
+{
+  SLEEP_SET_MODE(IDLE);
+  SLEEP_ENABLE();
+  ENABLE_INTERRUPTS();
+  SLEEP_CPU();
+  SLEEP_DISABLE();
+}
+
+void process_set_idle_hook(process_idle_hook hook)
+{
+  idle_hook = (hook == NULL) ? process_sleep_idle : hook;
+}
+
+void process_idle(void)
+{
+  DISABLE_INTERRUPTS();
+  if (work_pending()) {
+    // An interrupt posted an event after process_execute() returned
+    ENABLE_INTERRUPTS();
+    return;
+  }
+
+  const clock_time_t before = clock_get_time();
+  idle_hook(); // Enables interrupts
+  idle_time += clock_get_time() - before;
+}
+
+clock_time_t process_get_idle_time(void)
+{
+  return idle_time;
+}
+
+clock_time_t process_get_busy_time(void)
+{
+  return (clock_get_time() - idle_reset_time) - idle_time;
+}
+
+void process_reset_idle_time(void)
+{
+  idle_reset_time = clock_get_time();
+  idle_time = 0;
 }
 
 
@@ -154,3 +735,66 @@ clock_time_t process_get_time(process* p)
   return 0;
 #endif
 }
+
+bool process_get_stats(process* p, process_stats* stats)
+{
+#ifdef PROCESS_STATS
+  *stats = p->stats;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void process_reset_stats(process* p)
+{
+#ifdef PROCESS_STATS
+  memset(&(p->stats), 0, sizeof(p->stats));
+#endif
+}
+
+
+uint8_t process_get_queue_count(process_event_priority pri)
+{
+  if ((unsigned int)pri >= NB_PROCESS_EVENT_PRIORITIES) {
+    return 0;
+  }
+  return queues[pri].count;
+}
+
+uint8_t process_get_queue_max_count(process_event_priority pri)
+{
+  if ((unsigned int)pri >= NB_PROCESS_EVENT_PRIORITIES) {
+    return 0;
+  }
+  return queues[pri].max_count;
+}
+
+uint16_t process_get_nb_direct_sends(void)
+{
+  return nb_direct_sends;
+}
+
+uint16_t process_get_nb_deferred_sends(void)
+{
+  return nb_deferred_sends;
+}
+
+uint16_t process_get_nb_missed_deadlines(void)
+{
+#ifdef PROCESS_CONF_DEADLINE_EVENTS
+  return nb_missed_deadlines;
+#else
+  return 0;
+#endif
+}
+
+void process_reset_queue_max_count(void)
+{
+  int i;
+  for (i = 0; i < NB_PROCESS_EVENT_PRIORITIES; ++i) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      queues[i].max_count = queues[i].count;
+    }
+  }
+}
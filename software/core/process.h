@@ -44,6 +44,32 @@
 typedef uint8_t process_event_t;
 typedef uintptr_t process_data_t;
 
+#define PROCESS_STATS_HISTOGRAM_SIZE 8
+
+/**
+ * Execution profile of a process, collected if the PROCESS_STATS macro is
+ * defined.
+ *
+ * Run times are measured with a sub-tick timer (PROCESS_CONF_STATS_TMR) that
+ * counts every 8 CPU cycles, i.e. every 0.5us at 16MHz. Run times that do not
+ * fit in 16 bits are saturated. Latencies are the number of clock ticks an
+ * event waited in an event queue before being dispatched. Poll requests and
+ * synchronously sent events have no latency.
+ *
+ * Bin 0 of the run time histogram counts the dispatches that took less than 32
+ * timer counts, bin i counts those that took between 2^(i+4) and 2^(i+5)
+ * counts, and the last bin counts all dispatches longer than that.
+ */
+typedef struct {
+  uint32_t nb_dispatches;
+  uint32_t total_run_time;
+  uint16_t max_run_time;
+  uint32_t nb_latencies;
+  uint32_t total_latency;
+  uint16_t max_latency;
+  uint16_t histogram[PROCESS_STATS_HISTOGRAM_SIZE];
+} process_stats;
+
 #define PACK_PROCESS_DATA(b0,b1)  ((process_data_t)((b1 << 8) | b0))
 #define UNPACK_PROCESS_DATA0(d)   (d & 0xFF)
 #define UNPACK_PROCESS_DATA1(d)   (d >> 8)
@@ -51,8 +77,12 @@ typedef uintptr_t process_data_t;
 typedef struct process {
   struct pt pt;
   PT_THREAD((*thread)(struct process*, process_event_t, process_data_t));
+  uint8_t flags;
+  bool running; // Only accessed from the main context
+  struct process* poll_next;
 #ifdef PROCESS_STATS
   clock_time_t time;
+  process_stats stats;
 #endif
 } process;
 
@@ -178,11 +208,14 @@ typedef struct process {
  * Calling this macro causes the current process to temporarily stop executing,
  * to give other processes some CPU time. The process is resumed when the other
  * processes give up the CPU.
+ *
+ * Yielding polls the current process (see process_poll()), so it does not
+ * take up a slot in the event queue.
  */
-#define PROCESS_YIELD()							\
-  do {									\
-    process_post_event(pc, PROCESS_EVENT_CONTINUE, PROCESS_DATA_NULL);	\
-    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_CONTINUE);		\
+#define PROCESS_YIELD()						\
+  do {								\
+    process_poll(pc);						\
+    PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL);		\
   } while (0)
 
 /**
@@ -212,13 +245,80 @@ typedef enum {
   PROCESS_POST_EVENT_INVALID_PRIORITY,
 } process_post_event_status;
 
+/**
+ * Number of event priority levels. Level 0 has the highest priority. The
+ * scheduler keeps one bit per level in an 8-bit ready bitmap, so at most 8
+ * levels can be configured.
+ */
+#ifndef PROCESS_CONF_NB_EVENT_PRIORITIES
+#define PROCESS_CONF_NB_EVENT_PRIORITIES 2
+#endif
+
+#if PROCESS_CONF_NB_EVENT_PRIORITIES < 2 || PROCESS_CONF_NB_EVENT_PRIORITIES > 8
+#error "PROCESS_CONF_NB_EVENT_PRIORITIES must be between 2 and 8"
+#endif
+
+#define NB_PROCESS_EVENT_PRIORITIES PROCESS_CONF_NB_EVENT_PRIORITIES
+
+/**
+ * Event priorities. Any value between PROCESS_EVENT_PRIORITY_HIGH and
+ * PROCESS_EVENT_PRIORITY_LOW is a valid priority; only the most common levels
+ * are named. With the default of two levels, LOW and NORMAL coincide.
+ */
 typedef enum {
-  PROCESS_EVENT_PRIORITY_HIGH,
-  PROCESS_EVENT_PRIORITY_NORMAL,
-  NB_PROCESS_EVENT_PRIORITIES
+  PROCESS_EVENT_PRIORITY_HIGH   = 0,
+  PROCESS_EVENT_PRIORITY_NORMAL = 1,
+  PROCESS_EVENT_PRIORITY_LOW    = NB_PROCESS_EVENT_PRIORITIES - 1,
 } process_event_priority;
 
 
+/**
+ * Size of the event queue of an interrupt source (see process_isr_queue). Must
+ * be a power of 2, no larger than 128.
+ */
+#ifndef PROCESS_CONF_ISR_QUEUE_SIZE
+#define PROCESS_CONF_ISR_QUEUE_SIZE 8
+#endif
+
+#if (PROCESS_CONF_ISR_QUEUE_SIZE & (PROCESS_CONF_ISR_QUEUE_SIZE - 1)) != 0 || \
+  PROCESS_CONF_ISR_QUEUE_SIZE > 128
+#error "PROCESS_CONF_ISR_QUEUE_SIZE must be a power of 2, no larger than 128"
+#endif
+
+/**
+ * An event waiting in a queue to be dispatched.
+ */
+struct process_queued_event {
+  process* p;
+  process_event_t ev;
+  process_data_t data;
+#ifdef PROCESS_STATS
+  uint16_t posted; // Clock time at which the event was posted
+#endif
+};
+
+/**
+ * Event queue for a single interrupt source.
+ *
+ * Posting an event to a regular event queue requires interrupts to be masked,
+ * since a queue can have many producers. An ISR queue has a single producer
+ * (the interrupt service routine) and a single consumer (process_execute()),
+ * so it can be implemented with free-running 8-bit head and tail indices that
+ * are each written by only one side. Neither posting nor dispatching an event
+ * from an ISR queue masks interrupts.
+ *
+ * Several interrupt service routines may share a queue, provided they can not
+ * interrupt each other (which is the default on AVR).
+ */
+typedef struct process_isr_queue {
+  struct process_queued_event events[PROCESS_CONF_ISR_QUEUE_SIZE];
+  volatile uint8_t head; // Only written by the producer
+  volatile uint8_t tail; // Only written by the consumer
+  process_event_priority priority;
+  struct process_isr_queue* next;
+} process_isr_queue;
+
+
 /**
  * Initialize the processes module.
  */
@@ -233,7 +333,7 @@ void process_start(process* p);
 
 
 /**
- * Asynchronously post an event to a process.
+ * Asynchronously post an event to a process, with normal priority.
  *
  * It is safe to call this function from an interrupt service routine. Although
  * this function guarantees the event will be delivered to the process, there
@@ -254,7 +354,7 @@ process_post_event(process* p, process_event_t ev, process_data_t data);
  *
  * Events with a higher priority will be dispatched before events with a lower
  * priority and events with the same priority will be dispatched on a FIFO
- * basis.
+ * basis. Priority 0 (PROCESS_EVENT_PRIORITY_HIGH) is the highest priority.
  *
  * It is safe to call this function from an interrupt service routine. Although
  * this function guarantees the event will be delivered to the process, there
@@ -276,15 +376,315 @@ process_post_priority_event(process* p, process_event_t ev,
 
 
 
+/**
+ * Synchronously send an event to a process.
+ *
+ * The process' thread is called immediately, without going through the event
+ * queue. If the process is already running, i.e. when it (indirectly) sends an
+ * event to itself, the event is posted with normal priority instead, exactly
+ * like process_post_event() does.
+ *
+ * This function must not be called from an interrupt service routine.
+ *
+ * @param p     The process to send the event to
+ * @param event The event to send
+ * @param data  The data associated with the event
+ * @return PROCESS_POST_EVENT_OK if the event was dispatched or posted
+ *        successfully, or PROCESS_POST_EVENT_QUEUE_FULL if the process is
+ *        running and the event could not be posted because the event queue is
+ *        full.
+ */
+process_post_event_status
+process_send_event(process* p, process_event_t ev, process_data_t data);
+
+
+/**
+ * Initialize an ISR event queue and register it with the scheduler.
+ *
+ * Events from an ISR queue are dispatched before events in the regular event
+ * queue of the same priority. ISR queues with the same priority are served in
+ * the order in which they were initialized. Initializing a queue that was
+ * already registered empties it and updates its priority.
+ *
+ * This function must not be called while the queue's interrupt source is
+ * enabled.
+ *
+ * @param q   The ISR queue to initialize
+ * @param pri The priority of the events posted to the queue
+ * @return PROCESS_POST_EVENT_OK if the queue was registered successfully, or
+ *         PROCESS_POST_EVENT_INVALID_PRIORITY if the given priority is
+ *         invalid.
+ */
+process_post_event_status
+process_isr_queue_init(process_isr_queue* q, process_event_priority pri);
+
+/**
+ * Asynchronously post an event to a process from an interrupt service routine,
+ * without masking interrupts.
+ *
+ * This function may only be called by the (single) producer of the given ISR
+ * queue.
+ *
+ * @param q     The ISR queue to post the event to
+ * @param p     The process to post the event to
+ * @param event The event to post
+ * @param data  The data associated with the event
+ * @return PROCESS_POST_EVENT_OK if the event was posted successfully, or
+ *        PROCESS_POST_EVENT_QUEUE_FULL if the event could not be posted
+ *        because the ISR queue is full.
+ */
+process_post_event_status
+process_post_isr_event(process_isr_queue* q, process* p, process_event_t ev,
+		       process_data_t data);
+
+
+/**
+ * Size of the deadline event queue (see process_post_deadline_event). Only
+ * used if the PROCESS_CONF_DEADLINE_EVENTS macro is defined.
+ */
+#ifndef PROCESS_CONF_DEADLINE_QUEUE_SIZE
+#define PROCESS_CONF_DEADLINE_QUEUE_SIZE 8
+#endif
+
+/**
+ * Asynchronously post an event that must be dispatched before a given clock
+ * time.
+ *
+ * This is an optional feature, enabled only if the PROCESS_CONF_DEADLINE_EVENTS
+ * macro is defined. Deadline events are kept in a separate queue and are
+ * dispatched before any other queued event, earliest deadline first. Events
+ * with the same deadline are dispatched in no particular order. An event that
+ * is dispatched after its deadline is counted as a missed deadline (see
+ * process_get_nb_missed_deadlines()). Deadline events preempt all other
+ * queued events, including events with PROCESS_EVENT_PRIORITY_HIGH and events
+ * in ISR queues (see process_post_isr_event()), so a stream of deadline events
+ * can delay those indefinitely. They should only be used for short,
+ * time-critical work.
+ *
+ * If the feature is disabled, the event is posted with normal priority,
+ * exactly like process_post_event() does. It is safe to call this function
+ * from an interrupt service routine.
+ *
+ * @param p        The process to post the event to
+ * @param ev       The event to post
+ * @param data     The data associated with the event
+ * @param deadline The clock time before which the event should be dispatched
+ * @return PROCESS_POST_EVENT_OK if the event was posted successfully, or
+ *        PROCESS_POST_EVENT_QUEUE_FULL if the event could not be posted
+ *        because the deadline event queue is full.
+ */
+process_post_event_status
+process_post_deadline_event(process* p, process_event_t ev,
+			    process_data_t data, clock_time_t deadline);
+
+
+/**
+ * Subscription of a process to a topic (see process_topic).
+ */
+typedef struct process_subscription {
+  process* p;
+  process_event_t ev; // The event to deliver to the subscribed process
+  uint8_t mask;       // Only deliver messages with one of these tags
+  struct process_subscription* next;
+} process_subscription;
+
+/**
+ * A publish/subscribe channel.
+ *
+ * A message published to a topic takes a single event queue entry, no matter
+ * how many processes are subscribed to it. The message is fanned out to all
+ * subscribers when it is dispatched: every subscriber of which the mask shares
+ * at least one bit with the message's tags synchronously receives its own
+ * subscription event, together with the message data. Subscribers receive
+ * messages in the order in which they subscribed.
+ *
+ * The topic's dispatcher is an internal process and must not be used
+ * directly.
+ */
+typedef struct {
+  process dispatcher;
+  process_subscription* subscribers;
+} process_topic;
+
+// Tags of a message that should be delivered to every subscriber
+#define PROCESS_TOPIC_ALL_TAGS 0xFF
+
+/**
+ * Initialize a topic without subscribers.
+ *
+ * @param t The topic to initialize
+ */
+void process_topic_init(process_topic* t);
+
+/**
+ * Initialize a topic subscription.
+ *
+ * It is allowed to re-initialize a subscription that is subscribed to a topic,
+ * in order to change its process, event or mask.
+ *
+ * @param s    The subscription to initialize
+ * @param p    The process to deliver messages to
+ * @param ev   The event to deliver to the process
+ * @param mask The tags in which the process is interested, or
+ *             PROCESS_TOPIC_ALL_TAGS to receive all messages
+ */
+void process_subscription_init(process_subscription* s, process* p,
+			       process_event_t ev, uint8_t mask);
+
+/**
+ * Subscribe to a topic.
+ *
+ * This function must not be called from an interrupt service routine.
+ *
+ * @param t The topic to subscribe to
+ * @param s The subscription to add to the topic
+ * @return true if the subscription was added, or false if it was already
+ *         subscribed to the topic.
+ */
+bool process_subscribe(process_topic* t, process_subscription* s);
+
+/**
+ * Unsubscribe from a topic.
+ *
+ * A process is allowed to unsubscribe while handling a message from the same
+ * topic. This function must not be called from an interrupt service routine.
+ *
+ * @param t The topic to unsubscribe from
+ * @param s The subscription to remove from the topic
+ * @return true if the subscription was removed, or false if it was not
+ *         subscribed to the topic.
+ */
+bool process_unsubscribe(process_topic* t, process_subscription* s);
+
+/**
+ * Asynchronously publish a message to a topic, with normal priority.
+ *
+ * Nothing is posted if the topic has no subscribers. It is safe to call this
+ * function from an interrupt service routine, although process_publish_isr()
+ * avoids masking interrupts.
+ *
+ * @param t    The topic to publish to
+ * @param tags Tags of the message, matched against the subscription masks
+ * @param data The data associated with the message
+ * @return PROCESS_POST_EVENT_OK if the message was published successfully, or
+ *        PROCESS_POST_EVENT_QUEUE_FULL if the message could not be published
+ *        because the event queue is full.
+ */
+process_post_event_status
+process_publish(process_topic* t, uint8_t tags, process_data_t data);
+
+/**
+ * Asynchronously publish a message to a topic from an interrupt service
+ * routine, without masking interrupts.
+ *
+ * This function may only be called by the (single) producer of the given ISR
+ * queue.
+ *
+ * @param q    The ISR queue to post the message to
+ * @param t    The topic to publish to
+ * @param tags Tags of the message, matched against the subscription masks
+ * @param data The data associated with the message
+ * @return PROCESS_POST_EVENT_OK if the message was published successfully, or
+ *        PROCESS_POST_EVENT_QUEUE_FULL if the message could not be published
+ *        because the ISR queue is full.
+ */
+process_post_event_status
+process_publish_isr(process_isr_queue* q, process_topic* t, uint8_t tags,
+		    process_data_t data);
+
+
+/**
+ * Request a process to be polled.
+ *
+ * A polled process receives a PROCESS_EVENT_POLL event. Unlike posted events,
+ * poll requests do not use the event queue: each process has a single poll
+ * flag and polling a process that already has a pending poll request has no
+ * effect. It is safe to call this function from an interrupt service routine.
+ *
+ * @param p The process to poll
+ */
+void process_poll(process* p);
+
+
 /**
  * Call the next process in line for execution.
  *
  * This function will execute a process if there is one to be executed. Other-
  * wise, this function returns without doing anything. This function is
  * typically called from an infinite loop, thereby executing processes as soon
- * as they are ready to be executed.
+ * as they are ready to be executed. When it returns false, the loop can call
+ * process_idle() to sleep until the next interrupt:
+ *
+ *   while (true) {
+ *     if (! process_execute()) {
+ *       process_idle();
+ *     }
+ *   }
+ *
+ * The next event is taken from the highest-priority non-empty queue. Finding
+ * that queue is a constant-time lookup in a bitmap of non-empty queues, so the
+ * dispatch overhead does not depend on the number of priority levels.
+ *
+ * Besides one event, each call also services the oldest pending poll request,
+ * if any. Events therefore can not starve polled processes and vice versa.
+ *
+ * @return true if an event or poll request was processed, false if there was
+ *         nothing to do.
+ */
+bool process_execute(void);
+
+
+/**
+ * Function called by process_idle() to put the MCU to sleep. The function is
+ * called with interrupts disabled and must enable them, typically right
+ * before executing the sleep instruction.
+ */
+typedef void (*process_idle_hook)(void);
+
+/**
+ * The default idle hook, which puts the MCU in idle sleep mode.
+ */
+void process_sleep_idle(void);
+
+/**
+ * Set the function that process_idle() uses to put the MCU to sleep.
+ *
+ * @param hook The idle hook, or NULL to restore the default idle hook.
+ */
+void process_set_idle_hook(process_idle_hook hook);
+
+/**
+ * Return whether any events or poll requests are pending. Idle hooks can use
+ * this to cut a long sleep short when an interrupt has posted an event.
+ */
+bool process_is_work_pending(void);
+
+/**
+ * Sleep until the next interrupt, unless there is work left to do.
+ *
+ * Interrupts are disabled while checking whether any events or poll requests
+ * are pending, so an interrupt that occurs right before going to sleep does
+ * not delay the processing of its event until the next interrupt. The time
+ * spent sleeping is accounted as idle time.
+ */
+void process_idle(void);
+
+/**
+ * Return the number of clock ticks spent in process_idle(), since the module
+ * was initialized or the idle time was reset.
  */
-void process_execute(void);
+clock_time_t process_get_idle_time(void);
+
+/**
+ * Return the number of clock ticks not spent in process_idle(), since the
+ * module was initialized or the idle time was reset.
+ */
+clock_time_t process_get_busy_time(void);
+
+/**
+ * Reset the idle and busy times.
+ */
+void process_reset_idle_time(void);
 
 
 /**
@@ -298,5 +698,72 @@ void process_execute(void);
  */
 clock_time_t process_get_time(process* p);
 
+/**
+ * Copy the execution profile of a given process.
+ *
+ * This is an optional feature, enabled only if the PROCESS_STATS macro is
+ * defined. The average run time and latency can be obtained by dividing the
+ * totals by the number of dispatches and latency samples respectively.
+ *
+ * @param p     The process for which to get the execution profile
+ * @param stats Location to copy the profile to
+ * @return true if the profile was copied, or false if the feature is disabled.
+ */
+bool process_get_stats(process* p, process_stats* stats);
+
+/**
+ * Reset the execution profile of a given process.
+ *
+ * @param p The process for which to reset the execution profile
+ */
+void process_reset_stats(process* p);
+
+
+/**
+ * Return the number of events currently in the event queue of the given
+ * priority.
+ *
+ * @param pri The priority of the queue
+ * @return The number of events in the queue, or 0 if the priority is invalid.
+ */
+uint8_t process_get_queue_count(process_event_priority pri);
+
+/**
+ * Return the largest number of events that have been in the event queue of the
+ * given priority at the same time, since the module was initialized or the
+ * count was reset.
+ *
+ * @param pri The priority of the queue
+ * @return The high-water mark of the queue, or 0 if the priority is invalid.
+ */
+uint8_t process_get_queue_max_count(process_event_priority pri);
+
+/**
+ * Reset the high-water marks of all event queues to their current number of
+ * events.
+ */
+void process_reset_queue_max_count(void);
+
+
+/**
+ * Return the number of events that process_send_event() dispatched directly,
+ * since the module was initialized. The count wraps around.
+ */
+uint16_t process_get_nb_direct_sends(void);
+
+/**
+ * Return the number of events that process_send_event() had to post to the
+ * event queue because the receiving process was running, since the module was
+ * initialized. The count wraps around.
+ */
+uint16_t process_get_nb_deferred_sends(void);
+
+/**
+ * Return the number of deadline events that were dispatched after their
+ * deadline, since the module was initialized. The count wraps around. Always
+ * returns 0 if the PROCESS_CONF_DEADLINE_EVENTS macro is not defined.
+ */
+uint16_t process_get_nb_missed_deadlines(void);
+
 
 #endif
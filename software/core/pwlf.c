@@ -28,10 +28,9 @@
 
 #include "pwlf.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 
-#include <math.h>
-
 void pwlf_clear(pwlf* f)
 {
   f->count = 0;
@@ -71,6 +70,44 @@ int16_t pwlf_get_y(pwlf* f, uint8_t i)
   return f->values[i].y;
 }
 
+// Cache the segment between nodes i and i+1
+static void
+compile_segment(pwlf* f, uint8_t i)
+{
+  pwlf_pair p0 = f->values[i];
+  pwlf_pair p1 = f->values[i + 1];
+  int32_t dy = (int32_t)p1.y - p0.y;
+  uint16_t width = p1.x - p0.x;
+
+  // Round the slope to the nearest Q16.16 value
+  int64_t scaled = (int64_t)dy * 65536;
+  int64_t slope = (scaled + (dy < 0 ? -(width >> 1) : (width >> 1))) / width;
+
+  pwlf_segment* seg = &f->segments[i];
+  if (slope > INT32_MAX || slope <= INT32_MIN) {
+    seg->slope = PWLF_STEEP_SEGMENT;
+  } else {
+    seg->slope = slope;
+  }
+  seg->offset = (int32_t)p0.y * 65536 + 0x8000;
+}
+
+void pwlf_compile(pwlf* f, pwlf_segment segments[])
+{
+  f->segments = segments;
+  if (segments == NULL) {
+    return;
+  }
+
+  // The count may have been written directly, never trust it beyond the size
+  // of the node buffer
+  uint8_t count = f->count < f->max_count ? f->count : f->max_count;
+  uint8_t i;
+  for (i = 0; i + 1 < count; ++i) {
+    compile_segment(f, i);
+  }
+}
+
 pwlf_add_node_status
 pwlf_add_node(pwlf* f, uint16_t x, int16_t y)
 {
@@ -84,6 +121,9 @@ pwlf_add_node(pwlf* f, uint16_t x, int16_t y)
   f->values[f->count].x = x;
   f->values[f->count].y = y;
   f->count += 1;
+  if (f->segments != NULL && f->count >= 2) {
+    compile_segment(f, f->count - 2);
+  }
   return PWLF_ADD_NODE_OK;
 }
 
@@ -100,30 +140,77 @@ pwlf_remove_node(pwlf* f)
 }
 
 
-// requires: p0.x <= x <= p1.x
+// requires: p0.x < p1.x
+//
+// Returns p0.y + round((p1.y - p0.y) * (x - p0.x) / (p1.x - p0.x)), rounding
+// halfway cases away from zero, or INT16_MIN or INT16_MAX if the result does
+// not fit in 16 bits. The magnitude of the product is at most 65535^2, so the
+// division is done on unsigned 32-bit values.
 static inline
 int16_t polate(uint16_t x, pwlf_pair p0, pwlf_pair p1)
 {
-  float dx = ((float)(p1.y - p0.y)) / (p1.x - p0.x);
-  int16_t result = p0.y + (int16_t)round(dx * (x - p0.x));
-
-  // Detect overflow
-  if (p0.y <= p1.y) {
-    // Increasing function
-    if (x < p0.x && p0.y < result) {
-      return INT16_MIN;
-    }
-    if (p1.x < x && result < p1.y) {
-      return INT16_MAX;
-    }
+  int32_t dy = (int32_t)p1.y - p0.y;
+  int32_t dx = (int32_t)x - p0.x;
+  uint16_t width = p1.x - p0.x;
+  bool negative = (dy < 0) != (dx < 0);
+
+  uint32_t product = (uint32_t)(dy < 0 ? -dy : dy)
+    * (uint32_t)(dx < 0 ? -dx : dx);
+  uint32_t q = (product + (width >> 1)) / width;
+
+  // Detect overflow. An increment of more than 16 bits always overflows.
+  if (q > UINT16_MAX) {
+    return negative ? INT16_MIN : INT16_MAX;
+  }
+  int32_t result = (int32_t)p0.y + (negative ? -(int32_t)q : (int32_t)q);
+  if (result < INT16_MIN) {
+    return INT16_MIN;
+  }
+  if (result > INT16_MAX) {
+    return INT16_MAX;
+  }
+  return result;
+}
+
+// Returns (offset + slope * (x - x0)) >> 16, clamped to 16 bits. The shift
+// rounds towards minus infinity, the offset includes 0.5 to round to the
+// nearest value.
+//
+// The product of the slope and dx takes up to 48 bits, so it is formed from
+// two 16x16-bit products that are kept in 32-bit types. Only the integer part
+// and the fraction of the product are needed, never its full width.
+static inline
+int16_t segment_value(pwlf_segment* seg, uint16_t x, uint16_t x0)
+{
+  bool negative = (seg->slope < 0) != (x < x0);
+  uint32_t m = seg->slope < 0 ? -(uint32_t)seg->slope : (uint32_t)seg->slope;
+  uint16_t d = x < x0 ? x0 - x : x - x0;
+
+  uint32_t low = (uint16_t)m * (uint32_t)d;
+  uint32_t whole = (uint16_t)(m >> 16) * (uint32_t)d + (low >> 16);
+  uint16_t fraction = low;
+
+  // An increment of more than 16 bits always overflows
+  if (whole > UINT16_MAX) {
+    return negative ? INT16_MIN : INT16_MAX;
+  }
+
+  int32_t offset_whole = seg->offset >> 16;
+  uint16_t offset_fraction = seg->offset;
+  int32_t result;
+  if (negative) {
+    result = offset_whole - (int32_t)whole
+      - (offset_fraction < fraction ? 1 : 0);
   } else {
-    // Decreasing function
-    if (x < p0.x && result < p0.y) {
-      return INT16_MAX;
-    }
-    if (p1.x < x && p1.y < result) {
-      return INT16_MIN;
-    }
+    result = offset_whole + (int32_t)whole
+      + (((uint32_t)offset_fraction + fraction) >> 16);
+  }
+
+  if (result < INT16_MIN) {
+    return INT16_MIN;
+  }
+  if (result > INT16_MAX) {
+    return INT16_MAX;
   }
   return result;
 }
@@ -135,22 +222,36 @@ int16_t pwlf_value(pwlf* f, uint16_t x)
     return 0;
   }
 
-  // Find node with smallest x value that is >= x
-  uint8_t i = 0;
-  while (i < f->count && f->values[i].x < x) {
-    i += 1;
+  // Find node with smallest x value that is >= x, or count if there is none.
+  // The search range is halved in every iteration without branching on the
+  // comparison, so the lookup takes log2(count) steps.
+  const pwlf_pair* base = f->values;
+  uint8_t n = f->count;
+  while (n > 1) {
+    uint8_t half = n >> 1;
+    base = (base[half].x < x) ? base + half : base;
+    n -= half;
   }
+  uint8_t i = (base - f->values) + (base->x < x);
 
   uint8_t i0, i1;
   if (i == 0) {
     // x is smaller than or equal to the first node, extrapolate
     i0 = i;
     i1 = i + 1;
+  } else if (i == f->count) {
+    // x is larger than the last node, extrapolate
+    i0 = i - 2;
+    i1 = i - 1;
   } else {
-    // x is between i-1 and i (interpolate) or larger than i (extrapolate)
+    // x is between i-1 and i, interpolate
     i0 = i - 1;
     i1 = i;
   }
+
+  if (f->segments != NULL && f->segments[i0].slope != PWLF_STEEP_SEGMENT) {
+    return segment_value(&f->segments[i0], x, f->values[i0].x);
+  }
   return polate(x, f->values[i0], f->values[i1]);
 }
 
@@ -27,12 +27,15 @@
  * @author Pieter Agten (pieter.agten@gmail.com)
  * @date 10 Oct 2014
  *
- * This module implements continuous 16-bit to 16-bit integer 16-piece
- * piecewise linear functions.  When given an argument below or above the
+ * This module implements continuous 16-bit to 16-bit integer piecewise linear
+ * functions with up to 255 nodes.  When given an argument below or above the
  * domain, the function value will be extrapolated based on the two smallest
- * or the two largest nodes respectively.
+ * or the two largest nodes respectively.  The segment containing an argument
+ * is found with a binary search, so evaluation time grows with the logarithm
+ * of the number of nodes.
  */
 
+#include <stddef.h>
 #include <stdint.h>
 
 typedef struct {
@@ -40,9 +43,25 @@ typedef struct {
   int16_t y;
 } pwlf_pair;
 
+/**
+ * Cached form of the segment between two nodes. The value at x is
+ * (offset + slope * (x - x0)) >> 16, where x0 is the x value of the left node.
+ */
+typedef struct {
+  int32_t slope;  // Q16.16, or PWLF_STEEP_SEGMENT
+  int32_t offset; // y value of the left node in Q16.16, plus 0.5 to round
+} pwlf_segment;
+
+/**
+ * Slope of segments that are too steep for a Q16.16 slope. These are
+ * evaluated like functions without a segment cache.
+ */
+#define PWLF_STEEP_SEGMENT INT32_MIN
+
 typedef struct {
   uint8_t count;
   uint8_t max_count;
+  pwlf_segment* segments; // Segment cache, or NULL
   pwlf_pair values[];
 } pwlf;
 
@@ -61,7 +80,8 @@ typedef enum {
 
 
 #define PWLF_INIT(SIZE)						\
-  { .count = 0, .max_count = SIZE, .values = { [SIZE-1] = {0} } }
+  { .count = 0, .max_count = SIZE, .segments = NULL,			\
+    .values = { [SIZE-1] = {0} } }
 
 
 /**
@@ -155,8 +175,36 @@ pwlf_remove_node_status
 pwlf_remove_node(pwlf* f);
 
 
+/**
+ * Attach a segment cache to a piecewise linear function and fill it.
+ *
+ * A function with a segment cache keeps a Q16.16 slope and an offset for
+ * each segment, which pwlf_add_node() updates as nodes are added. Evaluating
+ * the function then takes a single multiplication, shift and addition instead
+ * of a division. Due to the limited precision of the slope, the value may be
+ * one off from that of a function without a cache.
+ *
+ * Each segment takes 8 bytes of RAM, and on AVR the 32-bit multiplication is
+ * not necessarily cheaper than the division it replaces. Measure the gain on
+ * the target before attaching a cache.
+ *
+ * Nodes that are written without using pwlf_add_node(), for example when
+ * reading them from EEPROM, require calling this function again.
+ *
+ * @param f        The piecewise linear function to compile
+ * @param segments A buffer of at least pwlf_get_size(f) - 1 segments, or NULL
+ *                 to remove the segment cache
+ */
+void pwlf_compile(pwlf* f, pwlf_segment segments[]);
+
+
 /**
  * Return the y value of a piecewise linear function at a given x value.
+ *
+ * The value is computed with integer arithmetic only and is rounded to the
+ * nearest integer, with halfway cases rounded away from the y value of the
+ * left node of the segment. Extrapolated values that do not fit in 16 bits
+ * are clamped to INT16_MIN or INT16_MAX.
  * 
  * @param x The x value at which to get the function value.
  * @return The function value at the given x value.
@@ -0,0 +1,212 @@
+/*
+ * rtimer.c
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file rtimer.c
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ */
+
+#include "rtimer.h"
+
+#include <stddef.h>
+#include <util/atomic.h>
+
+#include "hal/interrupt.h"
+
+#if TMR_SIZE(RTIMER_TMR) != 8
+#error "The rtimer currently only supports 8-bit timers."
+#endif
+
+
+static volatile uint8_t rtimer_upper;
+
+// Scheduled timers, sorted by expiration time
+static rtimer* scheduled;
+
+// True while the callbacks of expired timers are being called
+static bool dispatching;
+
+void rtimer_init(void)
+{
+  scheduled = NULL;
+  dispatching = false;
+  rtimer_upper = 0;
+
+  TMR_INIT(RTIMER_TMR);
+  TMR_INTERRUPT_DISABLE(RTIMER_TMR, OCA);
+  TMR_INTERRUPT_ENABLE(RTIMER_TMR, OVF);
+  TMR_SET_MODE(RTIMER_TMR, NORMAL);
+  TMR_SET_CNTR(RTIMER_TMR, 0);
+  TMR_SET_PRESCALER(RTIMER_TMR, RTIMER_TMR_PRESCALER);
+}
+
+
+rtimer_clock_t rtimer_now(void)
+{
+  rtimer_clock_t result;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    uint8_t upper = rtimer_upper;
+    uint8_t cntr = TMR_GET_CNTR(RTIMER_TMR);
+    if (TMR_IS_INTERRUPT_FLAG_SET(RTIMER_TMR, OVF) && cntr < 128) {
+      // Timer has overflowed and interrupt has not been handled yet
+      upper += 1;
+    }
+    result = ((rtimer_clock_t)upper << 8) | cntr;
+  }
+  return result;
+}
+
+
+// True iff time a comes before time b
+static inline bool
+time_before(rtimer_clock_t a, rtimer_clock_t b)
+{
+  return (rtimer_clock_t)(a - b) > UINT16_MAX / 2;
+}
+
+// True iff the rtimer time has reached the given time
+static inline bool
+reached(rtimer_clock_t time)
+{
+  return ! time_before(rtimer_now(), time);
+}
+
+// Must be called with interrupts disabled
+static bool
+unschedule(rtimer* t)
+{
+  rtimer** pp = &scheduled;
+  while (*pp != NULL) {
+    if (*pp == t) {
+      *pp = t->next;
+      return true;
+    }
+    pp = &((*pp)->next);
+  }
+  return false;
+}
+
+// Must be called with interrupts disabled
+static void
+schedule(rtimer* t)
+{
+  rtimer** pp = &scheduled;
+  while (*pp != NULL && ! time_before(t->time, (*pp)->time)) {
+    pp = &((*pp)->next);
+  }
+  t->next = *pp;
+  *pp = t;
+}
+
+// Call the functions of all expired timers and program the compare match
+// interrupt for the first timer that has not expired yet. The compare match
+// only involves the lower 8 bits of the rtimer time, so it fires once every
+// 256 ticks until that timer has expired. Must be called with interrupts
+// disabled.
+static void
+dispatch(void)
+{
+  dispatching = true;
+  TMR_INTERRUPT_DISABLE(RTIMER_TMR, OCA);
+  while (scheduled != NULL) {
+    rtimer* t = scheduled;
+    if (! reached(t->time)) {
+      TMR_SET_OCR(RTIMER_TMR, OCA, (uint8_t)t->time);
+      TMR_CLEAR_INTERRUPT_FLAG(RTIMER_TMR, OCA);
+      TMR_INTERRUPT_ENABLE(RTIMER_TMR, OCA);
+      if (! reached(t->time)) {
+	break;
+      }
+      // The compare match may have been missed while programming it
+      TMR_INTERRUPT_DISABLE(RTIMER_TMR, OCA);
+    }
+    scheduled = t->next;
+    t->f(t, t->ptr);
+  }
+  dispatching = false;
+}
+
+
+rtimer_set_status
+rtimer_set(rtimer* t, rtimer_clock_t delay, rtimer_callback f, void* ptr)
+{
+  if (delay > RTIMER_MAX_DELAY) {
+    return RTIMER_SET_DELAY_TOO_LONG;
+  }
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    unschedule(t);
+    t->time = rtimer_now() + delay;
+    t->f = f;
+    t->ptr = ptr;
+    schedule(t);
+    // When called from a callback, the timer is handled by the running dispatch
+    if (! dispatching) {
+      dispatch();
+    }
+  }
+  return RTIMER_SET_OK;
+}
+
+
+void rtimer_stop(rtimer* t)
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if (unschedule(t) && ! dispatching) {
+      dispatch();
+    }
+  }
+}
+
+
+bool rtimer_is_scheduled(rtimer* t)
+{
+  bool result = false;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    for (rtimer* s = scheduled; s != NULL; s = s->next) {
+      if (s == t) {
+	result = true;
+	break;
+      }
+    }
+  }
+  return result;
+}
+
+
+bool rtimer_is_any_scheduled(void)
+{
+  return scheduled != NULL;
+}
+
+
+INTERRUPT(TMR_INTERRUPT_VECT(RTIMER_TMR, OCA))
+{
+  if (scheduled != NULL && reached(scheduled->time)) {
+    dispatch();
+  }
+}
+
+INTERRUPT(TMR_INTERRUPT_VECT(RTIMER_TMR, OVF))
+{
+  rtimer_upper += 1;
+}
@@ -0,0 +1,157 @@
+/*
+ * rtimer.h
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RTIMER_H
+#define RTIMER_H
+
+/**
+ * @file rtimer.h
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ *
+ * This is the real-time timer: a one-shot timer that calls a function from
+ * interrupt context when it expires. It has a much higher resolution than the
+ * clock and its expiration does not depend on the process scheduler, so it is
+ * meant for short, precise delays such as the inter-byte gaps of a
+ * communication protocol or the execution times of a display controller.
+ *
+ * The rtimer runs on its own hardware timer (see RTIMER_CONF_TMR), so it does
+ * not interfere with the clock. Callbacks should be kept as short as possible,
+ * as they are executed with interrupts disabled. Longer work should be
+ * deferred to a process, for example by polling it from the callback.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "hal/timers.h"
+
+#ifndef F_CPU
+#warning "F_CPU not defined in rtimer.h!"
+#endif
+
+/**
+ * The hardware timer used by the rtimer module. Its compare match channel A
+ * and overflow interrupts are reserved for this module.
+ */
+#ifndef RTIMER_CONF_TMR
+#define RTIMER_CONF_TMR           TIMER2
+#endif
+
+#ifndef RTIMER_CONF_TMR_PRESCALER
+#define RTIMER_CONF_TMR_PRESCALER 32
+#endif
+
+#define RTIMER_TMR            RTIMER_CONF_TMR
+#define RTIMER_TMR_PRESCALER  RTIMER_CONF_TMR_PRESCALER
+
+typedef uint16_t rtimer_clock_t;
+
+#define RTIMER_SEC   ((double)F_CPU/RTIMER_TMR_PRESCALER) /** 1 second */
+#define RTIMER_MSEC  (RTIMER_SEC/1000.0)                  /** 1 millisecond */
+#define RTIMER_USEC  (RTIMER_SEC/1000000.0)               /** 1 microsecond */
+
+/**
+ * The longest delay an rtimer can be set to. At 16MHz and the default
+ * prescaler, the rtimer ticks every 2 us and delays can be up to 65 ms long.
+ */
+#define RTIMER_MAX_DELAY  INT16_MAX
+
+#define RTIMER_NEAREST(t)  (t + 0.5)
+#define RTIMER_AT_LEAST(t) (t + 1.0)
+
+struct rtimer;
+typedef void (*rtimer_callback)(struct rtimer* t, void* ptr);
+
+struct rtimer {
+  rtimer_clock_t time;
+  rtimer_callback f;
+  void* ptr;
+  struct rtimer* next;
+};
+typedef struct rtimer rtimer;
+
+typedef enum {
+  RTIMER_SET_OK,
+  RTIMER_SET_DELAY_TOO_LONG,
+} rtimer_set_status;
+
+/**
+ * Initialize the rtimer module.
+ */
+void rtimer_init(void);
+
+
+/**
+ * Return the current rtimer time.
+ */
+rtimer_clock_t rtimer_now(void);
+
+
+/**
+ * Set an rtimer to call a function after a given delay.
+ *
+ * The function is called from interrupt context, with interrupts disabled, at
+ * the first rtimer tick at which the delay has passed. If the timer was already
+ * scheduled, it is rescheduled. A delay of 0 calls the function immediately,
+ * before this function returns.
+ *
+ * It is safe to call this function from an rtimer callback, for example to
+ * set the same timer again.
+ *
+ * @param t     The rtimer to set
+ * @param delay The delay in rtimer ticks, at most RTIMER_MAX_DELAY
+ * @param f     The function to call when the timer expires
+ * @param ptr   Opaque pointer passed to f
+ * @return RTIMER_SET_OK if the timer was scheduled, or
+ *         RTIMER_SET_DELAY_TOO_LONG if the delay exceeds RTIMER_MAX_DELAY
+ */
+rtimer_set_status rtimer_set(rtimer* t, rtimer_clock_t delay, rtimer_callback f,
+			     void* ptr);
+
+
+/**
+ * Cancel an rtimer.
+ *
+ * Cancelling a timer that is not scheduled has no effect.
+ *
+ * @param t The rtimer to cancel
+ */
+void rtimer_stop(rtimer* t);
+
+
+/**
+ * Return whether an rtimer is scheduled to expire.
+ *
+ * @param t The rtimer to check
+ * @return True if the timer is scheduled, false otherwise
+ */
+bool rtimer_is_scheduled(rtimer* t);
+
+
+/**
+ * Return whether any rtimer is scheduled to expire.
+ *
+ * @return True if at least one timer is scheduled, false otherwise
+ */
+bool rtimer_is_any_scheduled(void);
+
+#endif
@@ -26,10 +26,14 @@
  */
 
 #include "spi_master.h"
+
+#include <util/atomic.h>
+#include <util/delay.h>
+
 #include "core/crc16.h"
-#include "core/etimer.h"
 #include "core/events.h"
 #include "core/process.h"
+#include "core/rtimer.h"
 #include "core/spi_common.h"
 #include "hal/gpio.h"
 #include "hal/spi.h"
@@ -47,6 +51,8 @@ struct spim_trx {
 
 PROCESS(spim_trx_process);
 
+process_topic spim_trx_topic;
+
 static spim_trx* trx_queue_head;
 static spim_trx* trx_queue_tail;
 
@@ -59,8 +65,16 @@ static spim_trx* trx_queue_tail;
 #define TRX_IN_TRANSMISSION_BIT  6
 #define TRX_USE_LLP_BIT          5
 
-#define LLP_TX_DELAY  (40.0 * CLOCK_USEC)
-#define LLP_RX_DELAY  (50.0 * CLOCK_USEC)
+#define LLP_TX_DELAY  RTIMER_AT_LEAST(40.0 * RTIMER_USEC)
+#define LLP_RX_DELAY  RTIMER_AT_LEAST(50.0 * RTIMER_USEC)
+
+// The delays between link-layer protocol bytes are timed by an rtimer, which
+// polls the transfer process as soon as the delay has passed.
+static rtimer delay_rtimer;
+static volatile bool delay_passed;
+
+// Set when a preloaded frame was sent while a transfer was in transmission
+static volatile bool preempted;
 
 void spim_init(void)
 {
@@ -75,6 +89,7 @@ void spim_init(void)
   SPI_TC_INTERRUPT_DISABLE();
   SPI_ENABLE();
 
+  process_topic_init(&spim_trx_topic);
   process_start(&spim_trx_process);
 }
 
@@ -159,6 +174,12 @@ bool spim_trx_is_queued(spim_trx* trx)
   return trx->flags & _BV(TRX_QUEUED_BIT);
 }
 
+// The transfer in transmission stays at the head of the queue until it ends
+bool spim_is_busy(void)
+{
+  return trx_queue_head != NULL;
+}
+
 static inline
 void trx_set_queued(spim_trx* trx, bool v)
 {
@@ -250,9 +271,24 @@ void shift_trx_queue(void)
 static
 void end_transfer(process_event_t ev)
 {
+  if (preempted) {
+    // The slave was deselected in the middle of the transfer
+    ev = SPIM_TRX_ERROR;
+    if (trx_queue_head->flags & _BV(TRX_USE_LLP_BIT)) {
+      trx_q_hd_llp->error = SPIM_TRX_ERR_PREEMPTED;
+    }
+  }
+
   if (trx_queue_head->p != NULL) {
     process_post_event(trx_queue_head->p, ev, (process_data_t)trx_queue_head);
   }
+  process_publish(&spim_trx_topic,
+		  ev == SPIM_TRX_ERROR ? SPIM_TRX_TAG_ERROR
+		                       : SPIM_TRX_TAG_COMPLETED_SUCCESSFULLY,
+		  (process_data_t)trx_queue_head);
+
+  // A transfer can be aborted while waiting for a delay
+  rtimer_stop(&delay_rtimer);
 
   // Make the slave select pin high
   *(trx_queue_head->ss_port) |= trx_queue_head->ss_mask;
@@ -281,10 +317,24 @@ void handle_response_error(uint8_t response_type)
 }
 
 
+static void
+delay_rtimer_expired(rtimer* t, void* ptr)
+{
+  delay_passed = true;
+  process_poll(&spim_trx_process);
+}
+
+static inline
+void start_delay(rtimer_clock_t delay)
+{
+  delay_passed = false;
+  rtimer_set(&delay_rtimer, delay, delay_rtimer_expired, NULL);
+}
+
+
 PROCESS_THREAD(spim_trx_process)
 {
   PROCESS_BEGIN();
-  static etimer trx_etimer;
   static uint8_t tx_counter;
   static uint8_t rx_counter;
   static crc16 crc;
@@ -298,7 +348,10 @@ PROCESS_THREAD(spim_trx_process)
     PROCESS_WAIT_WHILE(trx_queue_head == NULL);
 
     // Update transfer status
-    trx_set_in_transmission(trx_queue_head, true);
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      trx_set_in_transmission(trx_queue_head, true);
+      preempted = false;
+    }
 
     // Start transfer by pulling the slave select pin low
     *(trx_queue_head->ss_port) &= ~(trx_queue_head->ss_mask);
@@ -311,20 +364,20 @@ PROCESS_THREAD(spim_trx_process)
 
       // Send first header byte (message type id)
       tx_byte(trx_q_hd_llp->tx_type);
-      etimer_set(&trx_etimer, CLK_AT_LEAST(LLP_TX_DELAY), PROCESS_CURRENT());
+      start_delay(LLP_TX_DELAY);
       crc16_init(&crc);
       crc16_update(&crc, trx_q_hd_llp->tx_type);
       crc16_update(&crc, trx_q_hd_llp->tx_size);
 
       // Send second header byte (message size)
-      PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&trx_etimer));
+      PROCESS_WAIT_EVENT_UNTIL(delay_passed);
       tx_byte(trx_q_hd_llp->tx_size);
-      etimer_restart(&trx_etimer);
+      start_delay(LLP_TX_DELAY);
 
       // Send message bytes
       tx_counter = 0;
       while (tx_counter < trx_q_hd_llp->tx_size) {
-	PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&trx_etimer));
+	PROCESS_WAIT_EVENT_UNTIL(delay_passed);
 	response = read_response_byte();
 	if (response != SPI_TYPE_PREPARING_RESPONSE) {
 	  LOG_COUNTER_INC(SPIM_ERROR_RESPONSE);
@@ -332,13 +385,13 @@ PROCESS_THREAD(spim_trx_process)
 	  goto start;
 	}
 	tx_byte(trx_q_hd_llp->tx_buf[tx_counter]);
-	etimer_restart(&trx_etimer);
+	start_delay(LLP_TX_DELAY);
 	crc16_update(&crc, trx_q_hd_llp->tx_buf[tx_counter]);
 	tx_counter += 1;
       }
       
       // Send CRC footer bytes
-      PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&trx_etimer));
+      PROCESS_WAIT_EVENT_UNTIL(delay_passed);
       response = read_response_byte();
       if (response != SPI_TYPE_PREPARING_RESPONSE) {
 	LOG_COUNTER_INC(SPIM_ERROR_RESPONSE);
@@ -346,8 +399,8 @@ PROCESS_THREAD(spim_trx_process)
 	goto start;
       }
       tx_byte((uint8_t)(crc >> 8));
-      etimer_restart(&trx_etimer);
-      PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&trx_etimer));
+      start_delay(LLP_TX_DELAY);
+      PROCESS_WAIT_EVENT_UNTIL(delay_passed);
       response = read_response_byte();
       if (response != SPI_TYPE_PREPARING_RESPONSE) {
 	LOG_COUNTER_INC(SPIM_ERROR_RESPONSE);
@@ -355,19 +408,19 @@ PROCESS_THREAD(spim_trx_process)
 	goto start;
       }
       tx_byte((uint8_t)(crc & 0x00FF));
-      etimer_set(&trx_etimer, CLK_AT_LEAST(LLP_RX_DELAY), PROCESS_CURRENT());
+      start_delay(LLP_RX_DELAY);
 
       // Wait for response
-      PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&trx_etimer));
+      PROCESS_WAIT_EVENT_UNTIL(delay_passed);
       tx_dummy_byte();
-      etimer_restart(&trx_etimer);
+      start_delay(LLP_RX_DELAY);
       reset_rx_delay_remaining(trx_q_hd_llp);
       wait_for_tx_complete();
       while (get_rx_delay_remaining(trx_q_hd_llp) > 0 &&
 	     read_response_byte() == SPI_TYPE_PREPARING_RESPONSE) {
-	PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&trx_etimer));
+	PROCESS_WAIT_EVENT_UNTIL(delay_passed);
 	tx_dummy_byte();
-	etimer_restart(&trx_etimer);	
+	start_delay(LLP_RX_DELAY);
 	decrement_rx_delay_remaining(trx_q_hd_llp);
 	wait_for_tx_complete();
       }
@@ -388,15 +441,15 @@ PROCESS_THREAD(spim_trx_process)
       // Receive response header (first byte has already been received)
       crc16_init(&crc);
       trx_q_hd_llp->rx_type = response;
-      PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&trx_etimer));
+      PROCESS_WAIT_EVENT_UNTIL(delay_passed);
       tx_dummy_byte(); // for the size byte
-      etimer_restart(&trx_etimer); 
+      start_delay(LLP_RX_DELAY);
       crc16_update(&crc, trx_q_hd_llp->rx_type);
 
-      PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&trx_etimer));
+      PROCESS_WAIT_EVENT_UNTIL(delay_passed);
       uint8_t size = read_response_byte();
       tx_dummy_byte(); // for the first payload or footer byte
-      etimer_restart(&trx_etimer); 
+      start_delay(LLP_RX_DELAY);
       if (size > trx_q_hd_llp->rx_max) {
 	// rx_buf is too small for the response, abort the transfer
 	LOG_COUNTER_INC(SPIM_RESPONSE_TOO_LARGE);
@@ -410,20 +463,20 @@ PROCESS_THREAD(spim_trx_process)
       // Receive response payload
       rx_counter = 0;
       while (rx_counter < trx_q_hd_llp->rx_size) {
-	PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&trx_etimer));
+	PROCESS_WAIT_EVENT_UNTIL(delay_passed);
 	trx_q_hd_llp->rx_buf[rx_counter] = read_response_byte();
 	tx_dummy_byte();
-	etimer_restart(&trx_etimer); 
+	start_delay(LLP_RX_DELAY);
 	crc16_update(&crc, trx_q_hd_llp->rx_buf[rx_counter]);
 	rx_counter += 1;
       }
       
       // Receive response footer (first byte has already been received)
-      PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&trx_etimer));
+      PROCESS_WAIT_EVENT_UNTIL(delay_passed);
       rx_crc = ((crc16)read_response_byte()) << 8;
       tx_dummy_byte();
-      etimer_restart(&trx_etimer); 
-      PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&trx_etimer));
+      start_delay(LLP_RX_DELAY);
+      PROCESS_WAIT_EVENT_UNTIL(delay_passed);
       rx_crc |= read_response_byte();
       if (! crc16_equal(&crc, &rx_crc)) {
 	// CRC failure, abort transfer
@@ -495,3 +548,39 @@ spim_trx_llp_get_error_type(spim_trx_llp* trx)
 {
   return trx->error;
 }
+
+
+void
+spim_frame_set(spim_frame* frame, uint8_t ss_pin, volatile uint8_t* ss_port,
+	       uint8_t size, const uint8_t* buf)
+{
+  frame->ss_mask = bv8(ss_pin & 0x07);
+  frame->ss_port = ss_port;
+  frame->size = size;
+  frame->buf = buf;
+}
+
+
+void spim_frame_send(const spim_frame* frame)
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if (trx_queue_head != NULL && spim_trx_is_in_transmission(trx_queue_head)) {
+      // Abort the transfer in transmission, after the byte that may still be
+      // shifting out
+      *(trx_queue_head->ss_port) |= trx_queue_head->ss_mask;
+      preempted = true;
+      _delay_us(2);
+    }
+    SPI_CLEAR_FLAGS();
+
+    *(frame->ss_port) &= ~(frame->ss_mask);
+    uint8_t i;
+    for (i = 0; i < frame->size; ++i) {
+      tx_byte(frame->buf[i]);
+      wait_for_tx_complete();
+    }
+    *(frame->ss_port) |= frame->ss_mask;
+    // The interrupt flag is left set, so an interrupted simple transfer that
+    // is waiting for its current byte does not wait forever
+  }
+}
@@ -161,6 +161,7 @@ typedef enum {
   SPIM_TRX_ERR_RESPONSE_TOO_LARGE,
   SPIM_TRX_ERR_RESPONSE_CRC_ERROR,
   SPIM_TRX_ERR_RESPONSE_TIMEOUT,
+  SPIM_TRX_ERR_PREEMPTED,
 
   // Errors detected slave-side
   SPIM_TRX_ERR_SLAVE_UNKNOWN,
@@ -211,8 +212,33 @@ typedef struct {
 } spim_trx_llp;
 
 
+/**
+ * A preloaded SPI frame, which can be sent from an ISR without going through
+ * the transfer queue. The response of the device is ignored.
+ */
+typedef struct {
+  uint8_t ss_mask;
+  volatile uint8_t *ss_port;
+  uint8_t size;
+  const uint8_t* buf;
+} spim_frame;
+
+
 PROCESS_NAME(spim_trx_process);
 
+// Tags of the messages published to spim_trx_topic
+#define SPIM_TRX_TAG_COMPLETED_SUCCESSFULLY  0x01
+#define SPIM_TRX_TAG_ERROR                   0x02
+
+/**
+ * Topic to which the SPI master publishes every finished transfer, tagged with
+ * SPIM_TRX_TAG_COMPLETED_SUCCESSFULLY or SPIM_TRX_TAG_ERROR. The message data
+ * is a pointer to the transfer. This allows processes to observe transfers
+ * they did not queue themselves; the process passed when configuring a
+ * transfer is still notified directly.
+ */
+extern process_topic spim_trx_topic;
+
 /**
  * Initializes the SPI master module.
  *
@@ -222,6 +248,7 @@ PROCESS_NAME(spim_trx_process);
  * Dependencies that must be initialized first:
  *  * process
  *  * clock
+ *  * rtimer
  */
 void spim_init(void);
 
@@ -309,6 +336,15 @@ bool spim_trx_is_in_transmission(spim_trx* trx);
  */
 bool spim_trx_is_queued(spim_trx* trx);
 
+
+/**
+ * Return whether the SPI master is busy, i.e. whether any transfer is queued
+ * or in transmission.
+ *
+ * @return true if the SPI master is busy, false otherwise.
+ */
+bool spim_is_busy(void);
+
 /**
  * Queue an SPI transfer for execution.
  *
@@ -384,4 +420,34 @@ spim_trx_error_type
 spim_trx_llp_get_error_type(spim_trx_llp* trx);
 
 
+/**
+ * Configure a preloaded SPI frame.
+ *
+ * @param frame    The frame data structure to configure
+ * @param ss_pin   The number of the pin connected to the device's SS pin
+ * @param ss_port  The port of the pin connected to the device's SS pin
+ * @param size     The number of bytes to send
+ * @param buf      The bytes to send, which must stay valid as long as the
+ *                 frame can be sent
+ */
+void
+spim_frame_set(spim_frame* frame, uint8_t ss_pin, volatile uint8_t* ss_port,
+	       uint8_t size, const uint8_t* buf);
+
+
+/**
+ * Send a preloaded SPI frame immediately, bypassing the transfer queue.
+ *
+ * This function busy-waits until the frame has been sent, which takes 2 us
+ * per byte at F_CPU/4, and can be called from an ISR. It is meant for
+ * emergency actions such as shutting down an output, so it does not wait for
+ * the transfer that is in transmission, if any. That transfer's slave is
+ * deselected first, so it sees an aborted transfer, and the transfer finishes
+ * with an SPIM_TRX_ERROR event (SPIM_TRX_ERR_PREEMPTED for LLP transfers).
+ *
+ * @param frame  The frame to send
+ */
+void spim_frame_send(const spim_frame* frame);
+
+
 #endif
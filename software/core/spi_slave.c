@@ -80,6 +80,9 @@ static bool transfer_in_progress;
 static process* callback;
 static struct spis_trx trx;
 
+// Shared by the pin change and SPI ISRs, which can not interrupt each other
+static process_isr_queue isr_queue;
+
 spis_init_status
 spis_init(process* p)
 {
@@ -96,6 +99,7 @@ spis_init(process* p)
   trx.tx_remaining = 0;
   trx.error_code_remaining = 0;
   trx.status = SPIS_TRX_READY;
+  process_isr_queue_init(&isr_queue, PROCESS_EVENT_PRIORITY_HIGH);
 
   SPI_SET_PIN_DIRS_SLAVE();
   SPI_SET_ROLE_SLAVE();
@@ -199,9 +203,8 @@ INTERRUPT(PC_INTERRUPT_VECT(SPI_SS_PIN))
 	trx.status < SPIS_TRX_COMPLETED) {
       // Transfer was ended prematurely, after notifying the callback that a
       // message was received
-      process_post_priority_event(callback, SPIS_RESPONSE_ERROR,
-				  PROCESS_DATA_NULL,
-				  PROCESS_EVENT_PRIORITY_HIGH);
+      process_post_isr_event(&isr_queue, callback, SPIS_RESPONSE_ERROR,
+			     PROCESS_DATA_NULL);
       if (trx.status == SPIS_TRX_WAITING_FOR_CALLBACK) {
 	set_spi_data_reg(SPI_TYPE_ERR_SLAVE_NOT_READY);
 	trx.error_code_remaining = SPI_TYPE_ERR_SLAVE_NOT_READY;
@@ -272,9 +275,8 @@ INTERRUPT(SPI_TRANSFER_COMPLETE_VECT)
     SPI_SET_DATA_REG(SPI_TYPE_PREPARING_RESPONSE);
     trx.rx_received += 1;
     trx.status = SPIS_TRX_WAITING_FOR_CALLBACK;
-    process_post_priority_event(callback, SPIS_MESSAGE_RECEIVED,
-				PROCESS_DATA_NULL,
-				PROCESS_EVENT_PRIORITY_HIGH);
+    process_post_isr_event(&isr_queue, callback, SPIS_MESSAGE_RECEIVED,
+			   PROCESS_DATA_NULL);
     break;
   case SPIS_TRX_WAITING_FOR_CALLBACK:
     // Keep sending SPI_TYPE_PREPARING_RESPONSE until the client process sets a
@@ -309,9 +311,8 @@ INTERRUPT(SPI_TRANSFER_COMPLETE_VECT)
     break;
   case SPIS_TRX_COMPLETED:
     end_transfer(SPI_TYPE_PREPARING_RESPONSE);
-    process_post_priority_event(callback, SPIS_RESPONSE_TRANSMITTED,
-				PROCESS_DATA_NULL,
-				PROCESS_EVENT_PRIORITY_HIGH);
+    process_post_isr_event(&isr_queue, callback, SPIS_RESPONSE_TRANSMITTED,
+			   PROCESS_DATA_NULL);
     LOG_COUNTER_INC(SPIS_TRX_COMPLETED);    
     break;
   default:
@@ -50,6 +50,22 @@ void mcp4922_pkt_init(mcp4922_pkt* pkt)
 
 
 
+static void
+set_data(uint8_t* data, mcp4922_channel ch, uint16_t value, bool shutdown)
+{
+  // This assumes MSB-first SPI data transfer
+  data[0] = (value >> 8) & 0x0F;
+  data[0] |= _BV(GA) >> 8;
+  if (! shutdown) {
+    data[0] |= _BV(SHDN) >> 8;
+  }
+  if (ch == MCP4922_CHANNEL_B) {
+    data[0] |= _BV(CHB) >> 8;
+  }
+  data[1] = value & 0x00FF;
+}
+
+
 void
 mcp4922_pkt_set(mcp4922_pkt* pkt, uint8_t pin, port_ptr port,
 		mcp4922_channel ch, uint16_t value)
@@ -58,14 +74,7 @@ mcp4922_pkt_set(mcp4922_pkt* pkt, uint8_t pin, port_ptr port,
 		      2, pkt->data,      // tx_buf
 		      0, NULL,           // rx_buf
 		      NULL);             // process
-
-  // This assumes MSB-first SPI data transfer
-  pkt->data[0] = (value >> 8) & 0x0F;
-  pkt->data[0] |= (_BV(GA) | _BV(SHDN)) >> 8;
-  if (ch == MCP4922_CHANNEL_B) {
-    pkt->data[0] |= _BV(CHB) >> 8;
-  }
-  pkt->data[1] = value & 0x00FF;
+  set_data(pkt->data, ch, value, false);
 }
 
 
@@ -76,6 +85,12 @@ bool mcp4922_pkt_is_in_transmission(mcp4922_pkt* pkt)
 }
 
 
+bool mcp4922_pkt_is_queued(mcp4922_pkt* pkt)
+{
+  return spim_trx_is_queued((spim_trx*)&(pkt->spim_trx));
+}
+
+
 mcp4922_pkt_queue_status
 mcp4922_pkt_queue(mcp4922_pkt* pkt)
 {
@@ -88,3 +103,18 @@ mcp4922_pkt_queue(mcp4922_pkt* pkt)
   return MCP4922_PKT_QUEUE_OK;
 }
 
+
+void
+mcp4922_preloaded_pkt_set(mcp4922_preloaded_pkt* pkt, uint8_t pin,
+			  port_ptr port, mcp4922_channel ch, uint16_t value,
+			  bool shutdown)
+{
+  spim_frame_set(&(pkt->frame), pin, port, 2, pkt->data);
+  set_data(pkt->data, ch, value, shutdown);
+}
+
+
+void mcp4922_preloaded_pkt_send(mcp4922_preloaded_pkt* pkt)
+{
+  spim_frame_send(&(pkt->frame));
+}
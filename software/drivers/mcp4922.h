@@ -33,7 +33,12 @@
  * Not all features are supported, in particular:
  * - BUF is always set to 0, hence the input buffer amplifier is disabled
  * - ~GA is always set to 1, hence the output voltage doubler is disabled
- * - ~SHDN is always set to 1, hence the output buffer cannot be shut down
+ * - ~SHDN is always set to 1 in regular packets, hence the output buffer can
+ *   only be shut down using a preloaded packet
+ *
+ * Preloaded packets are prepared in advance and can be sent from an ISR,
+ * bypassing the SPI transfer queue. They are meant for protection actions such
+ * as setting an output to zero as soon as an overcurrent is detected.
  */
 
 #include <stdbool.h>
@@ -62,6 +67,15 @@ typedef struct {
 } mcp4922_pkt;
 
 
+/**
+ * The MCP4922 preloaded packet data structure.
+ */
+typedef struct {
+  uint8_t data[2];
+  spim_frame frame;
+} mcp4922_preloaded_pkt;
+
+
 
 /**
  * Initialize the MCP4922 driver.
@@ -109,6 +123,16 @@ mcp4922_pkt_set(mcp4922_pkt* pkt, uint8_t pin, port_ptr port,
 bool mcp4922_pkt_is_in_transmission(mcp4922_pkt* pkt);
 
 
+/**
+ * Return whether the MCP4922 packet is in the transfer queue, either waiting
+ * or in transmission.
+ *
+ * @param pkt  The MCP4922 packet for which to get the queue status
+ * @return true if the packet is queued, false otherwise.
+ */
+bool mcp4922_pkt_is_queued(mcp4922_pkt* pkt);
+
+
 /**
  * Queue an MCP4922 packet for transmission.
  *
@@ -125,5 +149,38 @@ bool mcp4922_pkt_is_in_transmission(mcp4922_pkt* pkt);
 mcp4922_pkt_queue_status mcp4922_pkt_queue(mcp4922_pkt* pkt);
 
 
+/**
+ * Configure an MCP4922 preloaded packet data structure.
+ *
+ * This function should not be called on a packet that can be sent
+ * concurrently, for example from an ISR.
+ *
+ * @param pkt       The MCP4922 preloaded packet data structure to configure
+ * @param pin       The number of the pin connected to the MCP4922's CS pin
+ * @param port      The port of the pin connected to the MCP4922's CS pin
+ * @param ch        The output channel to set
+ * @param value     The output value for the channel (only the 12 LSB's are
+ *                  used)
+ * @param shutdown  Whether to shut down the channel's output buffer, in which
+ *                  case the output is pulled to ground through 500 kOhm
+ */
+void
+mcp4922_preloaded_pkt_set(mcp4922_preloaded_pkt* pkt, uint8_t pin,
+			  port_ptr port, mcp4922_channel ch, uint16_t value,
+			  bool shutdown);
+
+
+/**
+ * Send an MCP4922 preloaded packet immediately.
+ *
+ * The packet bypasses the SPI transfer queue and aborts the transfer in
+ * transmission, if any (see spim_frame_send()). This function can be called
+ * from an ISR and returns once the packet has been sent.
+ *
+ * @param pkt  The MCP4922 preloaded packet to send
+ */
+void mcp4922_preloaded_pkt_send(mcp4922_preloaded_pkt* pkt);
+
+
 
 #endif
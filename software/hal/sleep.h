@@ -0,0 +1,45 @@
+/*
+ * sleep.h
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SLEEP_H
+#define SLEEP_H
+
+/**
+ * @file sleep.h
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ *
+ * Sleep mode control. To go to sleep without missing wake-up interrupts,
+ * disable interrupts, check whether there is anything left to do and then
+ * execute SLEEP_ENABLE(), ENABLE_INTERRUPTS() and SLEEP_CPU() in that order.
+ * The instruction following the one that enables interrupts is always
+ * executed before any pending interrupt is handled.
+ */
+
+#include <avr/sleep.h>
+
+// Modes: IDLE, ADC, PWR_DOWN, PWR_SAVE, STANDBY, EXT_STANDBY
+#define SLEEP_SET_MODE(mode)  set_sleep_mode(SLEEP_MODE_##mode)
+#define SLEEP_ENABLE()        sleep_enable()
+#define SLEEP_DISABLE()       sleep_disable()
+#define SLEEP_CPU()           sleep_cpu()
+
+#endif
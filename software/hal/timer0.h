@@ -33,6 +33,9 @@
 #define TIMER0_OCA_INTR_ENABLE   TIMSK0 |= _BV(OCIE0A)
 #define TIMER0_OCB_INTR_ENABLE   TIMSK0 |= _BV(OCIE0B)
 #define TIMER0_OVF_INTR_ENABLE   TIMSK0 |= _BV(TOIE0)
+#define TIMER0_OCA_INTR_DISABLE  TIMSK0 &= ~_BV(OCIE0A)
+#define TIMER0_OCB_INTR_DISABLE  TIMSK0 &= ~_BV(OCIE0B)
+#define TIMER0_OVF_INTR_DISABLE  TIMSK0 &= ~_BV(TOIE0)
 
 // Modes
 #define TIMER0_SET_MODE_NORMAL					\
@@ -119,6 +122,10 @@
 #define TIMER0_IS_OCA_INTERRUPT_FLAG_SET  (TIFR0 & _BV(OCF0A))
 #define TIMER0_IS_OCB_INTERRUPT_FLAG_SET  (TIFR0 & _BV(OCF0B))
 #define TIMER0_IS_OVF_INTERRUPT_FLAG_SET  (TIFR0 & _BV(TOV0))
+// Interrupt flags are cleared by writing a one to them
+#define TIMER0_CLEAR_OCA_INTERRUPT_FLAG   TIFR0 = _BV(OCF0A)
+#define TIMER0_CLEAR_OCB_INTERRUPT_FLAG   TIFR0 = _BV(OCF0B)
+#define TIMER0_CLEAR_OVF_INTERRUPT_FLAG   TIFR0 = _BV(TOV0)
 
 // Constants
 #define TIMER0_SIZE         8
@@ -0,0 +1,111 @@
+/*
+ * timer1.h
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIMER1_H
+#define TIMER1_H
+
+// Operations
+#define TIMER1_INIT
+
+// Output channels
+#define TIMER1_OCA_DISCONNECT   TCCR1A &= ~(_BV(COM1A1) | _BV(COM1A0))
+#define TIMER1_OCB_DISCONNECT   TCCR1A &= ~(_BV(COM1B1) | _BV(COM1B0))
+
+// Interrupts
+#define TIMER1_OCA_INTR_ENABLE   TIMSK1 |= _BV(OCIE1A)
+#define TIMER1_OCB_INTR_ENABLE   TIMSK1 |= _BV(OCIE1B)
+#define TIMER1_OVF_INTR_ENABLE   TIMSK1 |= _BV(TOIE1)
+#define TIMER1_OCA_INTR_DISABLE  TIMSK1 &= ~_BV(OCIE1A)
+#define TIMER1_OCB_INTR_DISABLE  TIMSK1 &= ~_BV(OCIE1B)
+#define TIMER1_OVF_INTR_DISABLE  TIMSK1 &= ~_BV(TOIE1)
+
+// Modes
+#define _TIMER1_SET_WGM(wgm13, wgm12, wgm11, wgm10)			\
+  do {									\
+    TCCR1A = (TCCR1A & ~(_BV(WGM11) | _BV(WGM10)))			\
+      | ((wgm11) << WGM11) | ((wgm10) << WGM10);			\
+    TCCR1B = (TCCR1B & ~(_BV(WGM13) | _BV(WGM12)))			\
+      | ((wgm13) << WGM13) | ((wgm12) << WGM12);			\
+  } while (0)
+
+#define TIMER1_SET_MODE_NORMAL                    _TIMER1_SET_WGM(0,0,0,0)
+#define TIMER1_SET_MODE_CTC_OCRA                  _TIMER1_SET_WGM(0,1,0,0)
+#define TIMER1_SET_MODE_CTC_ICR                   _TIMER1_SET_WGM(1,1,0,0)
+#define TIMER1_SET_MODE_FAST_PWM_0FF              _TIMER1_SET_WGM(0,1,0,1)
+#define TIMER1_SET_MODE_FAST_PWM_1FF              _TIMER1_SET_WGM(0,1,1,0)
+#define TIMER1_SET_MODE_FAST_PWM_3FF              _TIMER1_SET_WGM(0,1,1,1)
+#define TIMER1_SET_MODE_FAST_PWM_ICR              _TIMER1_SET_WGM(1,1,1,0)
+#define TIMER1_SET_MODE_FAST_PWM_OCRA             _TIMER1_SET_WGM(1,1,1,1)
+#define TIMER1_SET_MODE_PWM_PHASE_CORRECT_0FF     _TIMER1_SET_WGM(0,0,0,1)
+#define TIMER1_SET_MODE_PWM_PHASE_CORRECT_1FF     _TIMER1_SET_WGM(0,0,1,0)
+#define TIMER1_SET_MODE_PWM_PHASE_CORRECT_3FF     _TIMER1_SET_WGM(0,0,1,1)
+#define TIMER1_SET_MODE_PWM_PHASE_CORRECT_ICR     _TIMER1_SET_WGM(1,0,1,0)
+#define TIMER1_SET_MODE_PWM_PHASE_CORRECT_OCRA    _TIMER1_SET_WGM(1,0,1,1)
+#define TIMER1_SET_MODE_PWM_PHASE_AND_FREQ_CORRECT_ICR  _TIMER1_SET_WGM(1,0,0,0)
+#define TIMER1_SET_MODE_PWM_PHASE_AND_FREQ_CORRECT_OCRA _TIMER1_SET_WGM(1,0,0,1)
+
+
+// Clock sources
+#define _TIMER1_SET_CS(cs)						\
+  TCCR1B = (TCCR1B & ~(_BV(CS12) | _BV(CS11) | _BV(CS10))) | (cs)
+
+#define TIMER1_DISABLE TIMER1_SET_CLOCK_DISABLED
+#define TIMER1_SET_CLOCK_DISABLED        _TIMER1_SET_CS(0)
+#define TIMER1_SET_CLOCK_FULL_SPEED      _TIMER1_SET_CS(_BV(CS10))
+#define TIMER1_SET_CLOCK_PRESCALE_8      _TIMER1_SET_CS(_BV(CS11))
+#define TIMER1_SET_CLOCK_PRESCALE_64     _TIMER1_SET_CS(_BV(CS11) | _BV(CS10))
+#define TIMER1_SET_CLOCK_PRESCALE_256    _TIMER1_SET_CS(_BV(CS12))
+#define TIMER1_SET_CLOCK_PRESCALE_1024   _TIMER1_SET_CS(_BV(CS12) | _BV(CS10))
+#define TIMER1_SET_CLOCK_EXT_FALLING     _TIMER1_SET_CS(_BV(CS12) | _BV(CS11))
+#define TIMER1_SET_CLOCK_EXT_RISING				\
+  _TIMER1_SET_CS(_BV(CS12) | _BV(CS11) | _BV(CS10))
+
+
+// 16-bit registers: avr-gcc takes care of using the temporary high byte
+// register in the right order, but accesses must not be interrupted by code
+// that accesses another 16-bit register of the same timer.
+#define TIMER1_OCA_SET_OCR(val)  OCR1A = val
+#define TIMER1_OCA_GET_OCR       OCR1A
+#define TIMER1_OCB_SET_OCR(val)  OCR1B = val
+#define TIMER1_OCB_GET_OCR       OCR1B
+#define TIMER1_SET_CNTR(val) TCNT1 = val
+#define TIMER1_GET_CNTR      TCNT1
+
+
+#define TIMER1_IS_OCA_INTERRUPT_FLAG_SET  (TIFR1 & _BV(OCF1A))
+#define TIMER1_IS_OCB_INTERRUPT_FLAG_SET  (TIFR1 & _BV(OCF1B))
+#define TIMER1_IS_OVF_INTERRUPT_FLAG_SET  (TIFR1 & _BV(TOV1))
+// Interrupt flags are cleared by writing a one to them
+#define TIMER1_CLEAR_OCA_INTERRUPT_FLAG   TIFR1 = _BV(OCF1A)
+#define TIMER1_CLEAR_OCB_INTERRUPT_FLAG   TIFR1 = _BV(OCF1B)
+#define TIMER1_CLEAR_OVF_INTERRUPT_FLAG   TIFR1 = _BV(TOV1)
+
+// Constants
+#define TIMER1_SIZE         16
+#define TIMER1_MAX_VALUE  65535
+
+// Interrupt vectors
+#define TIMER1_OCA_VECT  TIMER1_COMPA_vect
+#define TIMER1_OCB_VECT  TIMER1_COMPB_vect
+#define TIMER1_OVF_VECT  TIMER1_OVF_vect
+
+
+#endif
@@ -0,0 +1,142 @@
+/*
+ * timer2.h
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIMER2_H
+#define TIMER2_H
+
+// Operations
+#define TIMER2_INIT
+
+// Output channels
+#define TIMER2_OCA_DISCONNECT   TCCR2A &= ~(_BV(COM2A1) | _BV(COM2A0))
+#define TIMER2_OCB_DISCONNECT   TCCR2A &= ~(_BV(COM2B1) | _BV(COM2B0))
+
+// Interrupts
+#define TIMER2_OCA_INTR_ENABLE   TIMSK2 |= _BV(OCIE2A)
+#define TIMER2_OCB_INTR_ENABLE   TIMSK2 |= _BV(OCIE2B)
+#define TIMER2_OVF_INTR_ENABLE   TIMSK2 |= _BV(TOIE2)
+#define TIMER2_OCA_INTR_DISABLE  TIMSK2 &= ~_BV(OCIE2A)
+#define TIMER2_OCB_INTR_DISABLE  TIMSK2 &= ~_BV(OCIE2B)
+#define TIMER2_OVF_INTR_DISABLE  TIMSK2 &= ~_BV(TOIE2)
+
+// Modes
+#define TIMER2_SET_MODE_NORMAL					\
+  do {								\
+    TCCR2B &= ~(_BV(WGM22));					\
+    TCCR2A &= ~(_BV(WGM21) | _BV(WGM20));			\
+  } while (0)
+#define TIMER2_SET_MODE_CTC_OCRA				\
+  do {								\
+    TCCR2B &= ~(_BV(WGM22));					\
+    TCCR2A |= _BV(WGM21);					\
+    TCCR2A &= ~(_BV(WGM20));					\
+  } while (0)
+#define TIMER2_SET_MODE_FAST_PWM_0FF				\
+  do {								\
+    TCCR2B &= ~(_BV(WGM22));					\
+    TCCR2A |= (_BV(WGM21) | _BV(WGM20));			\
+  } while (0)
+#define TIMER2_SET_MODE_FAST_PWM_OCRA				\
+  do {								\
+    TCCR2B |= _BV(WGM22);					\
+    TCCR2A |= (_BV(WGM21) | _BV(WGM20));			\
+  } while (0)
+#define TIMER2_SET_MODE_PWM_PHASE_CORRECT_0FF			\
+  do {								\
+    TCCR2B &= ~(_BV(WGM22));					\
+    TCCR2A &= ~(_BV(WGM21));					\
+    TCCR2A |= _BV(WGM20);					\
+  } while (0)
+#define TIMER2_SET_MODE_PWM_PHASE_CORRECT_OCRA			\
+  do {								\
+    TCCR2B |= _BV(WGM22);					\
+    TCCR2A &= ~(_BV(WGM21));					\
+    TCCR2A |= _BV(WGM20);					\
+  } while (0)
+
+
+// Clock sources
+// Unlike timer0 and timer1, timer2 has no external clock inputs, but it offers
+// additional prescaler values of 32 and 128.
+#define TIMER2_DISABLE TIMER2_SET_CLOCK_DISABLED
+#define TIMER2_SET_CLOCK_DISABLED			\
+  TCCR2B &= ~(_BV(CS22) | _BV(CS21) | _BV(CS20))
+#define TIMER2_SET_CLOCK_FULL_SPEED		\
+  do {						\
+    TCCR2B &= ~(_BV(CS22) | _BV(CS21));		\
+    TCCR2B |= _BV(CS20);			\
+  } while (0)
+#define TIMER2_SET_CLOCK_PRESCALE_8		\
+  do {						\
+    TCCR2B &= ~(_BV(CS22) | _BV(CS20));		\
+    TCCR2B |= _BV(CS21);			\
+  } while (0)
+#define TIMER2_SET_CLOCK_PRESCALE_32		\
+  do {						\
+    TCCR2B &= ~(_BV(CS22));			\
+    TCCR2B |= (_BV(CS21) | _BV(CS20));		\
+  } while (0)
+#define TIMER2_SET_CLOCK_PRESCALE_64		\
+  do {						\
+    TCCR2B |= _BV(CS22);			\
+    TCCR2B &= ~(_BV(CS21) | _BV(CS20));		\
+  } while (0)
+#define TIMER2_SET_CLOCK_PRESCALE_128		\
+  do {						\
+    TCCR2B |= (_BV(CS22) | _BV(CS20));		\
+    TCCR2B &= ~(_BV(CS21));			\
+  } while (0)
+#define TIMER2_SET_CLOCK_PRESCALE_256		\
+  do {						\
+    TCCR2B |= (_BV(CS22) | _BV(CS21));		\
+    TCCR2B &= ~(_BV(CS20));			\
+  } while (0)
+#define TIMER2_SET_CLOCK_PRESCALE_1024		\
+  TCCR2B |= (_BV(CS22) | _BV(CS21) | _BV(CS20))
+
+
+#define TIMER2_OCA_SET_OCR(val)  OCR2A = val
+#define TIMER2_OCA_GET_OCR       OCR2A
+#define TIMER2_OCB_SET_OCR(val)  OCR2B = val
+#define TIMER2_OCB_GET_OCR       OCR2B
+#define TIMER2_SET_CNTR(val) TCNT2 = val
+#define TIMER2_GET_CNTR      TCNT2
+
+
+#define TIMER2_IS_OCA_INTERRUPT_FLAG_SET  (TIFR2 & _BV(OCF2A))
+#define TIMER2_IS_OCB_INTERRUPT_FLAG_SET  (TIFR2 & _BV(OCF2B))
+#define TIMER2_IS_OVF_INTERRUPT_FLAG_SET  (TIFR2 & _BV(TOV2))
+// Interrupt flags are cleared by writing a one to them
+#define TIMER2_CLEAR_OCA_INTERRUPT_FLAG   TIFR2 = _BV(OCF2A)
+#define TIMER2_CLEAR_OCB_INTERRUPT_FLAG   TIFR2 = _BV(OCF2B)
+#define TIMER2_CLEAR_OVF_INTERRUPT_FLAG   TIFR2 = _BV(TOV2)
+
+// Constants
+#define TIMER2_SIZE         8
+#define TIMER2_MAX_VALUE  255
+
+// Interrupt vectors
+#define TIMER2_OCA_VECT  TIMER2_COMPA_vect
+#define TIMER2_OCB_VECT  TIMER2_COMPB_vect
+#define TIMER2_OVF_VECT  TIMER2_OVF_vect
+
+
+#endif
@@ -69,13 +69,14 @@
 
 #include "util/pp_magic.h"
 #include "hal/timer0.h"
-//#include "hal/timer1.h"
-//#include "hal/timer2.h"
+#include "hal/timer1.h"
+#include "hal/timer2.h"
 
 // Operations
 #define TMR_INIT(tmr)                   CAT(tmr,_INIT)
 #define TMR_CHANNEL_DISCONNECT(tmr,ch)  CAT(tmr,_,ch,_DISCONNECT)
 #define TMR_INTERRUPT_ENABLE(tmr,intr)  CAT(tmr,_,intr,_INTR_ENABLE)
+#define TMR_INTERRUPT_DISABLE(tmr,intr) CAT(tmr,_,intr,_INTR_DISABLE)
 #define TMR_SET_MODE(tmr,mode)          CAT(tmr,_SET_MODE_,mode)
 #define TMR_DISABLE(tmr)                CAT(tmr,_DISABLE)
 #define TMR_SET_PRESCALER(tmr,val)      TMR_SET_CLOCK(tmr, CAT(PRESCALE_,val))
@@ -87,6 +88,8 @@
 
 #define TMR_IS_INTERRUPT_FLAG_SET(tmr,intr)	\
   CAT(tmr,_IS_,intr,_INTERRUPT_FLAG_SET)
+#define TMR_CLEAR_INTERRUPT_FLAG(tmr,intr)	\
+  CAT(tmr,_CLEAR_,intr,_INTERRUPT_FLAG)
 
 // Constants
 #define TMR_SIZE(tmr)                   CAT(tmr,_SIZE)
@@ -0,0 +1,128 @@
+/*
+ * adc_bench.c
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file adc_bench.c
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ *
+ * Benchmark of the ADC module. The measurement rates are expressed in
+ * simulated time, where the mock ADC converts at ADC_CONVERSION_RATE.
+ */
+
+#include "adc_bench.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "bench.h"
+#include "core/adc.h"
+#include "core/clock.h"
+#include "core/events.h"
+#include "core/process.h"
+#include "hal/adc.h"
+
+#define MAX_CHANNELS 8
+#define NB_CONVERSIONS 200000
+#define NB_TOGGLES 20000
+#define DRAIN_INTERVAL 4 // Conversions, keeps the ISR queue from overflowing
+
+PROCESS(adc_bench_process);
+static process_subscription subscription;
+static unsigned long nb_measurements[MAX_CHANNELS];
+
+PROCESS_THREAD(adc_bench_process)
+{
+  PROCESS_BEGIN();
+
+  while (true) {
+    PROCESS_WAIT_EVENT();
+    if (ev == ADC_MEASUREMENT_COMPLETED) {
+      nb_measurements[adc_get_channel((adc*)data)] += 1;
+    }
+  }
+
+  PROCESS_END();
+}
+
+// Every channel sees a different ramp, so the ISR sums varying samples
+static uint16_t ramp[64];
+
+void adc_bench(void)
+{
+  static adc adcs[MAX_CHANNELS];
+  char name[64];
+
+  for (unsigned int i = 0; i < 64; ++i) {
+    ramp[i] = i * 16;
+  }
+
+  for (unsigned int n = 1; n <= MAX_CHANNELS; ++n) {
+    adc_mock_init();
+    clock_init();
+    process_init();
+    init_adc();
+    process_start(&adc_bench_process);
+    process_subscription_init(&subscription, &adc_bench_process,
+			      ADC_MEASUREMENT_COMPLETED, PROCESS_TOPIC_ALL_TAGS);
+    process_subscribe(&adc_measurement_topic, &subscription);
+
+    for (unsigned int ch = 0; ch < n; ++ch) {
+      adc_init(&adcs[ch], ch, ADC_RESOLUTION_12BIT, ADC_SKIP_0);
+      adc_mock_set_waveform(ch, ramp, 64, ch + 1);
+      adc_enable(&adcs[ch]);
+      nb_measurements[ch] = 0;
+    }
+    while (process_execute()) { }
+
+    // Conversions, timing the ISR only
+    uint64_t isr_ns = 0;
+    unsigned long nb_dispatches = 0;
+    for (unsigned long i = 0; i < NB_CONVERSIONS; i += DRAIN_INTERVAL) {
+      uint64_t start = bench_now_ns();
+      adc_mock_convert(DRAIN_INTERVAL);
+      isr_ns += bench_now_ns() - start;
+      while (process_execute()) {
+	nb_dispatches += 1;
+      }
+    }
+
+    unsigned long total = 0;
+    for (unsigned int ch = 0; ch < n; ++ch) {
+      total += nb_measurements[ch];
+    }
+    double seconds = (double)NB_CONVERSIONS / ADC_CONVERSION_RATE;
+
+    // Enabling and disabling the last channel, with the others enabled
+    uint64_t start = bench_now_ns();
+    for (unsigned int i = 0; i < NB_TOGGLES; ++i) {
+      adc_disable(&adcs[n - 1]);
+      adc_enable(&adcs[n - 1]);
+    }
+    double toggle_ns = (double)(bench_now_ns() - start) / NB_TOGGLES;
+
+    snprintf(name, sizeof(name), "adc, %u channels", n);
+    BENCH_REPORT(name, "%7.1f meas/s/ch  %5.2f dispatches/meas  "
+		 "%6.1f ns/conversion  %6.1f ns/enable+disable",
+		 total / seconds / n, (double)nb_dispatches / total,
+		 (double)isr_ns / NB_CONVERSIONS, toggle_ns);
+  }
+}
@@ -0,0 +1,39 @@
+/*
+ * adc_bench.h
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ADC_BENCH_H
+#define ADC_BENCH_H
+
+/**
+ * @file adc_bench.h
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ */
+
+/**
+ * Measure the ADC module with 1 to 8 enabled channels: the measurement rate
+ * per channel, the number of scheduler dispatches per measurement, the host
+ * time per conversion spent in the ISR and the cost of enabling and disabling
+ * an ADC measurement.
+ */
+void adc_bench(void);
+
+#endif
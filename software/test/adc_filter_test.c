@@ -0,0 +1,211 @@
+/*
+ * adc_filter_test.c
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * @file adc_filter_test.c
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ *
+ * Unit tests for the ADC filter stages.
+ */
+
+#include "adc_filter_test.h"
+
+#include <check.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "core/adc_filter.h"
+
+static void setup(void)
+{ }
+
+static void teardown(void)
+{ }
+
+// ****************************************************************************
+//                           test_adc_filter_init
+// ****************************************************************************
+START_TEST(test_adc_filter_init)
+{
+  adc_filter f;
+  uint16_t window[64];
+  ck_assert(adc_filter_iir_init(&f, 0) == ADC_FILTER_INIT_INVALID_PARAMETER);
+  ck_assert(adc_filter_iir_init(&f, ADC_FILTER_IIR_MAX_SHIFT + 1)
+	    == ADC_FILTER_INIT_INVALID_PARAMETER);
+  ck_assert(adc_filter_iir_init(&f, ADC_FILTER_IIR_MAX_SHIFT)
+	    == ADC_FILTER_INIT_OK);
+
+  ck_assert(adc_filter_median_init(&f, window, 4)
+	    == ADC_FILTER_INIT_INVALID_PARAMETER);
+  ck_assert(adc_filter_median_init(&f, NULL, 3)
+	    == ADC_FILTER_INIT_INVALID_BUFFER);
+  ck_assert(adc_filter_median_init(&f, window, 5) == ADC_FILTER_INIT_OK);
+
+  ck_assert(adc_filter_moving_average_init(&f, window, 0)
+	    == ADC_FILTER_INIT_INVALID_PARAMETER);
+  ck_assert(adc_filter_moving_average_init(&f, window, 7)
+	    == ADC_FILTER_INIT_INVALID_PARAMETER);
+  ck_assert(adc_filter_moving_average_init(&f, NULL, 2)
+	    == ADC_FILTER_INIT_INVALID_BUFFER);
+  ck_assert(adc_filter_moving_average_init(&f, window, 6)
+	    == ADC_FILTER_INIT_OK);
+}
+END_TEST
+
+// ****************************************************************************
+//                           test_adc_filter_iir
+// ****************************************************************************
+START_TEST(test_adc_filter_iir)
+{
+  adc_filter f;
+  adc_filter_iir_init(&f, 2);
+
+  // The first value primes the filter
+  ck_assert_uint_eq(adc_filter_apply(&f, 1000), 1000);
+  ck_assert_uint_eq(adc_filter_apply(&f, 1000), 1000);
+
+  // Each step moves a quarter of the way towards the input
+  ck_assert_uint_eq(adc_filter_apply(&f, 2000), 1250);
+  ck_assert_uint_eq(adc_filter_apply(&f, 2000), 1437);
+
+  // The output converges to the input without an offset
+  unsigned int i;
+  for (i = 0; i < 100; ++i) {
+    adc_filter_apply(&f, 2000);
+  }
+  ck_assert_uint_eq(adc_filter_apply(&f, 2000), 2000);
+
+  // No overflow at full scale
+  adc_filter_iir_init(&f, ADC_FILTER_IIR_MAX_SHIFT);
+  adc_filter_apply(&f, UINT16_MAX);
+  ck_assert_uint_eq(adc_filter_apply(&f, UINT16_MAX), UINT16_MAX);
+
+  adc_filter_reset(&f);
+  ck_assert_uint_eq(adc_filter_apply(&f, 5), 5);
+}
+END_TEST
+
+// ****************************************************************************
+//                           test_adc_filter_median
+// ****************************************************************************
+START_TEST(test_adc_filter_median)
+{
+  adc_filter f;
+  uint16_t window[5];
+
+  // A single spike is rejected by a 3-tap median
+  adc_filter_median_init(&f, window, 3);
+  ck_assert_uint_eq(adc_filter_apply(&f, 100), 100);
+  ck_assert_uint_eq(adc_filter_apply(&f, 60000), 100);
+  ck_assert_uint_eq(adc_filter_apply(&f, 101), 101);
+  ck_assert_uint_eq(adc_filter_apply(&f, 102), 102);
+
+  // Two consecutive spikes are rejected by a 5-tap median
+  adc_filter_median_init(&f, window, 5);
+  ck_assert_uint_eq(adc_filter_apply(&f, 100), 100);
+  ck_assert_uint_eq(adc_filter_apply(&f, 0), 100);
+  ck_assert_uint_eq(adc_filter_apply(&f, 0), 100);
+  ck_assert_uint_eq(adc_filter_apply(&f, 103), 100);
+  ck_assert_uint_eq(adc_filter_apply(&f, 104), 100);
+  ck_assert_uint_eq(adc_filter_apply(&f, 105), 103);
+
+  // Compare with a sorted window
+  unsigned int i, j, k;
+  uint16_t last[5];
+  srand(1);
+  for (i = 0; i < 1000; ++i) {
+    uint16_t x = rand() % 1024;
+    uint16_t y = adc_filter_apply(&f, x);
+    for (j = 4; j > 0; --j) {
+      last[j] = last[j - 1];
+    }
+    last[0] = x;
+    if (i >= 4) {
+      uint16_t sorted[5];
+      for (j = 0; j < 5; ++j) {
+	sorted[j] = last[j];
+	for (k = j; k > 0 && sorted[k - 1] > sorted[k]; --k) {
+	  uint16_t tmp = sorted[k];
+	  sorted[k] = sorted[k - 1];
+	  sorted[k - 1] = tmp;
+	}
+      }
+      ck_assert_uint_eq(y, sorted[2]);
+    }
+  }
+}
+END_TEST
+
+// ****************************************************************************
+//                           test_adc_filter_moving_average
+// ****************************************************************************
+START_TEST(test_adc_filter_moving_average)
+{
+  adc_filter f;
+  uint16_t window[64];
+  adc_filter_moving_average_init(&f, window, 2);
+
+  ck_assert_uint_eq(adc_filter_apply(&f, 400), 400);
+  ck_assert_uint_eq(adc_filter_apply(&f, 800), 500);
+  ck_assert_uint_eq(adc_filter_apply(&f, 800), 600);
+  ck_assert_uint_eq(adc_filter_apply(&f, 800), 700);
+  ck_assert_uint_eq(adc_filter_apply(&f, 800), 800);
+  ck_assert_uint_eq(adc_filter_apply(&f, 0), 600);
+
+  // No overflow at full scale with the longest window
+  adc_filter_moving_average_init(&f, window,
+				 ADC_FILTER_MOVING_AVERAGE_MAX_LOG2_LENGTH);
+  unsigned int i;
+  for (i = 0; i < 100; ++i) {
+    ck_assert_uint_eq(adc_filter_apply(&f, UINT16_MAX), UINT16_MAX);
+  }
+}
+END_TEST
+
+
+Suite *adc_filter_suite(void)
+{
+  Suite *s = suite_create("Adc filter");
+
+  TCase *tc_init = tcase_create("Init");
+  tcase_add_checked_fixture(tc_init, setup, teardown);
+  tcase_add_test(tc_init, test_adc_filter_init);
+  suite_add_tcase(s, tc_init);
+
+  TCase *tc_iir = tcase_create("IIR");
+  tcase_add_checked_fixture(tc_iir, setup, teardown);
+  tcase_add_test(tc_iir, test_adc_filter_iir);
+  suite_add_tcase(s, tc_iir);
+
+  TCase *tc_median = tcase_create("Median");
+  tcase_add_checked_fixture(tc_median, setup, teardown);
+  tcase_add_test(tc_median, test_adc_filter_median);
+  suite_add_tcase(s, tc_median);
+
+  TCase *tc_average = tcase_create("Moving average");
+  tcase_add_checked_fixture(tc_average, setup, teardown);
+  tcase_add_test(tc_average, test_adc_filter_moving_average);
+  suite_add_tcase(s, tc_average);
+
+  return s;
+}
@@ -0,0 +1,933 @@
+/*
+ * adc_test.c
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * @file adc_test.c
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ *
+ * Unit tests for the ADC module.
+ */
+
+#include "adc_test.h"
+
+#include <check.h>
+#include "core/adc.h"
+#include "core/clock.h"
+#include "core/etimer.h"
+#include "core/events.h"
+#include "core/process.h"
+#include "core/rtimer.h"
+#include "hal/adc.h"
+#include "hal/sleep.h"
+
+#define MAX_MEASUREMENTS 16
+
+PROCESS(adc_test_process);
+static process_subscription subscription;
+static adc* measured[MAX_MEASUREMENTS];
+static uint16_t measured_value[MAX_MEASUREMENTS];
+static unsigned int nb_measurements;
+static adc_capture* completed_capture;
+static unsigned int nb_captures_completed;
+static adc_group* completed_group;
+static unsigned int nb_groups_completed;
+
+static void setup(void)
+{
+  adc_mock_init();
+  clock_init();
+  process_init();
+  init_adc();
+  process_start(&adc_test_process);
+  process_subscription_init(&subscription, &adc_test_process,
+			    ADC_MEASUREMENT_COMPLETED, PROCESS_TOPIC_ALL_TAGS);
+  process_subscribe(&adc_measurement_topic, &subscription);
+  nb_measurements = 0;
+  completed_capture = NULL;
+  nb_captures_completed = 0;
+  completed_group = NULL;
+  nb_groups_completed = 0;
+}
+
+static void teardown(void)
+{ }
+
+PROCESS_THREAD(adc_test_process)
+{
+  PROCESS_BEGIN();
+
+  while (true) {
+    PROCESS_WAIT_EVENT();
+    if (ev == ADC_MEASUREMENT_COMPLETED) {
+      if (nb_measurements < MAX_MEASUREMENTS) {
+	measured[nb_measurements] = (adc*)data;
+	measured_value[nb_measurements] = adc_get_value((adc*)data);
+      }
+      nb_measurements += 1;
+    } else if (ev == ADC_CAPTURE_COMPLETED) {
+      completed_capture = (adc_capture*)data;
+      nb_captures_completed += 1;
+    } else if (ev == ADC_GROUP_COMPLETED) {
+      completed_group = (adc_group*)data;
+      nb_groups_completed += 1;
+    }
+  }
+
+  PROCESS_END();
+}
+
+// Run all pending processes, return the number of dispatches
+static unsigned int
+run_processes(void)
+{
+  unsigned int nb_dispatches = 0;
+  while (process_execute()) {
+    nb_dispatches += 1;
+  }
+  return nb_dispatches;
+}
+
+// ****************************************************************************
+//                           test_adc_measurement
+// ****************************************************************************
+START_TEST(test_adc_measurement)
+{
+  adc a;
+  ck_assert(adc_init(&a, ADC_CHANNEL_3, ADC_RESOLUTION_12BIT, ADC_SKIP_0)
+	    == ADC_INIT_OK);
+  ck_assert(adc_enable(&a));
+  adc_mock_set_value(ADC_CHANNEL_3, 0x155);
+  run_processes();
+
+  // Sampling starts three conversions after enabling: the ISR queues the ADC
+  // when the first conversion completes, and by then the channels of the next
+  // two conversions have already been selected. A 12-bit measurement takes 16
+  // samples.
+  adc_mock_convert(3 + 15);
+  run_processes();
+  ck_assert_uint_eq(nb_measurements, 0);
+  ck_assert_uint_eq(adc_mock_get_nb_conversions(ADC_CHANNEL_3), 15);
+  adc_mock_convert(1);
+  run_processes();
+  ck_assert_uint_eq(nb_measurements, 1);
+  ck_assert(measured[0] == &a);
+  ck_assert_uint_eq(measured_value[0], (16 * 0x155) << 2);
+  ck_assert_uint_eq(adc_get_value(&a), (16 * 0x155) << 2);
+
+  // The next measurement starts right away
+  adc_mock_set_value(ADC_CHANNEL_3, 0x3FF);
+  adc_mock_convert(16);
+  run_processes();
+  ck_assert_uint_eq(nb_measurements, 2);
+  ck_assert_uint_eq(measured_value[1], 0xFFC0);
+}
+END_TEST
+
+// ****************************************************************************
+//                           test_adc_scheduler_traffic
+// ****************************************************************************
+START_TEST(test_adc_scheduler_traffic)
+{
+  adc a;
+  adc_init(&a, ADC_CHANNEL_1, ADC_RESOLUTION_15BIT, ADC_SKIP_0);
+  adc_enable(&a);
+  run_processes();
+  adc_mock_convert(3);
+
+  // Samples are accumulated by the ISR, the scheduler is only involved once
+  // per measurement (to dispatch the message to the subscriber)
+  unsigned int nb_dispatches = 0;
+  for (unsigned int i = 0; i < 4 * 1024; ++i) {
+    adc_mock_convert(1);
+    nb_dispatches += run_processes();
+  }
+  ck_assert_uint_eq(nb_measurements, 4);
+  ck_assert_uint_le(nb_dispatches, 2 * 4);
+}
+END_TEST
+
+// ****************************************************************************
+//                           test_adc_waveform
+// ****************************************************************************
+START_TEST(test_adc_waveform)
+{
+  static const uint16_t alternating[] = {100, 300};
+  static const uint16_t square[] = {0, 400};
+  adc a, b;
+  adc_init(&a, ADC_CHANNEL_2, ADC_RESOLUTION_12BIT, ADC_SKIP_0);
+  adc_init(&b, ADC_CHANNEL_4, ADC_RESOLUTION_12BIT, ADC_SKIP_0);
+
+  // A measurement averages over the samples of the waveform it sees
+  adc_mock_set_waveform(ADC_CHANNEL_2, alternating, 2, 1);
+  adc_enable(&a);
+  adc_mock_convert(3 + 16);
+  run_processes();
+  ck_assert_uint_eq(nb_measurements, 1);
+  ck_assert_uint_eq(measured_value[0], (16 * 200) << 2);
+
+  // The waveform follows the time of the conversions, not the number of
+  // samples of the channel. With two channels, a 12-bit measurement spans two
+  // periods of a square wave of 16 conversions.
+  adc_mock_set_waveform(ADC_CHANNEL_2, square, 2, 8);
+  adc_mock_set_value(ADC_CHANNEL_4, 1);
+  adc_enable(&b);
+  adc_mock_convert(3 + 64);
+  run_processes();
+  ck_assert_uint_eq(adc_get_value(&a), (16 * 200) << 2);
+  ck_assert_uint_eq(adc_get_value(&b), 16 << 2);
+  ck_assert_uint_eq(adc_mock_get_nb_total_conversions(), 3 + 16 + 3 + 64);
+}
+END_TEST
+
+// ****************************************************************************
+//                           test_adc_channels
+// ****************************************************************************
+START_TEST(test_adc_channels)
+{
+  adc a0, a5;
+  adc_init(&a0, ADC_CHANNEL_0, ADC_RESOLUTION_10BIT, ADC_SKIP_0);
+  adc_init(&a5, ADC_CHANNEL_5, ADC_RESOLUTION_11BIT, ADC_SKIP_0);
+  adc_mock_set_value(ADC_CHANNEL_0, 100);
+  adc_mock_set_value(ADC_CHANNEL_5, 200);
+  adc_enable(&a5);
+  adc_enable(&a0);
+  ck_assert(! adc_enable(&a0));
+
+  // Channels are sampled alternately
+  adc_mock_convert(3 + 2 * 4);
+  run_processes();
+  ck_assert_uint_eq(adc_mock_get_nb_conversions(ADC_CHANNEL_0), 4);
+  ck_assert_uint_eq(adc_mock_get_nb_conversions(ADC_CHANNEL_5), 4);
+  ck_assert_uint_eq(nb_measurements, 5);
+  ck_assert_uint_eq(adc_get_value(&a0), 100 << 6);
+  ck_assert_uint_eq(adc_get_value(&a5), (4 * 200) << 4);
+
+  // A disabled ADC is no longer measured, and no longer sampled once the
+  // conversions that were already queued for it have completed
+  ck_assert(adc_disable(&a0));
+  ck_assert(! adc_disable(&a0));
+  adc_mock_convert(8);
+  run_processes();
+  for (unsigned int i = 5; i < nb_measurements; ++i) {
+    ck_assert(measured[i] == &a5);
+  }
+
+  unsigned int nb_ch0 = adc_mock_get_nb_conversions(ADC_CHANNEL_0);
+  unsigned int nb_ch5 = adc_mock_get_nb_conversions(ADC_CHANNEL_5);
+  nb_measurements = 0;
+  adc_mock_convert(16);
+  run_processes();
+  ck_assert_uint_eq(adc_mock_get_nb_conversions(ADC_CHANNEL_0), nb_ch0);
+  ck_assert_uint_eq(adc_mock_get_nb_conversions(ADC_CHANNEL_5), nb_ch5 + 16);
+  ck_assert_uint_eq(nb_measurements, 4);
+  for (unsigned int i = 0; i < 4; ++i) {
+    ck_assert(measured[i] == &a5);
+  }
+}
+END_TEST
+
+
+// ****************************************************************************
+//                           test_adc_filter
+// ****************************************************************************
+START_TEST(test_adc_filter)
+{
+  adc a;
+  adc_filter median, iir;
+  uint16_t window[3];
+  adc_init(&a, ADC_CHANNEL_2, ADC_RESOLUTION_10BIT, ADC_SKIP_0);
+  adc_filter_median_init(&median, window, 3);
+  adc_filter_iir_init(&iir, 1);
+  ck_assert(adc_add_filter(&a, &median));
+  ck_assert(adc_add_filter(&a, &iir));
+  adc_mock_set_value(ADC_CHANNEL_2, 100);
+  adc_enable(&a);
+  ck_assert(! adc_add_filter(&a, &iir));
+
+  adc_mock_convert(3 + 1);
+  ck_assert_uint_eq(adc_get_value(&a), 100 << 6);
+
+  // The spike is rejected by the median stage
+  adc_mock_set_value(ADC_CHANNEL_2, 1000);
+  adc_mock_convert(1);
+  ck_assert_uint_eq(adc_get_value(&a), 100 << 6);
+
+  // The step is smoothed by the IIR stage
+  adc_mock_set_value(ADC_CHANNEL_2, 200);
+  adc_mock_convert(1);
+  ck_assert_uint_eq(adc_get_value(&a), 150 << 6);
+  adc_mock_convert(1);
+  ck_assert_uint_eq(adc_get_value(&a), 175 << 6);
+
+  // Enabling the ADC again resets the filter history
+  adc_mock_set_value(ADC_CHANNEL_2, 50);
+  adc_disable(&a);
+  adc_mock_convert(4);
+  adc_enable(&a);
+  adc_mock_convert(3 + 1);
+  ck_assert_uint_eq(adc_get_value(&a), 50 << 6);
+}
+END_TEST
+
+// ****************************************************************************
+//                           test_adc_rates
+// ****************************************************************************
+
+// Do a single conversion and return its channel
+static adc_channel
+convert_one(void)
+{
+  unsigned int before[ADC_MOCK_NB_CHANNELS];
+  unsigned int ch;
+  for (ch = 0; ch < ADC_MOCK_NB_CHANNELS; ++ch) {
+    before[ch] = adc_mock_get_nb_conversions(ch);
+  }
+  adc_mock_convert(1);
+  for (ch = 0; ch < ADC_MOCK_NB_CHANNELS; ++ch) {
+    if (adc_mock_get_nb_conversions(ch) != before[ch]) {
+      break;
+    }
+  }
+  return ch;
+}
+
+START_TEST(test_adc_rates)
+{
+  adc fast, slow, other;
+  adc_init(&fast, ADC_CHANNEL_1, ADC_RESOLUTION_10BIT, ADC_SKIP_0);
+  adc_init(&slow, ADC_CHANNEL_2, ADC_RESOLUTION_12BIT, ADC_SKIP_0);
+  adc_init(&other, ADC_CHANNEL_3, ADC_RESOLUTION_10BIT, ADC_SKIP_0);
+
+  // A 12-bit measurement takes 16 conversions
+  ck_assert(adc_set_rate(&slow, ADC_CONVERSION_RATE / 16 + 1)
+	    == ADC_SET_RATE_TOO_HIGH);
+  ck_assert(adc_set_rate(&fast, ADC_CONVERSION_RATE / 4) == ADC_SET_RATE_OK);
+  ck_assert(adc_set_rate(&slow, 1) == ADC_SET_RATE_OK);
+  ck_assert(fast.slots == ADC_CONF_FRAME_SIZE / 4);
+  ck_assert(slow.slots == 1);
+  ck_assert(adc_enable(&fast));
+  ck_assert(adc_enable(&slow));
+  ck_assert(adc_enable(&other));
+  ck_assert(adc_set_rate(&fast, 1) == ADC_SET_RATE_ENABLED);
+  ck_assert(adc_rates_fit());
+
+  // The reserved slots are spread evenly, the ADC without a target rate gets
+  // the remaining slots
+  adc_mock_convert(3);
+  unsigned int nb[ADC_MOCK_NB_CHANNELS] = {0};
+  unsigned int last_fast = 0, max_gap = 0;
+  unsigned int i;
+  for (i = 0; i < 4 * ADC_CONF_FRAME_SIZE; ++i) {
+    adc_channel ch = convert_one();
+    nb[ch] += 1;
+    if (ch == ADC_CHANNEL_1) {
+      if (i - last_fast > max_gap && nb[ch] > 1) {
+	max_gap = i - last_fast;
+      }
+      last_fast = i;
+    }
+  }
+  ck_assert_uint_eq(nb[ADC_CHANNEL_1], ADC_CONF_FRAME_SIZE);
+  ck_assert_uint_eq(nb[ADC_CHANNEL_2], 4);
+  ck_assert_uint_eq(nb[ADC_CHANNEL_3], 3 * ADC_CONF_FRAME_SIZE - 4);
+  ck_assert_uint_eq(max_gap, 4);
+
+  // Overcommitted rates are reported, and are scaled down to leave a single
+  // slot for the ADC without a target rate
+  adc heavy;
+  adc_init(&heavy, ADC_CHANNEL_4, ADC_RESOLUTION_10BIT, ADC_SKIP_0);
+  ck_assert(adc_set_rate(&heavy, ADC_CONVERSION_RATE) == ADC_SET_RATE_OK);
+  ck_assert(adc_enable(&heavy));
+  ck_assert(! adc_rates_fit());
+  adc_mock_convert(2 * ADC_CONF_FRAME_SIZE);
+  unsigned int nb_ch1 = adc_mock_get_nb_conversions(ADC_CHANNEL_1);
+  unsigned int nb_ch2 = adc_mock_get_nb_conversions(ADC_CHANNEL_2);
+  unsigned int nb_ch3 = adc_mock_get_nb_conversions(ADC_CHANNEL_3);
+  unsigned int nb_ch4 = adc_mock_get_nb_conversions(ADC_CHANNEL_4);
+  adc_mock_convert(ADC_CONF_FRAME_SIZE);
+  ck_assert_uint_gt(adc_mock_get_nb_conversions(ADC_CHANNEL_1), nb_ch1);
+  ck_assert_uint_gt(adc_mock_get_nb_conversions(ADC_CHANNEL_2), nb_ch2);
+  ck_assert_uint_eq(adc_mock_get_nb_conversions(ADC_CHANNEL_3), nb_ch3 + 1);
+  ck_assert_uint_ge(adc_mock_get_nb_conversions(ADC_CHANNEL_4),
+		    nb_ch4 + ADC_CONF_FRAME_SIZE / 2);
+
+  ck_assert(adc_disable(&heavy));
+  ck_assert(adc_rates_fit());
+}
+END_TEST
+
+
+// ****************************************************************************
+//                           test_adc_trip
+// ****************************************************************************
+static unsigned int nb_trips;
+
+static void
+trip_callback(adc* adc, void* ptr)
+{
+  ck_assert(ptr == (void*)adc);
+  nb_trips += 1;
+}
+
+START_TEST(test_adc_trip)
+{
+  adc a;
+  adc_trip trip;
+  adc_init(&a, ADC_CHANNEL_6, ADC_RESOLUTION_12BIT, ADC_SKIP_0);
+  adc_trip_init(&trip, 500, trip_callback, &a);
+  ck_assert(adc_set_trip(&a, &trip));
+  adc_mock_set_value(ADC_CHANNEL_6, 500);
+  adc_enable(&a);
+  ck_assert(! adc_set_trip(&a, NULL));
+  nb_trips = 0;
+
+  adc_mock_convert(3 + 32);
+  ck_assert_uint_eq(nb_trips, 0);
+  ck_assert(! adc_trip_is_tripped(&trip));
+
+  // A single raw sample above the limit trips right away, even though the
+  // measurement is not complete yet
+  run_processes();
+  unsigned int nb = nb_measurements;
+  adc_mock_set_value(ADC_CHANNEL_6, 501);
+  adc_mock_convert(1);
+  ck_assert_uint_eq(nb_trips, 1);
+  ck_assert(adc_trip_is_tripped(&trip));
+  run_processes();
+  ck_assert_uint_eq(nb_measurements, nb);
+
+  // The trip only fires again after it has been rearmed
+  adc_mock_convert(16);
+  ck_assert_uint_eq(nb_trips, 1);
+  adc_trip_rearm(&trip);
+  adc_mock_convert(1);
+  ck_assert_uint_eq(nb_trips, 2);
+}
+END_TEST
+
+
+// ****************************************************************************
+//                           test_adc_group
+// ****************************************************************************
+START_TEST(test_adc_group)
+{
+  adc v, i, other, low;
+  adc_group g;
+  adc_init(&v, ADC_CHANNEL_0, ADC_RESOLUTION_11BIT, ADC_SKIP_0);
+  adc_init(&i, ADC_CHANNEL_5, ADC_RESOLUTION_11BIT, ADC_SKIP_0);
+  adc_init(&other, ADC_CHANNEL_3, ADC_RESOLUTION_10BIT, ADC_SKIP_0);
+  adc_init(&low, ADC_CHANNEL_2, ADC_RESOLUTION_10BIT, ADC_SKIP_0);
+  adc_group_init(&g, &adc_test_process);
+  ck_assert(! adc_group_enable(&g));
+  ck_assert(adc_group_add(&g, &v) == ADC_GROUP_ADD_OK);
+  ck_assert(adc_group_add(&g, &low) == ADC_GROUP_ADD_RESOLUTION_MISMATCH);
+  ck_assert(adc_group_add(&g, &i) == ADC_GROUP_ADD_OK);
+  ck_assert(adc_group_add(&g, &i) == ADC_GROUP_ADD_ALREADY_IN_GROUP);
+  ck_assert(adc_set_rate(&i, 1) == ADC_SET_RATE_IN_GROUP);
+  ck_assert(adc_group_enable(&g));
+  ck_assert(! adc_group_enable(&g));
+  ck_assert(adc_group_add(&g, &low) == ADC_GROUP_ADD_ENABLED);
+  ck_assert(adc_enable(&other));
+  adc_mock_set_value(ADC_CHANNEL_0, 100);
+  adc_mock_set_value(ADC_CHANNEL_3, 7);
+  adc_mock_set_value(ADC_CHANNEL_5, 200);
+
+  // The second member always directly follows the first one
+  adc_mock_convert(3);
+  adc_channel previous = ADC_CHANNEL_GND;
+  unsigned int n;
+  for (n = 0; n < 30; ++n) {
+    adc_channel ch = convert_one();
+    if (n > 0) {
+      ck_assert((ch == ADC_CHANNEL_5) == (previous == ADC_CHANNEL_0));
+    }
+    previous = ch;
+    run_processes();
+  }
+
+  // The group posts a single event per set of measurements, the members do
+  // not publish measurements of their own
+  ck_assert_uint_ge(nb_groups_completed, 2);
+  ck_assert(completed_group == &g);
+  ck_assert_uint_ge(nb_measurements, 2);
+  for (n = 0; n < nb_measurements && n < MAX_MEASUREMENTS; ++n) {
+    ck_assert(measured[n] == &other);
+  }
+  uint16_t values[2];
+  ck_assert_uint_eq(adc_group_get_values(&g, values), 2);
+  ck_assert_uint_eq(values[0], (4 * 100) << 4);
+  ck_assert_uint_eq(values[1], (4 * 200) << 4);
+
+  // Changing the inputs in between two sets of samples never mixes old and
+  // new measurements
+  uint16_t x = 100;
+  for (n = 0; n < 60; ++n) {
+    if (previous == ADC_CHANNEL_5) {
+      x += 3;
+      adc_mock_set_value(ADC_CHANNEL_0, x);
+      adc_mock_set_value(ADC_CHANNEL_5, 2 * x);
+    }
+    previous = convert_one();
+    if ((g.seq & 1) == 0) {
+      adc_group_get_values(&g, values);
+      ck_assert_uint_eq(values[1], 2 * values[0]);
+    }
+  }
+  ck_assert_uint_gt(values[0], (4 * 100) << 4);
+
+  ck_assert(adc_group_disable(&g));
+  ck_assert(! adc_group_disable(&g));
+  adc_mock_convert(4);
+  unsigned int nb_ch0 = adc_mock_get_nb_conversions(ADC_CHANNEL_0);
+  unsigned int nb_ch5 = adc_mock_get_nb_conversions(ADC_CHANNEL_5);
+  adc_mock_convert(16);
+  ck_assert_uint_eq(adc_mock_get_nb_conversions(ADC_CHANNEL_0), nb_ch0);
+  ck_assert_uint_eq(adc_mock_get_nb_conversions(ADC_CHANNEL_5), nb_ch5);
+}
+END_TEST
+
+
+// ****************************************************************************
+//                           test_adc_noise_reduction
+// ****************************************************************************
+
+// Entering ADC noise reduction sleep starts a single conversion, every sleep
+// lasts until the next conversion completes
+static void
+convert_while_sleeping(void)
+{
+  if (sleep_mock_state.mode == SLEEP_MODE_ADC) {
+    adc_mock_start_conversion();
+  }
+  adc_mock_convert(1);
+}
+
+START_TEST(test_adc_noise_reduction)
+{
+  adc a, q;
+  // A measurement that completes while the queued conversions are drained
+  // would cancel the conversion from noise reduction sleep
+  adc_init(&a, ADC_CHANNEL_3, ADC_RESOLUTION_16BIT, ADC_SKIP_0);
+  adc_init(&q, ADC_CHANNEL_6, ADC_RESOLUTION_10BIT, ADC_SKIP_0);
+  ck_assert(adc_set_noise_reduction(&q, true));
+  ck_assert(adc_set_rate(&q, 1) == ADC_SET_RATE_NOISE_REDUCTION);
+  ck_assert(adc_enable(&a));
+  ck_assert(adc_enable(&q));
+  ck_assert(! adc_set_noise_reduction(&q, false));
+  adc_mock_set_value(ADC_CHANNEL_3, 10);
+  adc_mock_set_value(ADC_CHANNEL_6, 20);
+  sleep_mock_init(convert_while_sleeping);
+  process_set_idle_hook(adc_sleep_idle);
+
+  // Precision-critical measurements are not sampled by the free-running
+  // conversions
+  adc_mock_convert(20);
+  ck_assert_uint_eq(adc_mock_get_nb_conversions(ADC_CHANNEL_6), 0);
+  run_processes();
+
+  // They are sampled from noise reduction sleep when idle
+  nb_measurements = 0;
+  unsigned int nb_ch3 = adc_mock_get_nb_conversions(ADC_CHANNEL_3);
+  process_idle();
+  ck_assert_uint_eq(adc_mock_get_nb_conversions(ADC_CHANNEL_6), 1);
+  ck_assert(sleep_mock_state.mode == SLEEP_MODE_ADC);
+  ck_assert(! sleep_mock_state.enabled);
+  ck_assert_uint_ge(sleep_mock_state.nb_sleeps, 2);
+  run_processes();
+  unsigned int n;
+  bool measured_q = false;
+  for (n = 0; n < nb_measurements && n < MAX_MEASUREMENTS; ++n) {
+    if (measured[n] == &q) {
+      measured_q = true;
+    }
+  }
+  ck_assert(measured_q);
+  ck_assert_uint_eq(adc_get_value(&q), 20 << 6);
+
+  // The queued conversions were completed, and free-running operation resumes
+  ck_assert_uint_gt(adc_mock_get_nb_conversions(ADC_CHANNEL_3), nb_ch3);
+  nb_ch3 = adc_mock_get_nb_conversions(ADC_CHANNEL_3);
+  adc_mock_convert(3 + 10);
+  ck_assert_uint_eq(adc_mock_get_nb_conversions(ADC_CHANNEL_3), nb_ch3 + 10);
+  ck_assert_uint_eq(adc_mock_get_nb_conversions(ADC_CHANNEL_6), 1);
+
+  // Without precision-critical measurements, the hook just sleeps
+  ck_assert(adc_disable(&q));
+  run_processes();
+  sleep_mock_init(NULL);
+  process_idle();
+  ck_assert_uint_eq(sleep_mock_state.nb_sleeps, 1);
+  ck_assert(sleep_mock_state.mode == SLEEP_MODE_IDLE);
+}
+END_TEST
+
+
+// ****************************************************************************
+//                           test_adc_noise_reduction_deferred
+// ****************************************************************************
+
+// Polls the test process while the queued conversions are drained, as if an
+// interrupt posted work
+static void
+poll_while_draining(void)
+{
+  if (sleep_mock_state.mode == SLEEP_MODE_IDLE) {
+    process_poll(&adc_test_process);
+  }
+  convert_while_sleeping();
+}
+
+static void
+rtimer_expired(rtimer* t, void* ptr)
+{ }
+
+START_TEST(test_adc_noise_reduction_deferred)
+{
+  adc q;
+  adc_init(&q, ADC_CHANNEL_6, ADC_RESOLUTION_10BIT, ADC_SKIP_0);
+  ck_assert(adc_set_noise_reduction(&q, true));
+  ck_assert(adc_enable(&q));
+  adc_mock_set_value(ADC_CHANNEL_6, 20);
+  rtimer_init();
+  init_etimer();
+  process_set_idle_hook(adc_sleep_idle);
+  run_processes();
+
+  // The clock is advanced by 13.5 ADC clock cycles for each conversion from
+  // noise reduction sleep, which is 27 ticks for 8 conversions
+  sleep_mock_init(convert_while_sleeping);
+  clock_time_t before = clock_get_time();
+  for (unsigned int i = 0; i < 8; ++i) {
+    process_idle();
+    run_processes();
+  }
+  ck_assert_uint_eq(adc_mock_get_nb_conversions(ADC_CHANNEL_6), 8);
+  ck_assert_uint_eq(clock_get_time() - before, 27);
+
+  // No conversion while an rtimer is scheduled
+  rtimer t;
+  rtimer_set(&t, 1000, rtimer_expired, NULL);
+  sleep_mock_init(convert_while_sleeping);
+  process_idle();
+  ck_assert_uint_eq(sleep_mock_state.nb_sleeps, 1);
+  ck_assert(sleep_mock_state.mode == SLEEP_MODE_IDLE);
+  rtimer_stop(&t);
+
+  // No conversion when an event timer expires within one conversion time
+  etimer e;
+  etimer_set(&e, 2, &adc_test_process);
+  sleep_mock_init(convert_while_sleeping);
+  process_idle();
+  ck_assert_uint_eq(sleep_mock_state.nb_sleeps, 1);
+  ck_assert(sleep_mock_state.mode == SLEEP_MODE_IDLE);
+  etimer_set(&e, 100, &adc_test_process);
+  process_idle();
+  run_processes();
+  ck_assert_uint_eq(adc_mock_get_nb_conversions(ADC_CHANNEL_6), 9);
+
+  // Work posted while the queued conversions are drained cancels the
+  // conversion, which is done the next time the MCU is idle
+  sleep_mock_init(poll_while_draining);
+  process_idle();
+  ck_assert_uint_eq(adc_mock_get_nb_conversions(ADC_CHANNEL_6), 9);
+  ck_assert(sleep_mock_state.mode == SLEEP_MODE_IDLE);
+  ck_assert_uint_gt(run_processes(), 0);
+  sleep_mock_init(convert_while_sleeping);
+  process_idle();
+  ck_assert_uint_eq(adc_mock_get_nb_conversions(ADC_CHANNEL_6), 10);
+}
+END_TEST
+
+
+// Convert nb capture sample periods on the given channel, where the value
+// during each period is one higher than during the previous one
+static void
+convert_ramp(adc_channel ch, uint16_t* value, unsigned int nb)
+{
+  for (unsigned int i = 0; i < nb; ++i) {
+    adc_mock_set_value(ch, *value);
+    adc_mock_convert(2);
+    *value += 1;
+  }
+}
+
+// ****************************************************************************
+//                           test_adc_capture_init
+// ****************************************************************************
+START_TEST(test_adc_capture_init)
+{
+  adc_capture c;
+  uint16_t buf[8];
+  ck_assert(adc_capture_init(&c, ADC_CHANNEL_GND, ADC_CAPTURE_TRIGGER_NONE,
+			     0, buf, 8, 0, NULL)
+	    == ADC_CAPTURE_INIT_INVALID_CHANNEL);
+  ck_assert(adc_capture_init(&c, ADC_CHANNEL_2, ADC_CAPTURE_TRIGGER_NONE,
+			     0, NULL, 8, 0, NULL)
+	    == ADC_CAPTURE_INIT_INVALID_BUFFER);
+  ck_assert(adc_capture_init(&c, ADC_CHANNEL_2, ADC_CAPTURE_TRIGGER_NONE,
+			     0, buf, 0, 0, NULL)
+	    == ADC_CAPTURE_INIT_INVALID_BUFFER);
+  ck_assert(adc_capture_init(&c, ADC_CHANNEL_2, ADC_CAPTURE_TRIGGER_NONE,
+			     0, buf, 8, 8, NULL)
+	    == ADC_CAPTURE_INIT_INVALID_PRE_TRIGGER);
+  ck_assert(adc_capture_init(&c, ADC_CHANNEL_2, ADC_CAPTURE_TRIGGER_NONE,
+			     0, buf, 8, 7, NULL)
+	    == ADC_CAPTURE_INIT_OK);
+  ck_assert(adc_capture_get_state(&c) == ADC_CAPTURE_IDLE);
+}
+END_TEST
+
+// ****************************************************************************
+//                           test_adc_capture_fixed_rate
+// ****************************************************************************
+START_TEST(test_adc_capture_fixed_rate)
+{
+  adc_capture c;
+  uint16_t buf[8];
+  adc_capture_init(&c, ADC_CHANNEL_4, ADC_CAPTURE_TRIGGER_NONE, 0, buf, 8, 0,
+		   &adc_test_process);
+  adc_mock_set_value(ADC_CHANNEL_4, 0x2AA);
+  ck_assert(adc_capture_start(&c));
+  ck_assert(adc_capture_get_state(&c) == ADC_CAPTURE_ARMED);
+
+  // Even without enabled ADCs, the capture gets every other conversion, after
+  // the conversions that were already in progress and the discarded ones
+  adc_mock_convert(3 + 2*2 + 2*7);
+  run_processes();
+  ck_assert(adc_capture_get_state(&c) == ADC_CAPTURE_TRIGGERED);
+  ck_assert_uint_eq(nb_captures_completed, 0);
+
+  adc_mock_convert(1);
+  run_processes();
+  ck_assert(adc_capture_get_state(&c) == ADC_CAPTURE_COMPLETE);
+  ck_assert_uint_eq(nb_captures_completed, 1);
+  ck_assert(completed_capture == &c);
+  for (unsigned int i = 0; i < 8; ++i) {
+    ck_assert_uint_eq(adc_capture_get_sample(&c, i), 0x2AA);
+  }
+
+  // No more samples are taken once the queued conversions have completed
+  adc_mock_convert(4);
+  unsigned int nb_ch4 = adc_mock_get_nb_conversions(ADC_CHANNEL_4);
+  adc_mock_convert(8);
+  ck_assert_uint_eq(adc_mock_get_nb_conversions(ADC_CHANNEL_4), nb_ch4);
+  ck_assert(! adc_capture_stop(&c));
+}
+END_TEST
+
+// ****************************************************************************
+//                           test_adc_capture_evenly_spaced
+// ****************************************************************************
+START_TEST(test_adc_capture_evenly_spaced)
+{
+  // The input of the captured channel is the index of the conversion
+  static uint16_t ramp[1024];
+  for (unsigned int i = 0; i < 1024; ++i) {
+    ramp[i] = i;
+  }
+  adc_mock_set_waveform(ADC_CHANNEL_2, ramp, 1024, 1);
+
+  adc a, v, i;
+  adc_group g;
+  adc_init(&a, ADC_CHANNEL_0, ADC_RESOLUTION_10BIT, ADC_SKIP_0);
+  adc_init(&v, ADC_CHANNEL_6, ADC_RESOLUTION_10BIT, ADC_SKIP_0);
+  adc_init(&i, ADC_CHANNEL_7, ADC_RESOLUTION_10BIT, ADC_SKIP_0);
+  adc_group_init(&g, NULL);
+  ck_assert(adc_group_add(&g, &v) == ADC_GROUP_ADD_OK);
+  ck_assert(adc_group_add(&g, &i) == ADC_GROUP_ADD_OK);
+
+  adc_capture c;
+  uint16_t buf[64];
+  adc_capture_init(&c, ADC_CHANNEL_2, ADC_CAPTURE_TRIGGER_NONE, 0, buf, 64, 0,
+		   NULL);
+  ck_assert(adc_capture_start(&c));
+
+  // Enable and disable measurements and a group while the capture runs
+  adc_mock_convert(20);
+  adc_enable(&a);
+  adc_mock_convert(20);
+  adc_group_enable(&g);
+  adc_mock_convert(20);
+  adc_disable(&a);
+  adc_mock_convert(20);
+  adc_group_disable(&g);
+  run_processes();
+  adc_mock_convert(128);
+  ck_assert(adc_capture_get_state(&c) == ADC_CAPTURE_COMPLETE);
+
+  // Consecutive samples are one capture sample period apart
+  for (unsigned int j = 1; j < 64; ++j) {
+    ck_assert_uint_eq(adc_capture_get_sample(&c, j),
+		      adc_capture_get_sample(&c, j - 1) + 2);
+  }
+}
+END_TEST
+
+// ****************************************************************************
+//                           test_adc_capture_trigger
+// ****************************************************************************
+START_TEST(test_adc_capture_trigger)
+{
+  adc_capture c;
+  uint16_t buf[8];
+  uint16_t value = 0;
+  adc_capture_init(&c, ADC_CHANNEL_1, ADC_CAPTURE_TRIGGER_RISING, 100, buf,
+		   8, 3, &adc_test_process);
+  ck_assert(adc_capture_start(&c));
+
+  // A ramp that starts above the level does not trigger on its first sample
+  value = 200;
+  convert_ramp(ADC_CHANNEL_1, &value, 20);
+  ck_assert(adc_capture_get_state(&c) == ADC_CAPTURE_ARMED);
+
+  // Wrap around the buffer a few times before the rising edge
+  value = 0;
+  convert_ramp(ADC_CHANNEL_1, &value, 100);
+  ck_assert(adc_capture_get_state(&c) == ADC_CAPTURE_ARMED);
+  convert_ramp(ADC_CHANNEL_1, &value, 1);
+  ck_assert(adc_capture_get_state(&c) == ADC_CAPTURE_TRIGGERED);
+  convert_ramp(ADC_CHANNEL_1, &value, 3);
+  ck_assert(adc_capture_get_state(&c) == ADC_CAPTURE_TRIGGERED);
+  convert_ramp(ADC_CHANNEL_1, &value, 1);
+  ck_assert(adc_capture_get_state(&c) == ADC_CAPTURE_COMPLETE);
+  run_processes();
+  ck_assert_uint_eq(nb_captures_completed, 1);
+
+  // The trigger sample is preceded by the pre-trigger samples
+  for (unsigned int i = 0; i < 8; ++i) {
+    ck_assert_uint_eq(adc_capture_get_sample(&c, i), 97 + i);
+  }
+}
+END_TEST
+
+// ****************************************************************************
+//                           test_adc_capture_shared
+// ****************************************************************************
+START_TEST(test_adc_capture_shared)
+{
+  adc a;
+  adc_capture c, c2;
+  uint16_t buf[16];
+  adc_init(&a, ADC_CHANNEL_0, ADC_RESOLUTION_10BIT, ADC_SKIP_0);
+  adc_mock_set_value(ADC_CHANNEL_0, 100);
+  adc_mock_set_value(ADC_CHANNEL_5, 300);
+  adc_enable(&a);
+  adc_mock_convert(3);
+
+  adc_capture_init(&c, ADC_CHANNEL_5, ADC_CAPTURE_TRIGGER_NONE, 0, buf, 16, 4,
+		   NULL);
+  adc_capture_init(&c2, ADC_CHANNEL_5, ADC_CAPTURE_TRIGGER_NONE, 0, buf, 16, 4,
+		   NULL);
+  ck_assert(adc_capture_start(&c));
+  ck_assert(! adc_capture_start(&c2));
+
+  // Measurements continue at half rate while the capture is running
+  unsigned int nb_ch0 = adc_mock_get_nb_conversions(ADC_CHANNEL_0);
+  adc_mock_convert(32);
+  run_processes();
+  ck_assert_uint_ge(adc_mock_get_nb_conversions(ADC_CHANNEL_0), nb_ch0 + 14);
+  ck_assert_uint_ge(adc_mock_get_nb_conversions(ADC_CHANNEL_5), 14);
+  ck_assert_uint_eq(adc_get_value(&a), 100 << 6);
+  ck_assert(adc_capture_get_state(&c) == ADC_CAPTURE_TRIGGERED);
+
+  // A stopped capture no longer takes samples once the queued conversions have
+  // completed
+  ck_assert(adc_capture_stop(&c));
+  ck_assert(adc_capture_get_state(&c) == ADC_CAPTURE_IDLE);
+  adc_mock_convert(4);
+  unsigned int nb_ch5 = adc_mock_get_nb_conversions(ADC_CHANNEL_5);
+  adc_mock_convert(16);
+  ck_assert_uint_eq(adc_mock_get_nb_conversions(ADC_CHANNEL_5), nb_ch5);
+
+  // Another capture can be started once the previous one was stopped
+  ck_assert(adc_capture_start(&c2));
+  adc_mock_convert(64);
+  ck_assert(adc_capture_get_state(&c2) == ADC_CAPTURE_COMPLETE);
+  for (unsigned int i = 0; i < 16; ++i) {
+    ck_assert_uint_eq(adc_capture_get_sample(&c2, i), 300);
+  }
+}
+END_TEST
+
+
+Suite *adc_suite(void)
+{
+  Suite *s = suite_create("Adc");
+
+  TCase *tc_measurement = tcase_create("Measurement");
+  tcase_add_checked_fixture(tc_measurement, setup, teardown);
+  tcase_add_test(tc_measurement, test_adc_measurement);
+  suite_add_tcase(s, tc_measurement);
+
+  TCase *tc_traffic = tcase_create("Scheduler traffic");
+  tcase_add_checked_fixture(tc_traffic, setup, teardown);
+  tcase_add_test(tc_traffic, test_adc_scheduler_traffic);
+  suite_add_tcase(s, tc_traffic);
+
+  TCase *tc_waveform = tcase_create("Waveform");
+  tcase_add_checked_fixture(tc_waveform, setup, teardown);
+  tcase_add_test(tc_waveform, test_adc_waveform);
+  suite_add_tcase(s, tc_waveform);
+
+  TCase *tc_channels = tcase_create("Channels");
+  tcase_add_checked_fixture(tc_channels, setup, teardown);
+  tcase_add_test(tc_channels, test_adc_channels);
+  suite_add_tcase(s, tc_channels);
+
+  TCase *tc_filter = tcase_create("Filter");
+  tcase_add_checked_fixture(tc_filter, setup, teardown);
+  tcase_add_test(tc_filter, test_adc_filter);
+  suite_add_tcase(s, tc_filter);
+
+  TCase *tc_rates = tcase_create("Rates");
+  tcase_add_checked_fixture(tc_rates, setup, teardown);
+  tcase_add_test(tc_rates, test_adc_rates);
+  suite_add_tcase(s, tc_rates);
+
+  TCase *tc_trip = tcase_create("Trip");
+  tcase_add_checked_fixture(tc_trip, setup, teardown);
+  tcase_add_test(tc_trip, test_adc_trip);
+  suite_add_tcase(s, tc_trip);
+
+  TCase *tc_group = tcase_create("Group");
+  tcase_add_checked_fixture(tc_group, setup, teardown);
+  tcase_add_test(tc_group, test_adc_group);
+  suite_add_tcase(s, tc_group);
+
+  TCase *tc_noise_reduction = tcase_create("Noise reduction");
+  tcase_add_checked_fixture(tc_noise_reduction, setup, teardown);
+  tcase_add_test(tc_noise_reduction, test_adc_noise_reduction);
+  tcase_add_test(tc_noise_reduction, test_adc_noise_reduction_deferred);
+  suite_add_tcase(s, tc_noise_reduction);
+
+  TCase *tc_capture = tcase_create("Capture");
+  tcase_add_checked_fixture(tc_capture, setup, teardown);
+  tcase_add_test(tc_capture, test_adc_capture_init);
+  tcase_add_test(tc_capture, test_adc_capture_fixed_rate);
+  tcase_add_test(tc_capture, test_adc_capture_evenly_spaced);
+  tcase_add_test(tc_capture, test_adc_capture_trigger);
+  tcase_add_test(tc_capture, test_adc_capture_shared);
+  suite_add_tcase(s, tc_capture);
+
+  return s;
+}
@@ -0,0 +1,57 @@
+/*
+ * bench.h
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+/**
+ * @file bench.h
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ *
+ * Helpers for the host benchmarks. The benchmarks run the firmware modules
+ * against the test mocks, so absolute numbers only say something about the
+ * host. They are meant to compare alternative implementations and to track
+ * regressions.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/**
+ * Return a monotonic timestamp in nanoseconds.
+ */
+static inline uint64_t
+bench_now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Print a benchmark result line.
+ */
+#define BENCH_REPORT(name, fmt, ...)			\
+  printf("%-40s " fmt "\n", name, __VA_ARGS__)
+
+#endif
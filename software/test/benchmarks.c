@@ -0,0 +1,47 @@
+/*
+ * benchmarks.c
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file benchmarks.c
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ *
+ * Runs the host benchmarks. Build and run with 'make benchmarks &&
+ * ./benchmarks'.
+ */
+
+#include <stdlib.h>
+
+#include "adc_bench.h"
+#include "etimer_bench.h"
+#include "process_bench.h"
+#include "pwlf_bench.h"
+#include "sim_bench.h"
+
+int main(void)
+{
+  process_bench();
+  etimer_bench();
+  adc_bench();
+  pwlf_bench();
+  sim_bench();
+  return EXIT_SUCCESS;
+}
@@ -30,6 +30,7 @@
 
 #include "clock_test.h"
 
+#include <stdbool.h>
 #include <check.h>
 #include "core/clock.h"
 #include "test/hal/mock_timer.h"
@@ -90,6 +91,98 @@ START_TEST(test_16bit_overflow)
 END_TEST
 
 
+// ****************************************************************************
+//                       test_retry_read
+// ****************************************************************************
+// The timer is ticked from the mock's read hook, to simulate the overflow
+// interrupt at every point during a clock read.
+#define NB_READ_POINTS 4
+
+static unsigned int nb_reads;
+static unsigned int tick_at_read;
+static bool tick_masked;
+
+static void
+tick_during_read(void)
+{
+  if (nb_reads == tick_at_read) {
+    if (tick_masked) {
+      mock_timer_tick_masked(MOCK_TIMER(CLOCK_TMR));
+    } else {
+      MOCK_TIMER_TICK(CLOCK_TMR);
+    }
+  }
+  nb_reads += 1;
+}
+
+static void
+hammer(clock_time_t (*get_time)(void), bool masked)
+{
+  clock_time_t expected = 0;
+  clock_time_t previous = 0;
+  tick_masked = masked;
+  mock_timer_set_read_hook(MOCK_TIMER(CLOCK_TMR), tick_during_read);
+
+  for (unsigned int i = 0; i < 2 * NB_READ_POINTS * 256; ++i) {
+    // Use each read point for a full timer period
+    nb_reads = 0;
+    tick_at_read = (i / 256) % NB_READ_POINTS;
+    clock_time_t t = get_time();
+    ck_assert(t == expected || t == expected + 1);
+    ck_assert(t >= previous);
+    previous = t;
+
+    if (nb_reads <= tick_at_read) {
+      // The read finished before the tick
+      MOCK_TIMER_TICK(CLOCK_TMR);
+    } else if (masked) {
+      mock_timer_handle_pending_interrupts(MOCK_TIMER(CLOCK_TMR));
+    }
+    expected += 1;
+    nb_reads = NB_READ_POINTS; // Disable the hook
+    ck_assert_uint_eq(get_time(), expected);
+  }
+}
+
+START_TEST(test_retry_read)
+{
+  hammer(clock_get_time, false);
+}
+END_TEST
+
+START_TEST(test_retry_read_masked)
+{
+  hammer(clock_get_time, true);
+}
+END_TEST
+
+START_TEST(test_retry_read_fast)
+{
+  hammer(clock_get_time_fast, false);
+}
+END_TEST
+
+
+// ****************************************************************************
+//                       test_advance
+// ****************************************************************************
+START_TEST(test_advance)
+{
+  clock_time_t expected = 0;
+  for (int i = 0; i < 1000; ++i) {
+    MOCK_TIMER_TICK(CLOCK_TMR);
+    clock_advance(3);
+    expected += 4;
+    ck_assert_uint_eq(clock_get_time(), expected);
+  }
+
+  // Advancing the counter past its maximum value counts as an overflow
+  clock_advance(255);
+  ck_assert_uint_eq(clock_get_time(), expected + 255);
+}
+END_TEST
+
+
 // ****************************************************************************
 //                           Test suite setup
 // ****************************************************************************
@@ -112,5 +205,17 @@ Suite *clock_suite(void)
   tcase_add_test(tc_16bit_overflow, test_16bit_overflow);
   suite_add_tcase(s, tc_16bit_overflow);
 
+  TCase *tc_retry_read = tcase_create("Retry read");
+  tcase_add_checked_fixture(tc_retry_read, setup, teardown);
+  tcase_add_test(tc_retry_read, test_retry_read);
+  tcase_add_test(tc_retry_read, test_retry_read_masked);
+  tcase_add_test(tc_retry_read, test_retry_read_fast);
+  suite_add_tcase(s, tc_retry_read);
+
+  TCase *tc_advance = tcase_create("Advance");
+  tcase_add_checked_fixture(tc_advance, setup, teardown);
+  tcase_add_test(tc_advance, test_advance);
+  suite_add_tcase(s, tc_advance);
+
   return s;
 }
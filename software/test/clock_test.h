@@ -31,5 +31,6 @@
 #include <check.h>
 
 Suite *clock_suite(void);
+Suite *clock_timer1_suite(void);
 
 #endif
@@ -0,0 +1,124 @@
+/*
+ * clock_timer1_test.c
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * @file clock_timer1_test.c
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ *
+ * Unit test for the clock running on the 16-bit TIMER1.
+ *
+ * The clock backend is selected at compile time, so this file includes its own
+ * copy of the clock module, configured for TIMER1. Its functions are renamed to
+ * avoid clashing with the TIMER0 clock used by the rest of the tests.
+ */
+
+#define CLOCK_CONF_TMR            TIMER1
+#define CLOCK_CONF_TMR_PRESCALER  8
+#define clock_init                clock_timer1_init
+#define clock_get_time            clock_timer1_get_time
+#define clock_get_time_fast       clock_timer1_get_time_fast
+#define clock_advance             clock_timer1_advance
+
+#include "core/clock.c"
+
+#include "clock_test.h"
+
+#include <check.h>
+#include "test/hal/mock_timer.h"
+
+static void setup(void)
+{
+  clock_init();
+}
+
+static void teardown(void)
+{
+
+}
+
+
+// ****************************************************************************
+//                       test_timer1_no_overflow
+// ****************************************************************************
+START_TEST(test_timer1_no_overflow)
+{
+  clock_time_t i;
+  for (i = 0; i < 65535; ++i) {
+    ck_assert_uint_eq(clock_get_time(), i);
+    MOCK_TIMER_TICK(CLOCK_TMR);
+  }
+  ck_assert_uint_eq(clock_get_time(), i);
+}
+END_TEST
+
+
+// ****************************************************************************
+//                       test_timer1_overflow
+// ****************************************************************************
+START_TEST(test_timer1_overflow)
+{
+  clock_time_t i;
+  for (i = 0; i < 3 * 65536UL + 10; ++i) {
+    ck_assert_uint_eq(clock_get_time(), i);
+    MOCK_TIMER_TICK(CLOCK_TMR);
+  }
+  ck_assert_uint_eq(clock_get_time(), i);
+}
+END_TEST
+
+
+// ****************************************************************************
+//                       test_timer1_resolution
+// ****************************************************************************
+START_TEST(test_timer1_resolution)
+{
+  ck_assert(CLOCK_USEC == 2.0);
+  ck_assert_uint_eq((clock_time_t)CLK_NEAREST(CLOCK_MSEC), 2000);
+}
+END_TEST
+
+
+// ****************************************************************************
+//                           Test suite setup
+// ****************************************************************************
+Suite *clock_timer1_suite(void)
+{
+  Suite *s = suite_create("Clock TIMER1");
+
+  TCase *tc_no_overflow = tcase_create("No overflow");
+  tcase_add_checked_fixture(tc_no_overflow, setup, teardown);
+  tcase_add_test(tc_no_overflow, test_timer1_no_overflow);
+  suite_add_tcase(s, tc_no_overflow);
+
+  TCase *tc_overflow = tcase_create("Overflow");
+  tcase_add_checked_fixture(tc_overflow, setup, teardown);
+  tcase_add_test(tc_overflow, test_timer1_overflow);
+  suite_add_tcase(s, tc_overflow);
+
+  TCase *tc_resolution = tcase_create("Resolution");
+  tcase_add_checked_fixture(tc_resolution, setup, teardown);
+  tcase_add_test(tc_resolution, test_timer1_resolution);
+  suite_add_tcase(s, tc_resolution);
+
+  return s;
+}
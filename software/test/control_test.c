@@ -0,0 +1,113 @@
+/*
+ * control_test.c
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * @file control_test.c
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ *
+ * Unit tests for the PSU control module.
+ *
+ * The control module is part of the psu-main application rather than of the
+ * core, so this file includes it directly.
+ */
+
+#include "apps/psu/main/control.c"
+
+#include "control_test.h"
+
+#include <check.h>
+#include "core/clock.h"
+#include "core/spi_master.h"
+#include "hal/adc.h"
+#include "hal/spi.h"
+
+#define SPI_MOCK_TX_DATA_BUFFER_SIZE 32
+#define NB_DISPATCHES 32
+
+// Expected DAC packet bytes, see the MCP4922 datasheet
+#define SET_BYTE0_CH_A(v)   (0x30 | ((v) >> 8))
+#define SET_BYTE0_CH_B(v)   (0xB0 | ((v) >> 8))
+#define SET_BYTE1(v)        ((v) & 0xFF)
+
+// The SPI master process polls its queue, so the processes are never all idle
+static void
+run_processes(void)
+{
+  unsigned int i;
+  for (i = 0; i < NB_DISPATCHES; ++i) {
+    process_execute();
+  }
+}
+
+static void setup(void)
+{
+  spi_mock_init(SPI_MOCK_TX_DATA_BUFFER_SIZE);
+  adc_mock_init();
+  clock_init();
+  process_init();
+  init_adc();
+  spim_init();
+  mcp4922_init();
+  ctrl_init();
+  run_processes();
+}
+
+static void teardown(void)
+{ }
+
+static void
+assert_last_pkt(uint8_t byte0, uint8_t byte1)
+{
+  ck_assert_uint_eq(spi_mock_get_last_transmitted_data(1), byte0);
+  ck_assert_uint_eq(spi_mock_get_last_transmitted_data(0), byte1);
+}
+
+
+// ****************************************************************************
+//                           test_ctrl_set_output
+// ****************************************************************************
+START_TEST(test_ctrl_set_output)
+{
+  ctrl_set_output(CTRL_CH_VOLTAGE0, 0x123);
+  run_processes();
+  assert_last_pkt(SET_BYTE0_CH_A(0x123), SET_BYTE1(0x123));
+
+  ctrl_set_output(CTRL_CH_CURRENT0, 0x456);
+  run_processes();
+  assert_last_pkt(SET_BYTE0_CH_B(0x456), SET_BYTE1(0x456));
+  ck_assert_uint_eq(spi_mock_get_nb_bytes_transmitted(), 4);
+}
+END_TEST
+
+
+Suite *control_suite(void)
+{
+  Suite *s = suite_create("Control");
+
+  TCase *tc_set_output = tcase_create("Set output");
+  tcase_add_checked_fixture(tc_set_output, setup, teardown);
+  tcase_add_test(tc_set_output, test_ctrl_set_output);
+  suite_add_tcase(s, tc_set_output);
+
+  return s;
+}
@@ -0,0 +1,96 @@
+/*
+ * etimer_bench.c
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file etimer_bench.c
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ */
+
+#include "etimer_bench.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "bench.h"
+#include "core/clock.h"
+#include "core/etimer.h"
+#include "core/process.h"
+#include "hal/mock_timer.h"
+
+#define NB_ROUNDS 200000
+#define LONG_DELAY 1000000 // Timers set by the benchmark never expire
+
+PROCESS(etimer_bench_process);
+
+PROCESS_THREAD(etimer_bench_process)
+{
+  PROCESS_BEGIN();
+
+  while (true) {
+    PROCESS_WAIT_EVENT();
+  }
+
+  PROCESS_END();
+}
+
+void etimer_bench(void)
+{
+  static etimer timers[ETIMER_CONF_MAX_PENDING];
+  char name[64];
+
+  clock_init();
+  process_init();
+  init_etimer();
+  process_start(&etimer_bench_process);
+
+  unsigned int nb_timers = 0;
+  for (unsigned int n = 1; n <= ETIMER_CONF_MAX_PENDING; n *= 2) {
+    // Add timers with distinct expiration times
+    while (nb_timers < n) {
+      etimer_set(&timers[nb_timers], LONG_DELAY + nb_timers,
+		 &etimer_bench_process);
+      nb_timers += 1;
+    }
+
+    // Restart timers at different positions in the queue, like the SPI
+    // master does after every byte
+    uint64_t start = bench_now_ns();
+    for (unsigned int i = 0; i < NB_ROUNDS; ++i) {
+      if ((i & 0x0F) == 0) {
+	MOCK_TIMER_TICK(CLOCK_TMR);
+      }
+      etimer_restart(&timers[i % n]);
+    }
+    double restart_ns = (double)(bench_now_ns() - start) / NB_ROUNDS;
+
+    // Let the etimer process check for expired timers
+    start = bench_now_ns();
+    for (unsigned int i = 0; i < NB_ROUNDS; ++i) {
+      process_execute();
+    }
+    double check_ns = (double)(bench_now_ns() - start) / NB_ROUNDS;
+
+    snprintf(name, sizeof(name), "etimer, %u timers", n);
+    BENCH_REPORT(name, "%8.1f ns/restart  %6.1f ns/check", restart_ns,
+		 check_ns);
+  }
+}
@@ -0,0 +1,272 @@
+/*
+ * etimer_test.c
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * @file etimer_test.c
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ *
+ * Unit tests for the event timer module.
+ */
+
+#include "etimer_test.h"
+
+#include <stdlib.h>
+#include <check.h>
+#include "core/clock.h"
+#include "core/etimer.h"
+#include "core/process.h"
+#include "hal/mock_timer.h"
+
+#define MAX_EXPIRATIONS 256
+#define NB_RANDOM_TIMERS 40
+#define NB_RANDOM_ROUNDS 2000
+
+PROCESS(etimer_test_process);
+static etimer* expired[MAX_EXPIRATIONS];
+static clock_time_t expired_at[MAX_EXPIRATIONS];
+static unsigned int nb_expired;
+
+static void setup(void)
+{
+  clock_init();
+  process_init();
+  init_etimer();
+  process_start(&etimer_test_process);
+  nb_expired = 0;
+}
+
+static void teardown(void)
+{ }
+
+PROCESS_THREAD(etimer_test_process)
+{
+  PROCESS_BEGIN();
+
+  while (true) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == EVENT_TIMER_EXPIRED);
+    if (nb_expired < MAX_EXPIRATIONS) {
+      expired[nb_expired] = (etimer*)data;
+      expired_at[nb_expired] = clock_get_time();
+    }
+    nb_expired += 1;
+  }
+
+  PROCESS_END();
+}
+
+// Running process_execute() a bounded number of times per tick is enough to
+// deliver all expiration events.
+static void
+run_ticks(unsigned int nb_ticks)
+{
+  for (unsigned int i = 0; i < nb_ticks; ++i) {
+    MOCK_TIMER_TICK(CLOCK_TMR);
+    for (unsigned int j = 0; j < ETIMER_CONF_MAX_PENDING + 4; ++j) {
+      process_execute();
+    }
+  }
+}
+
+// ****************************************************************************
+//                           test_etimer_order
+// ****************************************************************************
+START_TEST(test_etimer_order)
+{
+  etimer t30, t10, t20, t10b;
+  etimer_set(&t30, 30, &etimer_test_process);
+  etimer_set(&t10, 10, &etimer_test_process);
+  etimer_set(&t20, 20, &etimer_test_process);
+  etimer_set(&t10b, 10, &etimer_test_process);
+
+  run_ticks(9);
+  ck_assert_uint_eq(nb_expired, 0);
+  run_ticks(1);
+  ck_assert_uint_eq(nb_expired, 2);
+  ck_assert(expired[0] == &t10 || expired[0] == &t10b);
+  ck_assert(expired[1] == &t10 || expired[1] == &t10b);
+  run_ticks(20);
+  ck_assert_uint_eq(nb_expired, 4);
+  ck_assert(expired[2] == &t20);
+  ck_assert(expired[3] == &t30);
+  ck_assert_uint_eq(expired_at[2], 20);
+  ck_assert_uint_eq(expired_at[3], 30);
+
+  // Expired timers are no longer pending
+  run_ticks(50);
+  ck_assert_uint_eq(nb_expired, 4);
+}
+END_TEST
+
+// ****************************************************************************
+//                           test_etimer_restart
+// ****************************************************************************
+START_TEST(test_etimer_restart)
+{
+  etimer a, b;
+  etimer_set(&a, 10, &etimer_test_process);
+  etimer_set(&b, 15, &etimer_test_process);
+
+  // Moving a timer back in the queue
+  run_ticks(8);
+  etimer_restart(&a);
+  run_ticks(9);
+  ck_assert_uint_eq(nb_expired, 1);
+  ck_assert(expired[0] == &b);
+  run_ticks(10);
+  ck_assert_uint_eq(nb_expired, 2);
+  ck_assert(expired[1] == &a);
+  ck_assert_uint_eq(expired_at[1], 18);
+
+  // Moving a timer forward in the queue
+  etimer_set(&a, 20, &etimer_test_process);
+  etimer_set(&b, 40, &etimer_test_process);
+  etimer_set(&b, 5, &etimer_test_process);
+  run_ticks(30);
+  ck_assert_uint_eq(nb_expired, 4);
+  ck_assert(expired[2] == &b);
+  ck_assert(expired[3] == &a);
+
+  // Resetting a timer from its expiration time
+  etimer_reset(&a);
+  run_ticks(20);
+  ck_assert_uint_eq(nb_expired, 5);
+  ck_assert(expired[4] == &a);
+  ck_assert_uint_eq(expired_at[4], expired_at[3] + 20);
+}
+END_TEST
+
+// ****************************************************************************
+//                           test_etimer_tickless
+// ****************************************************************************
+START_TEST(test_etimer_tickless)
+{
+  etimer t;
+  ck_assert(! process_execute());
+
+  // The etimer process is only scheduled when a timer expires, also when the
+  // expiration is more than one timer period away
+  etimer_set(&t, 1000, &etimer_test_process);
+  for (int i = 0; i < 999; ++i) {
+    MOCK_TIMER_TICK(CLOCK_TMR);
+    ck_assert(! process_execute());
+  }
+  MOCK_TIMER_TICK(CLOCK_TMR);
+  ck_assert(process_execute());
+  ck_assert(process_execute());
+  ck_assert(! process_execute());
+  ck_assert_uint_eq(nb_expired, 1);
+  ck_assert_uint_eq(expired_at[0], 1000);
+
+  // A timer that expired before it was set is handled right away
+  etimer_set(&t, 0, &etimer_test_process);
+  ck_assert(process_execute());
+  ck_assert(process_execute());
+  ck_assert_uint_eq(nb_expired, 2);
+}
+END_TEST
+
+// ****************************************************************************
+//                           test_etimer_full
+// ****************************************************************************
+START_TEST(test_etimer_full)
+{
+  static etimer timers[ETIMER_CONF_MAX_PENDING + 1];
+  for (int i = 0; i <= ETIMER_CONF_MAX_PENDING; ++i) {
+    etimer_set(&timers[i], 1 + (i % 3), &etimer_test_process);
+  }
+  run_ticks(10);
+  ck_assert_uint_eq(nb_expired, ETIMER_CONF_MAX_PENDING);
+  for (unsigned int i = 0; i < nb_expired; ++i) {
+    ck_assert(expired[i] != &timers[ETIMER_CONF_MAX_PENDING]);
+  }
+}
+END_TEST
+
+// ****************************************************************************
+//                           test_etimer_random
+// ****************************************************************************
+START_TEST(test_etimer_random)
+{
+  static etimer timers[NB_RANDOM_TIMERS];
+  static clock_time_t expected[NB_RANDOM_TIMERS];
+  static bool pending[NB_RANDOM_TIMERS];
+  unsigned int nb_pending = 0;
+  srand(42);
+
+  for (int round = 0; round < NB_RANDOM_ROUNDS; ++round) {
+    // Set or restart a random timer
+    int i = rand() % NB_RANDOM_TIMERS;
+    clock_time_t delay = 1 + rand() % 50;
+    etimer_set(&timers[i], delay, &etimer_test_process);
+    expected[i] = clock_get_time() + delay;
+    if (! pending[i]) {
+      pending[i] = true;
+      nb_pending += 1;
+    }
+
+    nb_expired = 0;
+    run_ticks(1 + rand() % 3);
+    ck_assert(nb_expired <= nb_pending);
+    for (unsigned int e = 0; e < nb_expired; ++e) {
+      int j = expired[e] - timers;
+      ck_assert(pending[j]);
+      ck_assert_uint_eq(expired_at[e], expected[j]);
+      pending[j] = false;
+      nb_pending -= 1;
+    }
+  }
+}
+END_TEST
+
+
+Suite *etimer_suite(void)
+{
+  Suite *s = suite_create("Etimer");
+
+  TCase *tc_order = tcase_create("Order");
+  tcase_add_checked_fixture(tc_order, setup, teardown);
+  tcase_add_test(tc_order, test_etimer_order);
+  suite_add_tcase(s, tc_order);
+
+  TCase *tc_restart = tcase_create("Restart");
+  tcase_add_checked_fixture(tc_restart, setup, teardown);
+  tcase_add_test(tc_restart, test_etimer_restart);
+  suite_add_tcase(s, tc_restart);
+
+  TCase *tc_tickless = tcase_create("Tickless");
+  tcase_add_checked_fixture(tc_tickless, setup, teardown);
+  tcase_add_test(tc_tickless, test_etimer_tickless);
+  suite_add_tcase(s, tc_tickless);
+
+  TCase *tc_full = tcase_create("Full");
+  tcase_add_checked_fixture(tc_full, setup, teardown);
+  tcase_add_test(tc_full, test_etimer_full);
+  suite_add_tcase(s, tc_full);
+
+  TCase *tc_random = tcase_create("Random");
+  tcase_add_checked_fixture(tc_random, setup, teardown);
+  tcase_add_test(tc_random, test_etimer_random);
+  suite_add_tcase(s, tc_random);
+
+  return s;
+}
@@ -22,6 +22,8 @@
 #ifndef HAL_ADC_H
 #define HAL_ADC_H
 
+#include <stdbool.h>
+#include <stdint.h>
 #include "util/bit.h"
 #include "util/pp_magic.h"
 
@@ -58,10 +60,30 @@ typedef enum {
   ADC_CHANNEL_GND = 15
 } adc_channel;
 
-static inline
-void ADC_SET_CHANNEL(adc_channel ch)
-{
-}
+#define ADC_MOCK_NB_CHANNELS 16
+
+void adc_mock_init(void);
+void adc_mock_set_value(adc_channel ch, uint16_t value);
+unsigned int adc_mock_get_nb_conversions(adc_channel ch);
+unsigned long adc_mock_get_nb_total_conversions(void);
+
+// Script the input of a channel. Sample i of the waveform is the input during
+// conversions i*hold to (i+1)*hold-1, counting all conversions since
+// adc_mock_init(), and the waveform repeats after nb_samples samples. Setting
+// a constant value with adc_mock_set_value() removes the waveform.
+void adc_mock_set_waveform(adc_channel ch, const uint16_t* samples,
+			   uint16_t nb_samples, uint16_t hold);
+void adc_mock_convert(unsigned int nb_conversions);
+
+void adc_mock_set_channel(adc_channel ch);
+void adc_mock_start_conversion(void);
+void adc_mock_set_free_running(bool enabled);
+uint16_t adc_mock_get_value(void);
+// Whether a conversion is in progress, i.e. adc_mock_convert() would complete
+// it
+bool adc_mock_is_busy(void);
+
+#define ADC_SET_CHANNEL(ch)  adc_mock_set_channel(ch)
 
 
 static inline
@@ -79,11 +101,11 @@ void ADC_DIGITAL_INPUT_DISABLE(adc_channel ch)
 #define ADC_ENABLE()				
 #define ADC_DISABLE()				
 
-#define ADC_START_CONVERSION()			
+#define ADC_START_CONVERSION()  adc_mock_start_conversion()
 #define ADC_IS_BUSY() (false)
 
-#define ADC_AUTO_TRIGGER_ENABLE()		
-#define ADC_AUTO_TRIGGER_DISABLE()		
+#define ADC_AUTO_TRIGGER_ENABLE()  adc_mock_set_free_running(true)
+#define ADC_AUTO_TRIGGER_DISABLE() adc_mock_set_free_running(false)
 
 #define ADC_INTERRUPT_ENABLE() 
 #define ADC_INTERRUPT_DISABLE()
@@ -111,7 +133,7 @@ void ADC_SET_AUTO_TRIGGER_SRC(adc_trigger_src src)
 }
 
 
-#define ADC_GET_VALUE() 0
+#define ADC_GET_VALUE()  adc_mock_get_value()
 
 #define IS_ADC_INTERRUPT_FLAG_SET()       (false)
 
@@ -29,5 +29,6 @@
  */
 
 #define _NOP()
+#define _MemoryBarrier() __asm__ __volatile__("" ::: "memory")
 
 #endif
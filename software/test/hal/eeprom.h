@@ -28,8 +28,16 @@
  * @date 17 Oct 2014
  */
 
-// TODO: implement
-#define eeprom_read_byte(addr) 0
-#define eeprom_update_byte(dst, src)
+#include <stdint.h>
+#include <string.h>
+
+// The mock EEPROM is always erased, writes are discarded
+#define EEMEM
+#define eeprom_read_byte(addr) ((void)(addr), (uint8_t)0xFF)
+#define eeprom_update_byte(dst, src) ((void)(dst), (void)(src))
+#define eeprom_read_block(dst, src, size)	\
+  ((void)(src), memset((dst), 0xFF, (size)))
+#define eeprom_update_block(src, dst, size)	\
+  ((void)(src), (void)(dst), (void)(size))
 
 #endif
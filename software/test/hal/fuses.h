@@ -0,0 +1,48 @@
+/*
+ * fuses.h
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FUSES_H
+#define FUSES_H
+
+/**
+ * @file fuses.h
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ *
+ * Mock of the fuse definitions of avr-libc. The fuse values of an application
+ * are kept in a variable that is otherwise unused.
+ */
+
+#include <stdint.h>
+
+typedef struct {
+  uint8_t low;
+  uint8_t high;
+  uint8_t extended;
+} fuse_mock;
+
+#define FUSES  static const fuse_mock fuses __attribute__((unused))
+
+// Fuse bits are active low
+#define FUSE_CKSEL0  0xFE
+#define FUSE_SPIEN   0xDF
+
+#endif
@@ -21,50 +21,14 @@
 
 #include "gpio.h"
 
-#include <stdio.h>
+#include <string.h>
 
-#define NB_PORTS 3
+// Aligned like the I/O address space of the target
+uint8_t gpio_mock_io[GPIO_MOCK_IO_SIZE] __attribute__((aligned(4)));
+uint8_t gpio_mock_pcmsk[3];
 
-static uint8_t pin_value[NB_PORTS];
-
-void p_set_pins(port_ptr p, uint8_t mask)
-{
-  if ((uintptr_t)p >= NB_PORTS) {
-    printf("Warning: unknown port '%p' specified in p_set_pins()", p);
-    return;
-  }
-
-  pin_value[(uintptr_t)p] |= mask;
-}
-
-
-void p_clr_pins(port_ptr p, uint8_t mask)
-{
-  if ((uintptr_t)p >= NB_PORTS) {
-    printf("Warning: unknown port '%p' specified in p_clr_pins()", p);
-    return;
-  }
-
-  pin_value[(uintptr_t)p] &= ~mask;
-}
-
-uint8_t p_get_val(port_ptr p)
-{
-  if ((uintptr_t)p >= NB_PORTS) {
-    printf("Warning: unknown port '%p' specified in p_get_val()", p);
-    return 0;
-  }
-
-  return pin_value[(uintptr_t)p];
-}
-
-
-void p_set_val(port_ptr p, uint8_t value)
+void gpio_mock_init(void)
 {
-  if ((uintptr_t)p >= NB_PORTS) {
-    printf("Warning: unknown port '%p' specified in p_get_val()", p);
-    return;
-  }
-
-  pin_value[(uintptr_t)p] = value;
+  memset(gpio_mock_io, 0, sizeof(gpio_mock_io));
+  memset(gpio_mock_pcmsk, 0, sizeof(gpio_mock_pcmsk));
 }
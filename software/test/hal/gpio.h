@@ -24,40 +24,98 @@
 
 #include <stdint.h>
 
-typedef uint8_t* port_ptr;
+#include "util/bit.h"
+#include "util/pp_magic.h"
 
-#define PORTB_PTR  ((port_ptr)0)
-#define PORTC_PTR  ((port_ptr)1)
-#define PORTD_PTR  ((port_ptr)2)
+// The port registers are laid out at the same I/O addresses as on the
+// ATmega328P, so code that depends on their addresses (for instance
+// PORT_PTR_TO_IOMON_PORT()) works on the host as well. Writing a PORT register
+// does not change the corresponding PIN register: input values are set by the
+// test, through the PIN registers.
+#define GPIO_MOCK_IO_SIZE 0x2C
 
-void p_set_pins(port_ptr p, uint8_t mask);
-void p_clr_pins(port_ptr p, uint8_t mask);
+extern uint8_t gpio_mock_io[GPIO_MOCK_IO_SIZE];
 
-uint8_t p_get_val(port_ptr p);
-void p_set_val(port_ptr p, uint8_t value);
+#define PINB   gpio_mock_io[0x23]
+#define DDRB   gpio_mock_io[0x24]
+#define PORTB  gpio_mock_io[0x25]
+#define PINC   gpio_mock_io[0x26]
+#define DDRC   gpio_mock_io[0x27]
+#define PORTC  gpio_mock_io[0x28]
+#define PIND   gpio_mock_io[0x29]
+#define DDRD   gpio_mock_io[0x2A]
+#define PORTD  gpio_mock_io[0x2B]
 
-#define P_SET_PINS(port, mask)              p_set_pins(port, mask)
-#define P_CLR_PINS(port, mask)              p_clr_pins(port, mask)
+// Pin change interrupt masks, one per port
+extern uint8_t gpio_mock_pcmsk[3];
 
-#define P_GET_VAL(port)                     p_get_val(port)
-#define P_SET_VAL(port, value)              p_set_val(port, value)
+#define PCMSKB gpio_mock_pcmsk[0]
+#define PCMSKC gpio_mock_pcmsk[1]
+#define PCMSKD gpio_mock_pcmsk[2]
 
-#define P_SET_PINS_DIR_OUTPUT(port, mask)
-#define P_SET_PINS_DIR_INPUT(port, mask)
+void gpio_mock_init(void);
 
 
-//TODO: implement
-#define GET_PIN(pb)            0  
-#define SET_PIN(pb)              
-#define CLR_PIN(pb)              
-#define TGL_PIN(pb)              
+#define GET_PORT(pb)             PORT(pb)
+#define GET_BIT(pb)              B(pb)
+#define GET_PIN_MASK(...)        BMSK(__VA_ARGS__)
 
+#define GET_PIN(pb)              GET_PORT_BIT(PIN(pb),B(pb))
+#define SET_PIN(pb)              SET_PORT_BIT(PORT(pb),B(pb))
+#define CLR_PIN(pb)              CLR_PORT_BIT(PORT(pb),B(pb))
+#define TGL_PIN(pb)              TGL_PORT_BIT(PORT(pb),B(pb))
 
+#define GET_PIN_DIR(pb)          GET_PORT_BIT(DDR(pb),B(pb))
+#define SET_PIN_DIR_OUTPUT(pb)   SET_PORT_BIT(DDR(pb),B(pb))
+#define SET_PIN_DIR_INPUT(pb)    CLR_PORT_BIT(DDR(pb),B(pb))
+#define TGL_PIN_DIR(pb)          TGL_PORT_BIT(DDR(pb),B(pb))
 
-// TODO: implement
+// All pin change interrupts share a single vector
 #define PC_INTERRUPT_VECT(pb)     void pc_interrupt(void)  
-#define PC_INTERRUPT_ENABLE(pb)	 
-#define PC_INTERRUPT_DISABLE(pb) 
+#define PC_INTERRUPT_ENABLE(pb)   SET_PORT_BIT(PCMSK(pb),B(pb))
+#define PC_INTERRUPT_DISABLE(pb)  CLR_PORT_BIT(PCMSK(pb),B(pb))
+
+
+typedef uint8_t* port_ptr;
+
+#define PORTB_PTR  (&PORTB)
+#define PORTC_PTR  (&PORTC)
+#define PORTD_PTR  (&PORTD)
+
+#define P_SET_PINS(port, mask)              *(port) |= (mask)
+#define P_CLR_PINS(port, mask)              *(port) &= ~(mask)
+
+#define P_GET_VAL(port)                     (*GET_PIN_REG(port))
+#define P_SET_VAL(port, value)              *(port) = (value)
+
+#define P_SET_PINS_DIR_OUTPUT(port, mask)   *GET_DDR_REG(port) |= (mask)
+#define P_SET_PINS_DIR_INPUT(port, mask)    *GET_DDR_REG(port) &= ~(mask)
+
+
+// Internal macros, see hal/gpio.h
+#define B(p,b)                  (b)
+
+#define PORT(p,b)               (PORT ## p)
+#define PIN(p,b)                (PIN ## p)
+#define DDR(p,b)                (DDR ## p)
+#define PCMSK(p,b)              (PCMSK ## p)
+
+#define GET_PORT_BIT(p,b)       (((p) & _BV(b)) != 0)
+#define SET_PORT_BIT(p,b)       ((p) |= _BV(b))
+#define CLR_PORT_BIT(p,b)       ((p) &= ~_BV(b))
+#define TGL_PORT_BIT(p,b)       ((p) ^= _BV(b))
+
+#define GET_DDR_REG(port) ((port) - 1)
+#define GET_PIN_REG(port) ((port) - 2)
+
+#define _BMSK1(a) _BV(a)
+#define _BMSK2(a,b) \
+  _BV(a) | _BV(b)
+#define _BMSK3(a,b,c) \
+  _BV(a) | _BV(b) | _BV(c)
+#define _BMSK4(a,b,c,d) \
+  _BV(a) | _BV(b) | _BV(c) | _BV(d)
+#define BMSK(...) _PASTE2(_BMSK, NARG(__VA_ARGS__)(__VA_ARGS__))
 
 
 #endif
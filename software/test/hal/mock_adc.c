@@ -0,0 +1,139 @@
+/*
+ * mock_adc.c
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "adc.h"
+
+#include <stddef.h>
+
+// Free running mode: the channel is latched when a conversion starts, and the
+// next conversion starts as soon as the previous one completes, before the
+// conversion complete interrupt is handled. Without auto triggering, the ADC
+// stops after each conversion until a new one is started.
+static uint16_t values[ADC_MOCK_NB_CHANNELS];
+static unsigned int nb_conversions[ADC_MOCK_NB_CHANNELS];
+static unsigned long nb_total_conversions;
+
+// Scripted waveforms take precedence over the constant values. The waveform
+// sample is selected by the time of the conversion, so channels that are
+// converted at different moments see different parts of the same waveform.
+static const uint16_t* waveforms[ADC_MOCK_NB_CHANNELS];
+static uint16_t waveform_lengths[ADC_MOCK_NB_CHANNELS];
+static uint16_t waveform_holds[ADC_MOCK_NB_CHANNELS];
+static adc_channel mux;
+static adc_channel converting;
+static uint16_t result;
+static bool free_running;
+static bool busy;
+
+void adc_conversion_complete_vect(void);
+
+void adc_mock_init(void)
+{
+  for (unsigned int ch = 0; ch < ADC_MOCK_NB_CHANNELS; ++ch) {
+    values[ch] = 0;
+    nb_conversions[ch] = 0;
+    waveforms[ch] = NULL;
+  }
+  nb_total_conversions = 0;
+  mux = ADC_CHANNEL_GND;
+  converting = ADC_CHANNEL_GND;
+  result = 0;
+  free_running = false;
+  busy = false;
+}
+
+void adc_mock_set_value(adc_channel ch, uint16_t value)
+{
+  values[ch] = value;
+  waveforms[ch] = NULL;
+}
+
+void adc_mock_set_waveform(adc_channel ch, const uint16_t* samples,
+			   uint16_t nb_samples, uint16_t hold)
+{
+  waveforms[ch] = samples;
+  waveform_lengths[ch] = nb_samples;
+  waveform_holds[ch] = hold;
+}
+
+unsigned int adc_mock_get_nb_conversions(adc_channel ch)
+{
+  return nb_conversions[ch];
+}
+
+unsigned long adc_mock_get_nb_total_conversions(void)
+{
+  return nb_total_conversions;
+}
+
+static uint16_t
+get_input(adc_channel ch)
+{
+  if (waveforms[ch] == NULL) {
+    return values[ch];
+  }
+  unsigned long i = nb_total_conversions / waveform_holds[ch];
+  return waveforms[ch][i % waveform_lengths[ch]];
+}
+
+void adc_mock_convert(unsigned int nb)
+{
+  for (unsigned int i = 0; i < nb; ++i) {
+    if (! busy) {
+      return;
+    }
+    result = get_input(converting);
+    nb_conversions[converting] += 1;
+    nb_total_conversions += 1;
+    if (free_running) {
+      converting = mux;
+    } else {
+      busy = false;
+    }
+    adc_conversion_complete_vect();
+  }
+}
+
+void adc_mock_set_channel(adc_channel ch)
+{
+  mux = ch;
+}
+
+void adc_mock_start_conversion(void)
+{
+  converting = mux;
+  busy = true;
+}
+
+void adc_mock_set_free_running(bool enabled)
+{
+  free_running = enabled;
+}
+
+uint16_t adc_mock_get_value(void)
+{
+  return result;
+}
+
+bool adc_mock_is_busy(void)
+{
+  return busy;
+}
@@ -36,6 +36,8 @@ void mock_timer_init(mock_timer* tmr)
   tmr->oca_intr_enabled = false;
   tmr->ocb_intr_enabled = false;
   tmr->ovf_intr_enabled = false;
+  tmr->ovf_flag = false;
+  tmr->read_hook = NULL;
 }
 
 void mock_timer_tick(mock_timer* tmr)
@@ -152,25 +154,48 @@ void mock_timer_set_cntr16(mock_timer* tmr, uint16_t val)
   tmr->cntr = val;
 }
 
+static inline void
+call_read_hook(mock_timer* tmr)
+{
+  if (tmr->read_hook != NULL) {
+    tmr->read_hook();
+  }
+}
+
 uint8_t mock_timer_get_cntr8(mock_timer* tmr)
 {
+  call_read_hook(tmr);
   return (uint8_t)tmr->cntr;
 }
 
 uint16_t mock_timer_get_cntr16(mock_timer* tmr)
 {
+  call_read_hook(tmr);
   return tmr->cntr;
 }
 
-// TODO: implement
+// TODO: implement the compare match flags
 bool mock_timer_is_interrupt_flag_set(mock_timer* tmr, tmr_interrupt i)
 {
-  return false;
+  call_read_hook(tmr);
+  return i == INTR_OVF && tmr->ovf_flag;
+}
+
+void mock_timer_clear_interrupt_flag(mock_timer* tmr, tmr_interrupt i)
+{
+  if (i == INTR_OVF) {
+    tmr->ovf_flag = false;
+  }
 }
 
 
 static void fire_interrupts(mock_timer* tmr)
 {
+  // Like on the real hardware, the compare match interrupts are handled
+  // before the overflow interrupt, while the overflow flag is set.
+  if (tmr->cntr == 0) {
+    tmr->ovf_flag = true;
+  }
   if (tmr->oca_intr_enabled && 
       tmr->cntr == tmr->ocra) {
     tmr->oca_vect();
@@ -179,8 +204,27 @@ static void fire_interrupts(mock_timer* tmr)
       tmr->cntr == tmr->ocrb) {
     tmr->ocb_vect();
   }
-  if (tmr->ovf_intr_enabled && 
-      tmr->cntr == 0) {
+  mock_timer_handle_pending_interrupts(tmr);
+}
+
+void mock_timer_tick_masked(mock_timer* tmr)
+{
+  tmr->cntr += 1;
+  if (tmr->cntr == (1 << tmr->nb_bits)) {
+    tmr->cntr = 0;
+    tmr->ovf_flag = true;
+  }
+}
+
+void mock_timer_handle_pending_interrupts(mock_timer* tmr)
+{
+  if (tmr->ovf_intr_enabled && tmr->ovf_flag) {
     tmr->ovf_vect();
   }
+  tmr->ovf_flag = false;
+}
+
+void mock_timer_set_read_hook(mock_timer* tmr, void (*hook)(void))
+{
+  tmr->read_hook = hook;
 }
@@ -51,7 +51,9 @@ typedef enum {
   CS_DISABLED,
   CS_FULL_SPEED,
   CS_PRESCALE_8,
+  CS_PRESCALE_32,
   CS_PRESCALE_64,
+  CS_PRESCALE_128,
   CS_PRESCALE_256,
   CS_PRESCALE_1024,
   CS_EXT_FALLING,
@@ -68,9 +70,11 @@ typedef struct {
   bool oca_intr_enabled;
   bool ocb_intr_enabled;
   bool ovf_intr_enabled;
+  bool ovf_flag; // Set while the interrupts of a tick are handled, or pending
   void (*oca_vect)(void);
   void (*ocb_vect)(void);
   void (*ovf_vect)(void);
+  void (*read_hook)(void); // Called before each counter or flag read
 } mock_timer;
 
 
@@ -93,8 +97,16 @@ uint8_t mock_timer_get_cntr8(mock_timer* tmr);
 uint16_t mock_timer_get_cntr16(mock_timer* tmr);
 
 bool mock_timer_is_interrupt_flag_set(mock_timer* tmr, tmr_interrupt i);
+void mock_timer_clear_interrupt_flag(mock_timer* tmr, tmr_interrupt i);
+
+// Simulating code that runs with interrupts disabled: a masked tick leaves the
+// overflow interrupt pending until the pending interrupts are handled.
+void mock_timer_tick_masked(mock_timer* tmr);
+void mock_timer_handle_pending_interrupts(mock_timer* tmr);
+void mock_timer_set_read_hook(mock_timer* tmr, void (*hook)(void));
 
 #define MOCK_TIMER_TICK(tmr)  CAT(tmr,_TICK)
+#define MOCK_TIMER(tmr)       CAT(tmr,_MOCK)
 
 
 #endif
@@ -0,0 +1,54 @@
+/*
+ * sleep.c
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sleep.c
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ */
+
+#include "sleep.h"
+
+#include <stddef.h>
+
+sleep_mock sleep_mock_state;
+
+void sleep_mock_init(void (*wake_up)(void))
+{
+  sleep_mock_state.mode = SLEEP_MODE_IDLE;
+  sleep_mock_state.enabled = false;
+  sleep_mock_state.nb_sleeps = 0;
+  sleep_mock_state.wake_up = wake_up;
+}
+
+void sleep_mock_sleep_cpu(void)
+{
+  // Like the real sleep instruction, this does nothing unless sleeping is
+  // enabled
+  if (! sleep_mock_state.enabled) {
+    return;
+  }
+
+  sleep_mock_state.nb_sleeps += 1;
+  if (sleep_mock_state.wake_up != NULL) {
+    sleep_mock_state.wake_up();
+  }
+}
@@ -0,0 +1,61 @@
+/*
+ * sleep.h
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SLEEP_H
+#define SLEEP_H
+
+/**
+ * @file sleep.h
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+  SLEEP_MODE_IDLE,
+  SLEEP_MODE_ADC,
+  SLEEP_MODE_PWR_DOWN,
+  SLEEP_MODE_PWR_SAVE,
+  SLEEP_MODE_STANDBY,
+  SLEEP_MODE_EXT_STANDBY,
+} sleep_mock_mode;
+
+typedef struct {
+  sleep_mock_mode mode;
+  bool enabled;
+  unsigned int nb_sleeps;
+  // Called from SLEEP_CPU(), to simulate the interrupts that wake the MCU
+  void (*wake_up)(void);
+} sleep_mock;
+
+extern sleep_mock sleep_mock_state;
+
+void sleep_mock_init(void (*wake_up)(void));
+void sleep_mock_sleep_cpu(void);
+
+#define SLEEP_SET_MODE(m)     (sleep_mock_state.mode = SLEEP_MODE_##m)
+#define SLEEP_ENABLE()        (sleep_mock_state.enabled = true)
+#define SLEEP_DISABLE()       (sleep_mock_state.enabled = false)
+#define SLEEP_CPU()           sleep_mock_sleep_cpu()
+
+#endif
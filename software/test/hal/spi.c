@@ -8,6 +8,9 @@
 
 struct {
   bool enabled;
+  spi_role role;
+  bool tc_interrupt_enabled;
+  bool interrupt_flag;
   uint8_t data_reg;
   uint8_t status_reg;
 } spi_mock;
@@ -16,10 +19,14 @@ static uint8_t* incoming_data;
 static size_t incoming_data_remaining;
 static struct ring_buffer transmitted_data_buffer;
 static unsigned int nb_bytes_transmitted;
+static uint8_t (*transfer_hook)(uint8_t val);
 
 void spi_mock_init(size_t transmitted_data_buffer_size)
 {
   spi_mock.enabled = false;
+  spi_mock.role = SPI_ROLE_MASTER;
+  spi_mock.tc_interrupt_enabled = false;
+  spi_mock.interrupt_flag = false;
   spi_mock.data_reg = 0;
   spi_mock.status_reg = 0;
 
@@ -28,6 +35,7 @@ void spi_mock_init(size_t transmitted_data_buffer_size)
   incoming_data = 0;
   incoming_data_remaining = 0;
   nb_bytes_transmitted = 0;
+  transfer_hook = NULL;
 }
 
 void spi_mock_set_incoming_data(uint8_t* data, size_t size)
@@ -58,7 +66,7 @@ void spi_mock_set_pin_dirs_slave(void)
 
 void spi_mock_set_role(spi_role role)
 {
-  // Not yet implemented
+  spi_mock.role = role;
 }
 
 void spi_mock_set_data_order(spi_data_order data_order)
@@ -66,7 +74,14 @@ void spi_mock_set_data_order(spi_data_order data_order)
 
 void spi_mock_set_interrupt_enabled(spi_interrupt i, bool v)
 {
-  // Not yet implemented
+  if (i == SPI_INTERRUPT_TC) {
+    spi_mock.tc_interrupt_enabled = v;
+  }
+}
+
+bool spi_mock_is_interrupt_enabled(spi_interrupt i)
+{
+  return i == SPI_INTERRUPT_TC && spi_mock.tc_interrupt_enabled;
 }
 
 
@@ -85,17 +100,22 @@ void spi_mock_set_enabled(bool enabled)
 
 void spi_mock_write_data_reg(uint8_t val)
 {
-  if (spi_mock.enabled) {
+  if (spi_mock.enabled && spi_mock.role == SPI_ROLE_MASTER) {
     ring_buffer_put(&transmitted_data_buffer, val);
     nb_bytes_transmitted += 1;
   
-    if (incoming_data_remaining > 0) {
+    if (transfer_hook != NULL) {
+      spi_mock.data_reg = transfer_hook(val);
+    } else if (incoming_data_remaining > 0) {
       spi_mock.data_reg = *incoming_data;
       incoming_data += 1;
       incoming_data_remaining -= 1;
     }
+    spi_mock.interrupt_flag = true;
   } else {
+    // A slave shifts the byte out during the next transfer
     spi_mock.data_reg = val;
+    spi_mock.interrupt_flag = false;
   }
 }
 
@@ -113,3 +133,32 @@ uint8_t spi_mock_read_status_reg()
 {
   return spi_mock.status_reg;
 }
+
+bool spi_mock_is_interrupt_flag_set(void)
+{
+  return spi_mock.interrupt_flag;
+}
+
+void spi_mock_clear_flags(void)
+{
+  spi_mock.interrupt_flag = false;
+}
+
+void spi_mock_set_transfer_hook(uint8_t (*hook)(uint8_t val))
+{
+  transfer_hook = hook;
+}
+
+uint8_t spi_mock_slave_transfer(uint8_t val)
+{
+  if (! spi_mock.enabled || spi_mock.role != SPI_ROLE_SLAVE) {
+    return 0xFF;
+  }
+
+  uint8_t out = spi_mock.data_reg;
+  spi_mock.data_reg = val;
+  if (! spi_mock.tc_interrupt_enabled) {
+    spi_mock.interrupt_flag = true;
+  }
+  return out;
+}
@@ -22,6 +22,8 @@ typedef enum
   SPI_INTERRUPT_TC,
 } spi_interrupt;
 
+#define SPI_SS_PIN B,2
+
 void spi_mock_init(size_t transmitted_data_buffer_size);
 void spi_mock_set_incoming_data(uint8_t* data, size_t size);
 uint8_t spi_mock_get_last_transmitted_data(unsigned int index);
@@ -40,6 +42,21 @@ void spi_mock_write_data_reg(uint8_t val);
 uint8_t spi_mock_read_data_reg(void);
 void spi_mock_write_status_reg(uint8_t val);
 uint8_t spi_mock_read_status_reg(void);
+bool spi_mock_is_interrupt_flag_set(void);
+void spi_mock_clear_flags(void);
+
+// A master transfers each byte as soon as it is written to the data register.
+// Without a transfer hook, the byte received in return is taken from the
+// incoming data. The hook can instead exchange the byte with another device
+// and return the byte received from it.
+void spi_mock_set_transfer_hook(uint8_t (*hook)(uint8_t val));
+
+// Exchange a byte with a slave, as if it were selected and a master shifted
+// out the given byte. Returns the byte the slave shifted out, which is 0xFF if
+// the slave is not enabled. The interrupt flag is only set if the transfer
+// complete interrupt is disabled; otherwise the caller runs the interrupt.
+uint8_t spi_mock_slave_transfer(uint8_t val);
+bool spi_mock_is_interrupt_enabled(spi_interrupt i);
 
 #define SPI_SET_PIN_DIRS_MASTER()   spi_mock_set_pin_dirs_master()
 #define SPI_SET_PIN_DIRS_SLAVE()    spi_mock_set_pin_dirs_slave()
@@ -61,10 +78,10 @@ uint8_t spi_mock_read_status_reg(void);
 //#define SET_SPI_STATUS_REG(x) spi_mock_write_status_reg(x)
 //#define GET_SPI_STATUS_REG    spi_mock_read_status_reg()
 
-// TODO: implement
-#define SPI_CLEAR_FLAGS()	   
-#define IS_SPI_INTERRUPT_FLAG_SET() (true)
-#define IS_SPI_WRITE_COLLISION_FLAG_SET() (true)
+// Transfers are instantaneous, so writes never collide
+#define SPI_CLEAR_FLAGS()                 spi_mock_clear_flags()
+#define IS_SPI_INTERRUPT_FLAG_SET()       spi_mock_is_interrupt_flag_set()
+#define IS_SPI_WRITE_COLLISION_FLAG_SET() (false)
 
 #define SPI_TRANSFER_COMPLETE_VECT  void spi_transfer_complete_vect(void)
 
@@ -42,6 +42,12 @@ extern mock_timer MOCK_TMR;
   mock_timer_set_intr_enabled(&MOCK_TMR, INTR_OCB, true)
 #define TIMER0_OVF_INTR_ENABLE \
   mock_timer_set_intr_enabled(&MOCK_TMR, INTR_OVF, true)
+#define TIMER0_OCA_INTR_DISABLE \
+  mock_timer_set_intr_enabled(&MOCK_TMR, INTR_OCA, false)
+#define TIMER0_OCB_INTR_DISABLE \
+  mock_timer_set_intr_enabled(&MOCK_TMR, INTR_OCB, false)
+#define TIMER0_OVF_INTR_DISABLE \
+  mock_timer_set_intr_enabled(&MOCK_TMR, INTR_OVF, false)
 
 // Modes
 #define TIMER0_SET_MODE_NORMAL			\
@@ -92,6 +98,12 @@ extern mock_timer MOCK_TMR;
   mock_timer_is_interrupt_flag_set(&MOCK_TMR, INTR_OCB)
 #define TIMER0_IS_OVF_INTERRUPT_FLAG_SET  \
   mock_timer_is_interrupt_flag_set(&MOCK_TMR, INTR_OVF)
+#define TIMER0_CLEAR_OCA_INTERRUPT_FLAG  \
+  mock_timer_clear_interrupt_flag(&MOCK_TMR, INTR_OCA)
+#define TIMER0_CLEAR_OCB_INTERRUPT_FLAG  \
+  mock_timer_clear_interrupt_flag(&MOCK_TMR, INTR_OCB)
+#define TIMER0_CLEAR_OVF_INTERRUPT_FLAG  \
+  mock_timer_clear_interrupt_flag(&MOCK_TMR, INTR_OVF)
 
 // Constants
 #define TIMER0_SIZE  8
@@ -104,5 +116,6 @@ extern mock_timer MOCK_TMR;
 
 // Mock timer operations
 #define TIMER0_TICK mock_timer_tick(&MOCK_TMR)
+#define TIMER0_MOCK (&MOCK_TMR)
 
 #endif
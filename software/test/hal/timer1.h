@@ -0,0 +1,121 @@
+/*
+ * timer1.h
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIMER1_H
+#define TIMER1_H
+
+#include "mock_timer.h"
+#include "util/pp_magic.h"
+
+extern mock_timer _mock_timer1;
+
+// Operations
+#define TIMER1_INIT  mock_timer_init(&_mock_timer1)
+
+// Output channels
+#define TIMER1_OCA_DISCONNECT  mock_timer_channel_disconnect(&_mock_timer1, CH_OCA)
+#define TIMER1_OCB_DISCONNECT  mock_timer_channel_disconnect(&_mock_timer1, CH_OCB)
+
+// Interrupts
+#define TIMER1_OCA_INTR_ENABLE \
+  mock_timer_set_intr_enabled(&_mock_timer1, INTR_OCA, true)
+#define TIMER1_OCB_INTR_ENABLE \
+  mock_timer_set_intr_enabled(&_mock_timer1, INTR_OCB, true)
+#define TIMER1_OVF_INTR_ENABLE \
+  mock_timer_set_intr_enabled(&_mock_timer1, INTR_OVF, true)
+#define TIMER1_OCA_INTR_DISABLE \
+  mock_timer_set_intr_enabled(&_mock_timer1, INTR_OCA, false)
+#define TIMER1_OCB_INTR_DISABLE \
+  mock_timer_set_intr_enabled(&_mock_timer1, INTR_OCB, false)
+#define TIMER1_OVF_INTR_DISABLE \
+  mock_timer_set_intr_enabled(&_mock_timer1, INTR_OVF, false)
+
+// Modes (only the modes supported by the mock timer)
+#define TIMER1_SET_MODE_NORMAL			\
+  mock_timer_set_mode(&_mock_timer1, M_NORMAL)
+#define TIMER1_SET_MODE_CTC_OCRA		\
+  mock_timer_set_mode(&_mock_timer1, M_CTC_OCRA)
+#define TIMER1_SET_MODE_FAST_PWM_0FF		\
+  mock_timer_set_mode(&_mock_timer1, M_FAST_PWM_0FF)
+#define TIMER1_SET_MODE_FAST_PWM_OCRA		\
+  mock_timer_set_mode(&_mock_timer1, M_FAST_PWM_OCRA)
+#define TIMER1_SET_MODE_PWM_PHASE_CORRECT_0FF	\
+  mock_timer_set_mode(&_mock_timer1, M_PHASE_CORRECT_0FF)
+#define TIMER1_SET_MODE_PWM_PHASE_CORRECT_OCRA  \
+  mock_timer_set_mode(&_mock_timer1, M_PHASE_CORRECT_OCRA)
+
+
+// Clock sources
+#define TIMER1_DISABLE TIMER1_SET_CLOCK_DISABLED
+#define TIMER1_SET_CLOCK_DISABLED		\
+  mock_timer_set_clock(&_mock_timer1, CS_DISABLED)
+#define TIMER1_SET_CLOCK_FULL_SPEED	        \
+  mock_timer_set_clock(&_mock_timer1, CS_FULL_SPEED)
+#define TIMER1_SET_CLOCK_PRESCALE_8		\
+  mock_timer_set_clock(&_mock_timer1, CS_PRESCALE_8)
+#define TIMER1_SET_CLOCK_PRESCALE_64	\
+  mock_timer_set_clock(&_mock_timer1, CS_PRESCALE_64)
+#define TIMER1_SET_CLOCK_PRESCALE_256	\
+  mock_timer_set_clock(&_mock_timer1, CS_PRESCALE_256)
+#define TIMER1_SET_CLOCK_PRESCALE_1024	\
+  mock_timer_set_clock(&_mock_timer1, CS_PRESCALE_1024)
+#define TIMER1_SET_CLOCK_EXT_FALLING	\
+  mock_timer_set_clock(&_mock_timer1, CS_EXT_FALLING)
+#define TIMER1_SET_CLOCK_EXT_RISING		\
+  mock_timer_set_clock(&_mock_timer1, CS_EXT_RISING)
+
+#define TIMER1_OCA_SET_OCR(val)  mock_timer_set_ocr16(&_mock_timer1, CH_OCA, val)
+#define TIMER1_OCA_GET_OCR       mock_timer_get_ocr16(&_mock_timer1, CH_OCA)
+
+#define TIMER1_OCB_SET_OCR(val)  mock_timer_set_ocr16(&_mock_timer1, CH_OCB, val)
+#define TIMER1_OCB_GET_OCR       mock_timer_get_ocr16(&_mock_timer1, CH_OCB)
+
+#define TIMER1_SET_CNTR(val)  mock_timer_set_cntr16(&_mock_timer1, val)
+#define TIMER1_GET_CNTR       mock_timer_get_cntr16(&_mock_timer1)
+
+
+#define TIMER1_IS_OCA_INTERRUPT_FLAG_SET  \
+  mock_timer_is_interrupt_flag_set(&_mock_timer1, INTR_OCA)
+#define TIMER1_IS_OCB_INTERRUPT_FLAG_SET  \
+  mock_timer_is_interrupt_flag_set(&_mock_timer1, INTR_OCB)
+#define TIMER1_IS_OVF_INTERRUPT_FLAG_SET  \
+  mock_timer_is_interrupt_flag_set(&_mock_timer1, INTR_OVF)
+#define TIMER1_CLEAR_OCA_INTERRUPT_FLAG  \
+  mock_timer_clear_interrupt_flag(&_mock_timer1, INTR_OCA)
+#define TIMER1_CLEAR_OCB_INTERRUPT_FLAG  \
+  mock_timer_clear_interrupt_flag(&_mock_timer1, INTR_OCB)
+#define TIMER1_CLEAR_OVF_INTERRUPT_FLAG  \
+  mock_timer_clear_interrupt_flag(&_mock_timer1, INTR_OVF)
+
+// Constants
+#define TIMER1_SIZE  16
+#define TIMER1_MAX_VALUE  65535
+
+// Interrupt vectors
+#define TIMER1_OCA_VECT  void _mock_timer1_oca_vect(void)
+#define TIMER1_OCB_VECT  void _mock_timer1_ocb_vect(void)
+#define TIMER1_OVF_VECT  void _mock_timer1_ovf_vect(void)
+
+// Mock timer operations
+#define TIMER1_TICK mock_timer_tick(&_mock_timer1)
+#define TIMER1_MOCK (&_mock_timer1)
+
+#endif
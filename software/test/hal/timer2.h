@@ -1,42 +1,121 @@
+/*
+ * timer2.h
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
 #ifndef TIMER2_H
 #define TIMER2_H
 
-#include <stdbool.h>
-#include <stdint.h>
-#include "hal/timers.h"
+#include "mock_timer.h"
+#include "util/pp_magic.h"
+
+extern mock_timer _mock_timer2;
+
+// Operations
+#define TIMER2_INIT  mock_timer_init(&_mock_timer2)
+
+// Output channels
+#define TIMER2_OCA_DISCONNECT  mock_timer_channel_disconnect(&_mock_timer2, CH_OCA)
+#define TIMER2_OCB_DISCONNECT  mock_timer_channel_disconnect(&_mock_timer2, CH_OCB)
+
+// Interrupts
+#define TIMER2_OCA_INTR_ENABLE \
+  mock_timer_set_intr_enabled(&_mock_timer2, INTR_OCA, true)
+#define TIMER2_OCB_INTR_ENABLE \
+  mock_timer_set_intr_enabled(&_mock_timer2, INTR_OCB, true)
+#define TIMER2_OVF_INTR_ENABLE \
+  mock_timer_set_intr_enabled(&_mock_timer2, INTR_OVF, true)
+#define TIMER2_OCA_INTR_DISABLE \
+  mock_timer_set_intr_enabled(&_mock_timer2, INTR_OCA, false)
+#define TIMER2_OCB_INTR_DISABLE \
+  mock_timer_set_intr_enabled(&_mock_timer2, INTR_OCB, false)
+#define TIMER2_OVF_INTR_DISABLE \
+  mock_timer_set_intr_enabled(&_mock_timer2, INTR_OVF, false)
+
+// Modes (only the modes supported by the mock timer)
+#define TIMER2_SET_MODE_NORMAL			\
+  mock_timer_set_mode(&_mock_timer2, M_NORMAL)
+#define TIMER2_SET_MODE_CTC_OCRA		\
+  mock_timer_set_mode(&_mock_timer2, M_CTC_OCRA)
+#define TIMER2_SET_MODE_FAST_PWM_0FF		\
+  mock_timer_set_mode(&_mock_timer2, M_FAST_PWM_0FF)
+#define TIMER2_SET_MODE_FAST_PWM_OCRA		\
+  mock_timer_set_mode(&_mock_timer2, M_FAST_PWM_OCRA)
+#define TIMER2_SET_MODE_PWM_PHASE_CORRECT_0FF	\
+  mock_timer_set_mode(&_mock_timer2, M_PHASE_CORRECT_0FF)
+#define TIMER2_SET_MODE_PWM_PHASE_CORRECT_OCRA  \
+  mock_timer_set_mode(&_mock_timer2, M_PHASE_CORRECT_OCRA)
+
+
+// Clock sources
+#define TIMER2_DISABLE TIMER2_SET_CLOCK_DISABLED
+#define TIMER2_SET_CLOCK_DISABLED		\
+  mock_timer_set_clock(&_mock_timer2, CS_DISABLED)
+#define TIMER2_SET_CLOCK_FULL_SPEED	        \
+  mock_timer_set_clock(&_mock_timer2, CS_FULL_SPEED)
+#define TIMER2_SET_CLOCK_PRESCALE_8		\
+  mock_timer_set_clock(&_mock_timer2, CS_PRESCALE_8)
+#define TIMER2_SET_CLOCK_PRESCALE_32	\
+  mock_timer_set_clock(&_mock_timer2, CS_PRESCALE_32)
+#define TIMER2_SET_CLOCK_PRESCALE_64	\
+  mock_timer_set_clock(&_mock_timer2, CS_PRESCALE_64)
+#define TIMER2_SET_CLOCK_PRESCALE_128	\
+  mock_timer_set_clock(&_mock_timer2, CS_PRESCALE_128)
+#define TIMER2_SET_CLOCK_PRESCALE_256	\
+  mock_timer_set_clock(&_mock_timer2, CS_PRESCALE_256)
+#define TIMER2_SET_CLOCK_PRESCALE_1024	\
+  mock_timer_set_clock(&_mock_timer2, CS_PRESCALE_1024)
 
+#define TIMER2_OCA_SET_OCR(val)  mock_timer_set_ocr8(&_mock_timer2, CH_OCA, val)
+#define TIMER2_OCA_GET_OCR       mock_timer_get_ocr8(&_mock_timer2, CH_OCA)
 
-struct tmr2 {
-  uint8_t OCR2A;
-  uint8_t TCNT2;
-  bool oca_interrupt_enabled;
-};
+#define TIMER2_OCB_SET_OCR(val)  mock_timer_set_ocr8(&_mock_timer2, CH_OCB, val)
+#define TIMER2_OCB_GET_OCR       mock_timer_get_ocr8(&_mock_timer2, CH_OCB)
 
-extern struct tmr2 timer2_mock;
+#define TIMER2_SET_CNTR(val)  mock_timer_set_cntr8(&_mock_timer2, val)
+#define TIMER2_GET_CNTR       mock_timer_get_cntr8(&_mock_timer2)
 
-void timer2_mock_init(void);
-void timer2_mock_set_oca_disconnected(void);
-void timer2_mock_enable_oca_interrupt(void);
-void timer2_mock_set_mode(char);
-void timer2_mock_set_clock_prescaler(int);
-void timer2_mock_set_clock_disabled(void);
-void timer2_mock_oca_interrupt_vect(void);
 
-void timer2_mock_tick(void);
-void timer2_mock_ffw_to_oca(void);
+#define TIMER2_IS_OCA_INTERRUPT_FLAG_SET  \
+  mock_timer_is_interrupt_flag_set(&_mock_timer2, INTR_OCA)
+#define TIMER2_IS_OCB_INTERRUPT_FLAG_SET  \
+  mock_timer_is_interrupt_flag_set(&_mock_timer2, INTR_OCB)
+#define TIMER2_IS_OVF_INTERRUPT_FLAG_SET  \
+  mock_timer_is_interrupt_flag_set(&_mock_timer2, INTR_OVF)
+#define TIMER2_CLEAR_OCA_INTERRUPT_FLAG  \
+  mock_timer_clear_interrupt_flag(&_mock_timer2, INTR_OCA)
+#define TIMER2_CLEAR_OCB_INTERRUPT_FLAG  \
+  mock_timer_clear_interrupt_flag(&_mock_timer2, INTR_OCB)
+#define TIMER2_CLEAR_OVF_INTERRUPT_FLAG  \
+  mock_timer_clear_interrupt_flag(&_mock_timer2, INTR_OVF)
 
-#define timer2_INIT                      timer2_mock_init()
-#define timer2_oca_SET_DISCONNECTED      timer2_mock_set_oca_disconnected()
-#define timer2_oca_SET_INTERRUPT_ENABLED timer2_mock_enable_oca_interrupt()
-#define timer2_SET_MODE_0                timer2_mock_set_mode(0)
-#define timer2_SET_CLOCK_ps_1024         timer2_mock_set_clock_prescaler(1024)
-#define timer2_SET_CLOCK_disabled        timer2_mock_set_clock_disabled()
+// Constants
+#define TIMER2_SIZE  8
+#define TIMER2_MAX_VALUE  255
 
-#define timer2_oca_REG      timer2_mock.OCR2A
-#define timer2_oca_REG_MAX  255
-#define timer2_cntr_REG     timer2_mock.TCNT2
-#define timer2_cntr_REG_MAX 255
+// Interrupt vectors
+#define TIMER2_OCA_VECT  void _mock_timer2_oca_vect(void)
+#define TIMER2_OCB_VECT  void _mock_timer2_ocb_vect(void)
+#define TIMER2_OVF_VECT  void _mock_timer2_ovf_vect(void)
 
-#define timer2_oca_INTERRUPT_VECT void timer2_mock_oca_interrupt_vect(void)
+// Mock timer operations
+#define TIMER2_TICK mock_timer_tick(&_mock_timer2)
+#define TIMER2_MOCK (&_mock_timer2)
 
 #endif
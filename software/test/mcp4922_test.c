@@ -161,6 +161,32 @@ START_TEST(test_mcp4922_send_16bit)
 END_TEST
 
 
+// ****************************************************************************
+//                       test_mcp4922_send_preloaded
+// ****************************************************************************
+START_TEST(test_mcp4922_send_preloaded)
+{
+  mcp4922_preloaded_pkt pkt_a, pkt_b;
+  mcp4922_preloaded_pkt_set(&pkt_a, SPI_DUMMY_PIN, &dummy_port,
+			    MCP4922_CHANNEL_A, DUMMY_DAC_VALUE, false);
+  mcp4922_preloaded_pkt_set(&pkt_b, SPI_DUMMY_PIN, &dummy_port,
+			    MCP4922_CHANNEL_B, 0, true);
+
+  // Preloaded packets are sent without running the SPI master process
+  mcp4922_preloaded_pkt_send(&pkt_a);
+  ck_assert_uint_eq(spi_mock_get_nb_bytes_transmitted(), 2);
+  ck_assert(spi_mock_get_last_transmitted_data(1) == EXPECTED_BYTE0_CH_A);
+  ck_assert(spi_mock_get_last_transmitted_data(0) == EXPECTED_BYTE1_CH_A);
+
+  // Shutdown clears the ~SHDN bit
+  mcp4922_preloaded_pkt_send(&pkt_b);
+  ck_assert_uint_eq(spi_mock_get_nb_bytes_transmitted(), 4);
+  ck_assert(spi_mock_get_last_transmitted_data(1) == (_BV(5) | _BV(7)));
+  ck_assert(spi_mock_get_last_transmitted_data(0) == 0);
+}
+END_TEST
+
+
 // ****************************************************************************
 //                           Test suite setup
 // ****************************************************************************
@@ -180,6 +206,7 @@ Suite *mcp4922_suite(void)
   add_tcase(s, test_mcp4922_send_channel_a, "MCP4922 send on channel A");
   add_tcase(s, test_mcp4922_send_channel_b, "MCP4922 send on channel B");
   add_tcase(s, test_mcp4922_send_16bit,     "MCP4922 send 16-bit");
+  add_tcase(s, test_mcp4922_send_preloaded, "MCP4922 send preloaded");
 
   return s;
 }
@@ -0,0 +1,115 @@
+/*
+ * process_bench.c
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file process_bench.c
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ *
+ * Benchmarks for the process module.
+ */
+
+#include "process_bench.h"
+
+#include <stdint.h>
+#include <util/atomic.h>
+
+#include "bench.h"
+#include "core/process.h"
+
+#define NB_ROUNDS 200000
+#define BATCH_SIZE 8
+
+PROCESS(bench_process);
+static process_isr_queue bench_isr_queue;
+
+PROCESS_THREAD(bench_process)
+{
+  PROCESS_BEGIN();
+
+  while (true) {
+    PROCESS_WAIT_EVENT();
+  }
+
+  PROCESS_END();
+}
+
+static void
+drain(void)
+{
+  for (uint8_t i = 0; i < BATCH_SIZE; ++i) {
+    process_execute();
+  }
+}
+
+// Post events in batches, timing the posts only. The batch size fits in both
+// the regular and the ISR event queues.
+static void
+bench_post(const char* name, bool isr)
+{
+  process_init();
+  process_isr_queue_init(&bench_isr_queue, PROCESS_EVENT_PRIORITY_NORMAL);
+  process_start(&bench_process);
+
+  // Time spent posting
+  uint64_t post_ns = 0;
+  atomic_mock_reset(false);
+  for (uint32_t r = 0; r < NB_ROUNDS; ++r) {
+    uint64_t start = bench_now_ns();
+    for (uint8_t i = 0; i < BATCH_SIZE; ++i) {
+      if (isr) {
+	process_post_isr_event(&bench_isr_queue, &bench_process, 0x42, i);
+      } else {
+	process_post_event(&bench_process, 0x42, i);
+      }
+    }
+    post_ns += bench_now_ns() - start;
+    drain();
+  }
+  const uint32_t nb_blocks = atomic_mock_get_nb_blocks();
+
+  // Time spent with interrupts masked, posting and dispatching
+  atomic_mock_reset(true);
+  for (uint32_t r = 0; r < NB_ROUNDS; ++r) {
+    for (uint8_t i = 0; i < BATCH_SIZE; ++i) {
+      if (isr) {
+	process_post_isr_event(&bench_isr_queue, &bench_process, 0x42, i);
+      } else {
+	process_post_event(&bench_process, 0x42, i);
+      }
+    }
+    drain();
+  }
+  const uint64_t masked_ns = atomic_mock_get_masked_ns();
+  atomic_mock_reset(false);
+
+  const double nb_events = (double)NB_ROUNDS * BATCH_SIZE;
+  BENCH_REPORT(name, "%10.0f posts/s  %5.2f masked/event  %6.1f ns masked/event",
+	       nb_events / (post_ns * 1e-9),
+	       nb_blocks / nb_events,
+	       masked_ns / nb_events);
+}
+
+void process_bench(void)
+{
+  bench_post("process_post_event", false);
+  bench_post("process_post_isr_event", true);
+}
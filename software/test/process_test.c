@@ -32,19 +32,27 @@
 
 #include <stdbool.h>
 #include <check.h>
+#include "core/clock.h"
 #include "core/process.h"
+#include "hal/mock_timer.h"
+#include "hal/sleep.h"
+#include "util/bit.h"
 
 #define TEST_EVENT       ((process_event_t)0x42)
 #define TEST_EVENT_DATA  ((process_data_t)0x88)
+#define MAX_RECORDED_EVENTS 8
+#define SLEEP_TICKS 10
 
 PROCESS(test_process);
 static bool process_initialized;
 static process_event_t last_event;
 static process_data_t last_event_data;
 static unsigned int loop_counter;
+static process_data_t recorded_data[MAX_RECORDED_EVENTS];
 
 static void setup(void)
 {
+  process_init();
   process_initialized = false;
   last_event = 0;
   last_event_data = PROCESS_DATA_NULL;
@@ -69,6 +77,9 @@ PROCESS_THREAD(test_process)
     loop_counter += 1;
     last_event = ev;
     last_event_data = data;
+    if (loop_counter <= MAX_RECORDED_EVENTS) {
+      recorded_data[loop_counter - 1] = data;
+    }
   }
 
   PROCESS_END();
@@ -120,6 +131,604 @@ START_TEST(test_process_post_event)
 END_TEST
 
 
+// ****************************************************************************
+//                           test_process_priorities
+// ****************************************************************************
+START_TEST(test_process_priorities)
+{
+  process_start(&test_process);
+
+  process_post_priority_event(&test_process, TEST_EVENT, 1,
+			      PROCESS_EVENT_PRIORITY_LOW);
+  process_post_event(&test_process, TEST_EVENT, 2);
+  process_post_priority_event(&test_process, TEST_EVENT, 3,
+			      PROCESS_EVENT_PRIORITY_HIGH);
+  process_post_priority_event(&test_process, TEST_EVENT, 4,
+			      PROCESS_EVENT_PRIORITY_HIGH);
+
+  int i;
+  for (i = 0; i < 5; ++i) {
+    process_execute();
+  }
+  ck_assert(loop_counter == 4);
+
+  // High priority events first, in FIFO order
+  ck_assert(recorded_data[0] == 3);
+  ck_assert(recorded_data[1] == 4);
+  if (PROCESS_EVENT_PRIORITY_LOW == PROCESS_EVENT_PRIORITY_NORMAL) {
+    ck_assert(recorded_data[2] == 1);
+    ck_assert(recorded_data[3] == 2);
+  } else {
+    ck_assert(recorded_data[2] == 2);
+    ck_assert(recorded_data[3] == 1);
+  }
+}
+END_TEST
+
+
+// ****************************************************************************
+//                           test_process_invalid_priority
+// ****************************************************************************
+START_TEST(test_process_invalid_priority)
+{
+  process_start(&test_process);
+
+  process_post_event_status status;
+  status = process_post_priority_event(&test_process, TEST_EVENT,
+				       TEST_EVENT_DATA,
+				       NB_PROCESS_EVENT_PRIORITIES);
+  ck_assert(status == PROCESS_POST_EVENT_INVALID_PRIORITY);
+
+  process_execute();
+  ck_assert(loop_counter == 0);
+}
+END_TEST
+
+
+// ****************************************************************************
+//                           test_process_queue_full
+// ****************************************************************************
+START_TEST(test_process_queue_full)
+{
+  process_start(&test_process);
+
+  process_post_event_status status;
+  unsigned int nb_posted = 0;
+  do {
+    status = process_post_priority_event(&test_process, TEST_EVENT,
+					 TEST_EVENT_DATA,
+					 PROCESS_EVENT_PRIORITY_HIGH);
+    if (status == PROCESS_POST_EVENT_OK) {
+      nb_posted += 1;
+    }
+    ck_assert(nb_posted < 256);
+  } while (status == PROCESS_POST_EVENT_OK);
+  ck_assert(status == PROCESS_POST_EVENT_QUEUE_FULL);
+
+  // A full high-priority queue does not affect other priority levels
+  status = process_post_event(&test_process, TEST_EVENT, TEST_EVENT_DATA);
+  ck_assert(status == PROCESS_POST_EVENT_OK);
+
+  unsigned int i;
+  for (i = 0; i < nb_posted + 2; ++i) {
+    process_execute();
+  }
+  ck_assert(loop_counter == nb_posted + 1);
+}
+END_TEST
+
+
+// ****************************************************************************
+//                           test_process_isr_queue
+// ****************************************************************************
+START_TEST(test_process_isr_queue)
+{
+  process_isr_queue iq;
+  process_start(&test_process);
+  ck_assert(process_isr_queue_init(&iq, PROCESS_EVENT_PRIORITY_NORMAL)
+	    == PROCESS_POST_EVENT_OK);
+
+  unsigned int i;
+  for (i = 0; i < PROCESS_CONF_ISR_QUEUE_SIZE; ++i) {
+    ck_assert(process_post_isr_event(&iq, &test_process, TEST_EVENT, i)
+	      == PROCESS_POST_EVENT_OK);
+  }
+  ck_assert(process_post_isr_event(&iq, &test_process, TEST_EVENT, i)
+	    == PROCESS_POST_EVENT_QUEUE_FULL);
+
+  // Events are dispatched in FIFO order, also when the indices wrap around
+  for (i = 0; i < 300; ++i) {
+    process_execute();
+    ck_assert(loop_counter == i + 1);
+    ck_assert(last_event_data == i);
+    ck_assert(process_post_isr_event(&iq, &test_process, TEST_EVENT,
+				     i + PROCESS_CONF_ISR_QUEUE_SIZE)
+	      == PROCESS_POST_EVENT_OK);
+  }
+}
+END_TEST
+
+
+// ****************************************************************************
+//                           test_process_isr_queue_priorities
+// ****************************************************************************
+START_TEST(test_process_isr_queue_priorities)
+{
+  process_isr_queue iq_high, iq_normal;
+  process_start(&test_process);
+  process_isr_queue_init(&iq_normal, PROCESS_EVENT_PRIORITY_NORMAL);
+  process_isr_queue_init(&iq_high, PROCESS_EVENT_PRIORITY_HIGH);
+  ck_assert(process_isr_queue_init(&iq_high, NB_PROCESS_EVENT_PRIORITIES)
+	    == PROCESS_POST_EVENT_INVALID_PRIORITY);
+
+  process_post_event(&test_process, TEST_EVENT, 1);
+  process_post_isr_event(&iq_normal, &test_process, TEST_EVENT, 2);
+  process_post_priority_event(&test_process, TEST_EVENT, 3,
+			      PROCESS_EVENT_PRIORITY_HIGH);
+  process_post_isr_event(&iq_high, &test_process, TEST_EVENT, 4);
+
+  int i;
+  for (i = 0; i < 5; ++i) {
+    process_execute();
+  }
+  ck_assert(loop_counter == 4);
+
+  // ISR events go before regular events with the same priority
+  ck_assert(recorded_data[0] == 4);
+  ck_assert(recorded_data[1] == 3);
+  ck_assert(recorded_data[2] == 2);
+  ck_assert(recorded_data[3] == 1);
+}
+END_TEST
+
+
+// ****************************************************************************
+//                           test_process_poll
+// ****************************************************************************
+START_TEST(test_process_poll)
+{
+  process_start(&test_process);
+
+  // Poll requests are coalesced and do not use the event queue
+  process_poll(&test_process);
+  process_poll(&test_process);
+  ck_assert(process_get_queue_count(PROCESS_EVENT_PRIORITY_NORMAL) == 0);
+
+  process_execute();
+  ck_assert(loop_counter == 1);
+  ck_assert(last_event == PROCESS_EVENT_POLL);
+
+  process_execute();
+  ck_assert(loop_counter == 1);
+}
+END_TEST
+
+
+// ****************************************************************************
+//                           test_process_yield
+// ****************************************************************************
+PROCESS(yield_process);
+static unsigned int nb_yields;
+
+PROCESS_THREAD(yield_process)
+{
+  PROCESS_BEGIN();
+
+  while (true) {
+    PROCESS_YIELD();
+    nb_yields += 1;
+  }
+
+  PROCESS_END();
+}
+
+START_TEST(test_process_yield)
+{
+  nb_yields = 0;
+  process_start(&test_process);
+  process_start(&yield_process);
+  process_reset_queue_max_count();
+
+  int i;
+  for (i = 0; i < 100; ++i) {
+    process_post_event(&test_process, TEST_EVENT, i);
+    process_execute();
+    ck_assert(loop_counter == i + 1);
+    ck_assert(nb_yields == i + 1);
+  }
+
+  // Yielding does not take up event queue slots
+  ck_assert(process_get_queue_max_count(PROCESS_EVENT_PRIORITY_NORMAL) == 1);
+  ck_assert(process_get_queue_count(PROCESS_EVENT_PRIORITY_NORMAL) == 0);
+}
+END_TEST
+
+
+// ****************************************************************************
+//                           test_process_queue_max_count
+// ****************************************************************************
+START_TEST(test_process_queue_max_count)
+{
+  process_start(&test_process);
+
+  int i;
+  for (i = 0; i < 3; ++i) {
+    process_post_event(&test_process, TEST_EVENT, i);
+  }
+  ck_assert(process_get_queue_count(PROCESS_EVENT_PRIORITY_NORMAL) == 3);
+  ck_assert(process_get_queue_max_count(PROCESS_EVENT_PRIORITY_NORMAL) == 3);
+  ck_assert(process_get_queue_max_count(PROCESS_EVENT_PRIORITY_HIGH) == 0);
+  ck_assert(process_get_queue_max_count(NB_PROCESS_EVENT_PRIORITIES) == 0);
+
+  process_execute();
+  process_execute();
+  ck_assert(process_get_queue_count(PROCESS_EVENT_PRIORITY_NORMAL) == 1);
+  ck_assert(process_get_queue_max_count(PROCESS_EVENT_PRIORITY_NORMAL) == 3);
+
+  process_reset_queue_max_count();
+  ck_assert(process_get_queue_max_count(PROCESS_EVENT_PRIORITY_NORMAL) == 1);
+}
+END_TEST
+
+
+// ****************************************************************************
+//                           test_process_send_event
+// ****************************************************************************
+START_TEST(test_process_send_event)
+{
+  process_start(&test_process);
+
+  ck_assert(process_send_event(&test_process, TEST_EVENT, TEST_EVENT_DATA)
+	    == PROCESS_POST_EVENT_OK);
+  ck_assert(loop_counter == 1);
+  ck_assert(last_event == TEST_EVENT);
+  ck_assert(last_event_data == TEST_EVENT_DATA);
+  ck_assert(process_get_nb_direct_sends() == 1);
+  ck_assert(process_get_nb_deferred_sends() == 0);
+
+  process_execute();
+  ck_assert(loop_counter == 1);
+}
+END_TEST
+
+
+// ****************************************************************************
+//                           test_process_send_event_recursive
+// ****************************************************************************
+PROCESS(send_process);
+static unsigned int nb_sends_received;
+
+PROCESS_THREAD(send_process)
+{
+  PROCESS_BEGIN();
+
+  while (true) {
+    PROCESS_WAIT_EVENT();
+    nb_sends_received += 1;
+    if (data > 0) {
+      // Send to self, through another process
+      process_send_event(&test_process, TEST_EVENT, data);
+      process_send_event(&send_process, TEST_EVENT, data - 1);
+    }
+  }
+
+  PROCESS_END();
+}
+
+START_TEST(test_process_send_event_recursive)
+{
+  nb_sends_received = 0;
+  process_start(&test_process);
+  process_start(&send_process);
+
+  process_send_event(&send_process, TEST_EVENT, 2);
+  ck_assert(nb_sends_received == 1);
+  ck_assert(loop_counter == 1);
+  ck_assert(process_get_nb_direct_sends() == 2);
+  ck_assert(process_get_nb_deferred_sends() == 1);
+
+  // The recursive send is dispatched from the event queue
+  process_execute();
+  ck_assert(nb_sends_received == 2);
+  ck_assert(loop_counter == 2);
+  ck_assert(process_get_nb_deferred_sends() == 2);
+
+  process_execute();
+  ck_assert(nb_sends_received == 3);
+  ck_assert(loop_counter == 2);
+
+  process_execute();
+  ck_assert(nb_sends_received == 3);
+}
+END_TEST
+
+
+// ****************************************************************************
+//                           test_process_idle_sleep
+// ****************************************************************************
+static void wake_up_after_ticks(void)
+{
+  for (int i = 0; i < SLEEP_TICKS; ++i) {
+    MOCK_TIMER_TICK(CLOCK_TMR);
+  }
+}
+
+START_TEST(test_process_idle_sleep)
+{
+  clock_init();
+  process_init();
+  sleep_mock_init(wake_up_after_ticks);
+  process_start(&test_process);
+
+  // Don't sleep while there are events pending
+  process_post_event(&test_process, TEST_EVENT, TEST_EVENT_DATA);
+  process_idle();
+  ck_assert(sleep_mock_state.nb_sleeps == 0);
+  ck_assert(process_execute());
+  ck_assert(! process_execute());
+
+  // Nor while there are poll requests pending
+  process_poll(&test_process);
+  process_idle();
+  ck_assert(sleep_mock_state.nb_sleeps == 0);
+  ck_assert(process_execute());
+
+  process_idle();
+  ck_assert(sleep_mock_state.nb_sleeps == 1);
+  ck_assert(sleep_mock_state.mode == SLEEP_MODE_IDLE);
+  ck_assert(! sleep_mock_state.enabled);
+  ck_assert_uint_eq(process_get_idle_time(), SLEEP_TICKS);
+  ck_assert_uint_eq(process_get_busy_time(), 0);
+
+  wake_up_after_ticks();
+  ck_assert_uint_eq(process_get_idle_time(), SLEEP_TICKS);
+  ck_assert_uint_eq(process_get_busy_time(), SLEEP_TICKS);
+
+  process_reset_idle_time();
+  ck_assert_uint_eq(process_get_idle_time(), 0);
+  ck_assert_uint_eq(process_get_busy_time(), 0);
+}
+END_TEST
+
+
+// ****************************************************************************
+//                           test_process_topic
+// ****************************************************************************
+#define TOPIC_EVENT ((process_event_t)0x43)
+
+START_TEST(test_process_topic)
+{
+  process_topic topic;
+  process_subscription sub_all, sub_tag1;
+  process_topic_init(&topic);
+  process_start(&test_process);
+
+  // Nothing is queued without subscribers
+  ck_assert(process_publish(&topic, 0x01, TEST_EVENT_DATA)
+	    == PROCESS_POST_EVENT_OK);
+  ck_assert(! process_execute());
+
+  process_subscription_init(&sub_all, &test_process, TEST_EVENT,
+			    PROCESS_TOPIC_ALL_TAGS);
+  process_subscription_init(&sub_tag1, &test_process, TOPIC_EVENT, 0x02);
+  ck_assert(process_subscribe(&topic, &sub_all));
+  ck_assert(process_subscribe(&topic, &sub_tag1));
+  ck_assert(! process_subscribe(&topic, &sub_tag1));
+
+  // A message takes a single queue entry and is delivered to all matching
+  // subscribers in subscription order
+  process_reset_queue_max_count();
+  ck_assert(process_publish(&topic, 0x03, TEST_EVENT_DATA)
+	    == PROCESS_POST_EVENT_OK);
+  ck_assert_uint_eq(process_get_queue_count(PROCESS_EVENT_PRIORITY_NORMAL), 1);
+  ck_assert(process_execute());
+  ck_assert_uint_eq(loop_counter, 2);
+  ck_assert(last_event == TOPIC_EVENT);
+  ck_assert(recorded_data[0] == TEST_EVENT_DATA);
+  ck_assert(recorded_data[1] == TEST_EVENT_DATA);
+  ck_assert(! process_execute());
+
+  // Only subscribers with a matching mask receive the message
+  ck_assert(process_publish(&topic, 0x01, TEST_EVENT_DATA + 1)
+	    == PROCESS_POST_EVENT_OK);
+  while (process_execute());
+  ck_assert_uint_eq(loop_counter, 3);
+  ck_assert(last_event == TEST_EVENT);
+  ck_assert(last_event_data == TEST_EVENT_DATA + 1);
+
+  ck_assert(process_unsubscribe(&topic, &sub_all));
+  ck_assert(! process_unsubscribe(&topic, &sub_all));
+  process_publish(&topic, PROCESS_TOPIC_ALL_TAGS, TEST_EVENT_DATA);
+  while (process_execute());
+  ck_assert_uint_eq(loop_counter, 4);
+  ck_assert(last_event == TOPIC_EVENT);
+}
+END_TEST
+
+START_TEST(test_process_topic_isr)
+{
+  process_topic topic;
+  process_isr_queue iq;
+  process_subscription sub;
+  process_topic_init(&topic);
+  process_isr_queue_init(&iq, PROCESS_EVENT_PRIORITY_NORMAL);
+  process_start(&test_process);
+  process_subscription_init(&sub, &test_process, TOPIC_EVENT,
+			    PROCESS_TOPIC_ALL_TAGS);
+  process_subscribe(&topic, &sub);
+
+  ck_assert(process_publish_isr(&iq, &topic, 0x01, TEST_EVENT_DATA)
+	    == PROCESS_POST_EVENT_OK);
+  ck_assert(process_execute());
+  ck_assert_uint_eq(loop_counter, 1);
+  ck_assert(last_event == TOPIC_EVENT);
+  ck_assert(last_event_data == TEST_EVENT_DATA);
+  ck_assert(! process_execute());
+}
+END_TEST
+
+
+// ****************************************************************************
+//                           test_process_deadline_events
+// ****************************************************************************
+START_TEST(test_process_deadline_events)
+{
+  clock_init();
+  process_init();
+  process_start(&test_process);
+  for (int i = 0; i < 5; ++i) {
+    MOCK_TIMER_TICK(CLOCK_TMR);
+  }
+
+  // Deadline events are dispatched before regular events, earliest deadline
+  // first
+  process_post_priority_event(&test_process, TEST_EVENT, 0,
+			      PROCESS_EVENT_PRIORITY_HIGH);
+  process_post_deadline_event(&test_process, TEST_EVENT, 3, 30);
+  process_post_deadline_event(&test_process, TEST_EVENT, 1, 10);
+  process_post_deadline_event(&test_process, TEST_EVENT, 2, 20);
+  while (process_execute());
+  ck_assert_uint_eq(loop_counter, 4);
+  ck_assert(recorded_data[0] == 1);
+  ck_assert(recorded_data[1] == 2);
+  ck_assert(recorded_data[2] == 3);
+  ck_assert(recorded_data[3] == 0);
+  ck_assert_uint_eq(process_get_nb_missed_deadlines(), 0);
+
+  // Deadlines in the past are counted as missed
+  process_post_deadline_event(&test_process, TEST_EVENT, 4, 4);
+  process_post_deadline_event(&test_process, TEST_EVENT, 5, 5);
+  while (process_execute());
+  ck_assert_uint_eq(loop_counter, 6);
+  ck_assert(recorded_data[4] == 4);
+  ck_assert_uint_eq(process_get_nb_missed_deadlines(), 1);
+
+  // Deadlines are compared across a clock wrap-around
+  process_post_deadline_event(&test_process, TEST_EVENT, 7, 1);
+  process_post_deadline_event(&test_process, TEST_EVENT, 6, CLOCK_TIME_MAX);
+  while (process_execute());
+  ck_assert(recorded_data[6] == 6);
+  ck_assert(recorded_data[7] == 7);
+}
+END_TEST
+
+START_TEST(test_process_deadline_queue_full)
+{
+  int i;
+  process_start(&test_process);
+  for (i = 0; i < PROCESS_CONF_DEADLINE_QUEUE_SIZE; ++i) {
+    ck_assert(process_post_deadline_event(&test_process, TEST_EVENT, i, i)
+	      == PROCESS_POST_EVENT_OK);
+  }
+  ck_assert(process_post_deadline_event(&test_process, TEST_EVENT, i, i)
+	    == PROCESS_POST_EVENT_QUEUE_FULL);
+  while (process_execute());
+  ck_assert_uint_eq(loop_counter, PROCESS_CONF_DEADLINE_QUEUE_SIZE);
+}
+END_TEST
+
+
+// ****************************************************************************
+//                           test_process_stats
+// ****************************************************************************
+PROCESS(stats_process);
+PROCESS_THREAD(stats_process)
+{
+  PROCESS_BEGIN();
+
+  while (true) {
+    PROCESS_WAIT_EVENT();
+    // Simulate the process running for 'data' stats timer counts
+    for (process_data_t i = 0; i < data; ++i) {
+      MOCK_TIMER_TICK(TIMER1);
+    }
+  }
+
+  PROCESS_END();
+}
+
+START_TEST(test_process_stats)
+{
+  process_stats stats;
+  clock_init();
+  process_init();
+  process_start(&stats_process);
+  process_reset_stats(&stats_process);
+
+  process_post_event(&stats_process, TEST_EVENT, 100);
+  process_post_event(&stats_process, TEST_EVENT, 10);
+  process_post_event(&stats_process, TEST_EVENT, 40000);
+  while (process_execute());
+
+  ck_assert(process_get_stats(&stats_process, &stats));
+  ck_assert_uint_eq(stats.nb_dispatches, 3);
+  ck_assert_uint_eq(stats.total_run_time, 40110);
+  ck_assert_uint_eq(stats.max_run_time, 40000);
+  ck_assert_uint_eq(stats.histogram[0], 1);
+  ck_assert_uint_eq(stats.histogram[2], 1);
+  ck_assert_uint_eq(stats.histogram[PROCESS_STATS_HISTOGRAM_SIZE - 1], 1);
+  ck_assert_uint_eq(stats.nb_latencies, 3);
+  ck_assert_uint_eq(stats.max_latency, 0);
+
+  // Poll requests are dispatched, but have no queueing latency
+  process_poll(&stats_process);
+  ck_assert(process_execute());
+  ck_assert(process_get_stats(&stats_process, &stats));
+  ck_assert_uint_eq(stats.nb_dispatches, 4);
+  ck_assert_uint_eq(stats.nb_latencies, 3);
+
+  process_reset_stats(&stats_process);
+  ck_assert(process_get_stats(&stats_process, &stats));
+  ck_assert_uint_eq(stats.nb_dispatches, 0);
+  ck_assert_uint_eq(stats.max_run_time, 0);
+  ck_assert_uint_eq(stats.histogram[0], 0);
+}
+END_TEST
+
+START_TEST(test_process_stats_latency)
+{
+  process_stats stats;
+  process_isr_queue iq;
+  clock_init();
+  process_init();
+  process_start(&stats_process);
+  process_reset_stats(&stats_process);
+  ck_assert(process_isr_queue_init(&iq, PROCESS_EVENT_PRIORITY_HIGH)
+	    == PROCESS_POST_EVENT_OK);
+
+  process_post_event(&stats_process, TEST_EVENT, 0);
+  for (int i = 0; i < 5; ++i) {
+    MOCK_TIMER_TICK(CLOCK_TMR);
+  }
+  process_post_isr_event(&iq, &stats_process, TEST_EVENT, 0);
+  MOCK_TIMER_TICK(CLOCK_TMR);
+  while (process_execute());
+
+  ck_assert(process_get_stats(&stats_process, &stats));
+  ck_assert_uint_eq(stats.nb_latencies, 2);
+  ck_assert_uint_eq(stats.max_latency, 6);
+  ck_assert_uint_eq(stats.total_latency, 7);
+}
+END_TEST
+
+
+// ****************************************************************************
+//                           test_ctz8
+// ****************************************************************************
+START_TEST(test_ctz8)
+{
+  unsigned int v;
+  for (v = 1; v < 256; ++v) {
+    uint8_t expected = 0;
+    while (! (v & _BV(expected))) {
+      expected += 1;
+    }
+    ck_assert_int_eq(ctz8(v), expected);
+  }
+  ck_assert_int_eq(ctz8(0), 8);
+}
+END_TEST
+
 
 // ****************************************************************************
 //                           Test suite setup
@@ -139,6 +748,24 @@ Suite *process_suite(void)
   add_tcase(s, test_process_start,      "Start");
   add_tcase(s, test_process_idle,       "Idle");
   add_tcase(s, test_process_post_event, "Post event");
+  add_tcase(s, test_process_priorities, "Priorities");
+  add_tcase(s, test_process_invalid_priority, "Invalid priority");
+  add_tcase(s, test_process_queue_full, "Queue full");
+  add_tcase(s, test_process_isr_queue, "ISR queue");
+  add_tcase(s, test_process_isr_queue_priorities, "ISR queue priorities");
+  add_tcase(s, test_process_poll,       "Poll");
+  add_tcase(s, test_process_yield,      "Yield");
+  add_tcase(s, test_process_queue_max_count, "Queue max count");
+  add_tcase(s, test_process_send_event, "Send event");
+  add_tcase(s, test_process_send_event_recursive, "Send event recursive");
+  add_tcase(s, test_process_idle_sleep, "Idle sleep");
+  add_tcase(s, test_process_topic,      "Topic");
+  add_tcase(s, test_process_topic_isr,  "Topic ISR");
+  add_tcase(s, test_process_deadline_events, "Deadline events");
+  add_tcase(s, test_process_deadline_queue_full, "Deadline queue full");
+  add_tcase(s, test_process_stats,      "Stats");
+  add_tcase(s, test_process_stats_latency, "Stats latency");
+  add_tcase(s, test_ctz8,               "Count trailing zeros");
 
   return s;
 }
@@ -0,0 +1,135 @@
+/*
+ * pwlf_bench.c
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file pwlf_bench.c
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ *
+ * Benchmark of the piecewise linear function module. The functions are
+ * evaluated over the full 16-bit input range.
+ *
+ * The host does floating point arithmetic in hardware, so the comparison with
+ * the floating point implementation does not carry over to the ATmega328,
+ * where it runs on soft-float division, multiplication and round() routines.
+ */
+
+#include "pwlf_bench.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "bench.h"
+#include "core/pwlf.h"
+
+#define NB_ROUNDS 20
+
+// The original floating point implementation of pwlf_value()
+static int16_t
+float_value(pwlf* f, uint16_t x)
+{
+  uint8_t i = 1;
+  while (i < f->count - 1 && f->values[i].x < x) {
+    i += 1;
+  }
+  pwlf_pair p0 = f->values[i - 1];
+  pwlf_pair p1 = f->values[i];
+  float dx = ((float)(p1.y - p0.y)) / (p1.x - p0.x);
+  return p0.y + (int16_t)round(dx * (x - p0.x));
+}
+
+// The original linear segment lookup. The segment cache is evaluated with a
+// plain 64-bit multiplication, which is cheap on the host. pwlf_value() splits
+// it into 16x16-bit products instead, which pays off on the AVR only.
+static int16_t
+linear_value(pwlf* f, uint16_t x)
+{
+  uint8_t i = 1;
+  while (i < f->count - 1 && f->values[i].x < x) {
+    i += 1;
+  }
+  pwlf_segment* seg = &f->segments[i - 1];
+  int32_t dx = (int32_t)x - f->values[i - 1].x;
+  int64_t increment = (int64_t)seg->slope * dx;
+  int64_t result = (seg->offset + increment) >> 16;
+  if (result < INT16_MIN) {
+    return INT16_MIN;
+  }
+  if (result > INT16_MAX) {
+    return INT16_MAX;
+  }
+  return result;
+}
+
+// Keeps the compiler from optimizing the evaluations away
+static volatile int16_t sink;
+
+static double
+bench_value(pwlf* f, int16_t (*value)(pwlf*, uint16_t))
+{
+  uint64_t start = bench_now_ns();
+  for (unsigned int r = 0; r < NB_ROUNDS; ++r) {
+    uint32_t x;
+    for (x = 0; x <= UINT16_MAX; ++x) {
+      sink = value(f, x);
+    }
+  }
+  return (double)(bench_now_ns() - start) / (NB_ROUNDS * (UINT16_MAX + 1.0));
+}
+
+void pwlf_bench(void)
+{
+  static pwlf f = PWLF_INIT(8);
+  pwlf_add_node(&f, 1000, -200);
+  pwlf_add_node(&f, 20000, 5000);
+  pwlf_add_node(&f, 40000, 4990);
+  pwlf_add_node(&f, 50000, 30000);
+
+  BENCH_REPORT("pwlf, 4 nodes, float", "%8.1f ns/value",
+	       bench_value(&f, float_value));
+  BENCH_REPORT("pwlf, 4 nodes, integer", "%8.1f ns/value",
+	       bench_value(&f, pwlf_value));
+
+  pwlf_segment segments[7];
+  pwlf_compile(&f, segments);
+  BENCH_REPORT("pwlf, 4 nodes, segment cache", "%8.1f ns/value",
+	       bench_value(&f, pwlf_value));
+  pwlf_compile(&f, NULL);
+
+  // Segment lookup, with nodes spread evenly over the input range
+  static pwlf g = PWLF_INIT(64);
+  static pwlf_segment g_segments[63];
+  static const unsigned int nb_nodes[] = {2, 16, 64};
+  char name[64];
+  for (unsigned int k = 0; k < 3; ++k) {
+    unsigned int n = nb_nodes[k];
+    pwlf_clear(&g);
+    pwlf_compile(&g, g_segments);
+    for (unsigned int i = 0; i < n; ++i) {
+      pwlf_add_node(&g, i * (UINT16_MAX / (n - 1)), (i % 2) * 1000 + i);
+    }
+    snprintf(name, sizeof(name), "pwlf, %u nodes, linear scan", n);
+    BENCH_REPORT(name, "%8.1f ns/value", bench_value(&g, linear_value));
+    snprintf(name, sizeof(name), "pwlf, %u nodes, binary search", n);
+    BENCH_REPORT(name, "%8.1f ns/value", bench_value(&g, pwlf_value));
+  }
+}
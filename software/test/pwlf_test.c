@@ -140,6 +140,191 @@ START_TEST(test_pwlf_2point_signed)
 }
 END_TEST
 
+// ****************************************************************************
+// test_pwlf_float_reference
+// ****************************************************************************
+
+// The segment pwlf_value() uses for x
+static void
+find_segment(pwlf* f, uint16_t x, pwlf_pair* p0, pwlf_pair* p1)
+{
+  uint8_t i = 1;
+  while (i < pwlf_get_count(f) - 1 && pwlf_get_x(f, i) < x) {
+    i += 1;
+  }
+  p0->x = pwlf_get_x(f, i - 1);
+  p0->y = pwlf_get_y(f, i - 1);
+  p1->x = pwlf_get_x(f, i);
+  p1->y = pwlf_get_y(f, i);
+}
+
+// The original floating point interpolation, without overflow detection
+static int16_t
+float_polate(uint16_t x, pwlf_pair p0, pwlf_pair p1)
+{
+  float dx = ((float)(p1.y - p0.y)) / (p1.x - p0.x);
+  return p0.y + (int16_t)round(dx * (x - p0.x));
+}
+
+// The exact value, not clamped
+static double
+exact_polate(uint16_t x, pwlf_pair p0, pwlf_pair p1)
+{
+  // The product is exact, so halfway cases are not lost in the division
+  double product = (double)(p1.y - p0.y) * ((int32_t)x - p0.x);
+  return p0.y + round(product / (p1.x - p0.x));
+}
+
+static void
+check_float_reference(pwlf* f)
+{
+  uint32_t x;
+  for (x = 0; x <= UINT16_MAX; ++x) {
+    pwlf_pair p0, p1;
+    find_segment(f, x, &p0, &p1);
+    int16_t value = pwlf_value(f, x);
+    double exact = exact_polate(x, p0, p1);
+    if (exact > INT16_MAX) {
+      ck_assert_int_eq(value, INT16_MAX);
+    } else if (exact < INT16_MIN) {
+      ck_assert_int_eq(value, INT16_MIN);
+    } else {
+      ck_assert_int_eq(value, (int16_t)exact);
+      // Single precision floats are off by one near halfway cases
+      int16_t reference = float_polate(x, p0, p1);
+      ck_assert(value <= reference + 1);
+      ck_assert(value >= reference - 1);
+    }
+  }
+}
+
+START_TEST(test_pwlf_float_reference)
+{
+  static pwlf calibration = PWLF_INIT(8);
+  pwlf_add_node(&calibration, 1000, -200);
+  pwlf_add_node(&calibration, 20000, 5000);
+  pwlf_add_node(&calibration, 40000, 4990);
+  pwlf_add_node(&calibration, 50000, 30000);
+  check_float_reference(&calibration);
+
+  static pwlf steep = PWLF_INIT(8);
+  pwlf_add_node(&steep, 30000, 0);
+  pwlf_add_node(&steep, 30010, -20000);
+  check_float_reference(&steep);
+
+  static pwlf signed_range = PWLF_INIT(8);
+  pwlf_add_node(&signed_range, 0, INT16_MIN);
+  pwlf_add_node(&signed_range, 3, INT16_MAX);
+  pwlf_add_node(&signed_range, UINT16_MAX, INT16_MIN);
+  check_float_reference(&signed_range);
+
+  static pwlf odd = PWLF_INIT(8);
+  pwlf_add_node(&odd, 7, 3);
+  pwlf_add_node(&odd, 2054, 1000);
+  pwlf_add_node(&odd, 2057, -1);
+  check_float_reference(&odd);
+}
+END_TEST
+
+// ****************************************************************************
+// test_pwlf_many_nodes
+// ****************************************************************************
+START_TEST(test_pwlf_many_nodes)
+{
+  static pwlf f = PWLF_INIT(64);
+  unsigned int count;
+  for (count = 2; count <= 64; ++count) {
+    // Unevenly spaced nodes with alternating slopes
+    pwlf_clear(&f);
+    unsigned int i;
+    for (i = 0; i < count; ++i) {
+      uint16_t x = 500 + i * 1000 + (i * i) % 7;
+      int16_t y = (i % 2 == 0) ? i * 100 : -(int16_t)(i * 37);
+      ck_assert(pwlf_add_node(&f, x, y) == PWLF_ADD_NODE_OK);
+    }
+    check_float_reference(&f);
+  }
+}
+END_TEST
+
+// ****************************************************************************
+// test_pwlf_segment_cache
+// ****************************************************************************
+
+// Compare a function with a segment cache to the same function without
+static void
+check_segment_cache(pwlf* compiled, pwlf* f)
+{
+  uint32_t x;
+  for (x = 0; x <= UINT16_MAX; ++x) {
+    int16_t value = pwlf_value(compiled, x);
+    int16_t expected_value = pwlf_value(f, x);
+    ck_assert(value <= expected_value + 1);
+    ck_assert(value >= expected_value - 1);
+  }
+}
+
+START_TEST(test_pwlf_segment_cache)
+{
+  static pwlf f = PWLF_INIT(8);
+  static pwlf compiled = PWLF_INIT(8);
+  pwlf_segment segments[7];
+  pwlf_compile(&compiled, segments);
+
+  // The cache follows added and removed nodes
+  const pwlf_pair nodes[] = {
+    {1000, -200}, {20000, 5000}, {40000, 4990}, {50000, 30000}
+  };
+  for (unsigned int i = 0; i < 4; ++i) {
+    pwlf_add_node(&f, nodes[i].x, nodes[i].y);
+    pwlf_add_node(&compiled, nodes[i].x, nodes[i].y);
+  }
+  check_segment_cache(&compiled, &f);
+  ck_assert_int_eq(pwlf_value(&compiled, 0), -474);
+  ck_assert_int_eq(pwlf_value(&compiled, 1000), -200);
+  ck_assert_int_eq(pwlf_value(&compiled, 30000), 4995);
+  ck_assert_int_eq(pwlf_value(&compiled, UINT16_MAX), INT16_MAX);
+  pwlf_add_node(&compiled, 60000, -3);
+  ck_assert_int_eq(pwlf_value(&compiled, 60000), -3);
+  pwlf_remove_node(&compiled);
+  check_segment_cache(&compiled, &f);
+
+  // Nodes written directly require compiling again
+  compiled.values[1].y = 6000;
+  f.values[1].y = 6000;
+  pwlf_compile(&compiled, segments);
+  check_segment_cache(&compiled, &f);
+
+  // A corrupt count, like that of a blank EEPROM, does not make compiling
+  // write past the segment buffer
+  static pwlf small = PWLF_INIT(3);
+  pwlf_segment guarded[4];
+  guarded[2].slope = 0x5A5A5A5A;
+  guarded[3].slope = 0x5A5A5A5A;
+  pwlf_add_node(&small, 0, 0);
+  pwlf_add_node(&small, 10, 10);
+  pwlf_add_node(&small, 20, 0);
+  small.count = 0xFF;
+  pwlf_compile(&small, guarded);
+  ck_assert(guarded[2].slope == 0x5A5A5A5A);
+  ck_assert(guarded[3].slope == 0x5A5A5A5A);
+  ck_assert(guarded[1].slope == -65536);
+
+  // Steep segments are evaluated exactly
+  pwlf_clear(&f);
+  pwlf_clear(&compiled);
+  pwlf_add_node(&f, 100, -30000);
+  pwlf_add_node(&f, 101, 30000);
+  pwlf_add_node(&compiled, 100, -30000);
+  pwlf_add_node(&compiled, 101, 30000);
+  ck_assert(segments[0].slope == PWLF_STEEP_SEGMENT);
+  uint32_t x;
+  for (x = 0; x <= UINT16_MAX; ++x) {
+    ck_assert_int_eq(pwlf_value(&compiled, x), pwlf_value(&f, x));
+  }
+}
+END_TEST
+
 // ****************************************************************************
 //                           Test suite setup
 // ****************************************************************************
@@ -172,5 +357,20 @@ Suite *pwlf_suite(void)
   tcase_add_test(tc_pwlf_2point_signed, test_pwlf_2point_signed);
   suite_add_tcase(s, tc_pwlf_2point_signed);
 
+  TCase *tc_pwlf_float_reference = tcase_create("Float reference");
+  tcase_add_checked_fixture(tc_pwlf_float_reference, setup, teardown);
+  tcase_add_test(tc_pwlf_float_reference, test_pwlf_float_reference);
+  suite_add_tcase(s, tc_pwlf_float_reference);
+
+  TCase *tc_pwlf_many_nodes = tcase_create("Many nodes");
+  tcase_add_checked_fixture(tc_pwlf_many_nodes, setup, teardown);
+  tcase_add_test(tc_pwlf_many_nodes, test_pwlf_many_nodes);
+  suite_add_tcase(s, tc_pwlf_many_nodes);
+
+  TCase *tc_pwlf_segment_cache = tcase_create("Segment cache");
+  tcase_add_checked_fixture(tc_pwlf_segment_cache, setup, teardown);
+  tcase_add_test(tc_pwlf_segment_cache, test_pwlf_segment_cache);
+  suite_add_tcase(s, tc_pwlf_segment_cache);
+
   return s;
 }
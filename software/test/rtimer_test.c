@@ -0,0 +1,231 @@
+/*
+ * rtimer_test.c
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * @file rtimer_test.c
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ *
+ * Unit tests for the real-time timer module.
+ */
+
+#include "rtimer_test.h"
+
+#include <check.h>
+#include "core/rtimer.h"
+#include "hal/mock_timer.h"
+
+#define MAX_EXPIRATIONS 16
+
+static rtimer* expired[MAX_EXPIRATIONS];
+static rtimer_clock_t expired_at[MAX_EXPIRATIONS];
+static unsigned int nb_expired;
+
+static void setup(void)
+{
+  rtimer_init();
+  nb_expired = 0;
+}
+
+static void teardown(void)
+{ }
+
+static void
+record_expiration(rtimer* t, void* ptr)
+{
+  if (nb_expired < MAX_EXPIRATIONS) {
+    expired[nb_expired] = t;
+    expired_at[nb_expired] = rtimer_now();
+  }
+  nb_expired += 1;
+}
+
+static void
+run_ticks(unsigned int nb_ticks)
+{
+  for (unsigned int i = 0; i < nb_ticks; ++i) {
+    MOCK_TIMER_TICK(RTIMER_TMR);
+  }
+}
+
+// ****************************************************************************
+//                           test_rtimer_now
+// ****************************************************************************
+START_TEST(test_rtimer_now)
+{
+  ck_assert_uint_eq(rtimer_now(), 0);
+  run_ticks(255);
+  ck_assert_uint_eq(rtimer_now(), 255);
+  run_ticks(1);
+  ck_assert_uint_eq(rtimer_now(), 256);
+  run_ticks(1000);
+  ck_assert_uint_eq(rtimer_now(), 1256);
+}
+END_TEST
+
+// ****************************************************************************
+//                           test_rtimer_order
+// ****************************************************************************
+START_TEST(test_rtimer_order)
+{
+  rtimer t30, t10, t20;
+  ck_assert(rtimer_set(&t30, 30, record_expiration, NULL) == RTIMER_SET_OK);
+  ck_assert(rtimer_set(&t10, 10, record_expiration, NULL) == RTIMER_SET_OK);
+  ck_assert(rtimer_set(&t20, 20, record_expiration, NULL) == RTIMER_SET_OK);
+  ck_assert(rtimer_is_scheduled(&t10));
+
+  // Callbacks are called from the compare match interrupt, at the exact tick
+  run_ticks(9);
+  ck_assert_uint_eq(nb_expired, 0);
+  run_ticks(1);
+  ck_assert_uint_eq(nb_expired, 1);
+  ck_assert(expired[0] == &t10);
+  ck_assert(! rtimer_is_scheduled(&t10));
+  run_ticks(20);
+  ck_assert_uint_eq(nb_expired, 3);
+  ck_assert(expired[1] == &t20);
+  ck_assert(expired[2] == &t30);
+  ck_assert_uint_eq(expired_at[1], 20);
+  ck_assert_uint_eq(expired_at[2], 30);
+
+  // Expired timers are no longer scheduled
+  run_ticks(1000);
+  ck_assert_uint_eq(nb_expired, 3);
+}
+END_TEST
+
+// ****************************************************************************
+//                           test_rtimer_long_delay
+// ****************************************************************************
+START_TEST(test_rtimer_long_delay)
+{
+  rtimer t;
+  run_ticks(100);
+  rtimer_set(&t, 1000, record_expiration, NULL);
+  run_ticks(999);
+  ck_assert_uint_eq(nb_expired, 0);
+  run_ticks(1);
+  ck_assert_uint_eq(nb_expired, 1);
+  ck_assert_uint_eq(expired_at[0], 1100);
+
+  ck_assert(rtimer_set(&t, RTIMER_MAX_DELAY + 1, record_expiration, NULL) ==
+	    RTIMER_SET_DELAY_TOO_LONG);
+  ck_assert(! rtimer_is_scheduled(&t));
+}
+END_TEST
+
+// ****************************************************************************
+//                           test_rtimer_stop
+// ****************************************************************************
+START_TEST(test_rtimer_stop)
+{
+  rtimer a, b;
+  rtimer_set(&a, 10, record_expiration, NULL);
+  rtimer_set(&b, 20, record_expiration, NULL);
+
+  // Stopping and rescheduling the first timer
+  run_ticks(5);
+  rtimer_stop(&a);
+  ck_assert(! rtimer_is_scheduled(&a));
+  run_ticks(20);
+  ck_assert_uint_eq(nb_expired, 1);
+  ck_assert(expired[0] == &b);
+
+  rtimer_set(&a, 10, record_expiration, NULL);
+  run_ticks(5);
+  rtimer_set(&a, 10, record_expiration, NULL);
+  run_ticks(9);
+  ck_assert_uint_eq(nb_expired, 1);
+  run_ticks(1);
+  ck_assert_uint_eq(nb_expired, 2);
+  ck_assert(expired[1] == &a);
+}
+END_TEST
+
+// ****************************************************************************
+//                           test_rtimer_callback
+// ****************************************************************************
+static unsigned int nb_periodic;
+
+static void
+periodic(rtimer* t, void* ptr)
+{
+  nb_periodic += 1;
+  if (nb_periodic < *(unsigned int*)ptr) {
+    rtimer_set(t, 3, periodic, ptr);
+  }
+}
+
+START_TEST(test_rtimer_callback)
+{
+  rtimer t;
+  unsigned int max = 5;
+  nb_periodic = 0;
+
+  // A delay of 0 calls the function immediately
+  rtimer_set(&t, 0, record_expiration, NULL);
+  ck_assert_uint_eq(nb_expired, 1);
+  ck_assert(! rtimer_is_scheduled(&t));
+
+  // A timer can be set again from its own callback
+  rtimer_set(&t, 3, periodic, &max);
+  run_ticks(14);
+  ck_assert_uint_eq(nb_periodic, 4);
+  run_ticks(1);
+  ck_assert_uint_eq(nb_periodic, 5);
+  run_ticks(100);
+  ck_assert_uint_eq(nb_periodic, 5);
+}
+END_TEST
+
+
+Suite *rtimer_suite(void)
+{
+  Suite *s = suite_create("Rtimer");
+
+  TCase *tc_now = tcase_create("Now");
+  tcase_add_checked_fixture(tc_now, setup, teardown);
+  tcase_add_test(tc_now, test_rtimer_now);
+  suite_add_tcase(s, tc_now);
+
+  TCase *tc_order = tcase_create("Order");
+  tcase_add_checked_fixture(tc_order, setup, teardown);
+  tcase_add_test(tc_order, test_rtimer_order);
+  suite_add_tcase(s, tc_order);
+
+  TCase *tc_long_delay = tcase_create("Long delay");
+  tcase_add_checked_fixture(tc_long_delay, setup, teardown);
+  tcase_add_test(tc_long_delay, test_rtimer_long_delay);
+  suite_add_tcase(s, tc_long_delay);
+
+  TCase *tc_stop = tcase_create("Stop");
+  tcase_add_checked_fixture(tc_stop, setup, teardown);
+  tcase_add_test(tc_stop, test_rtimer_stop);
+  suite_add_tcase(s, tc_stop);
+
+  TCase *tc_callback = tcase_create("Callback");
+  tcase_add_checked_fixture(tc_callback, setup, teardown);
+  tcase_add_test(tc_callback, test_rtimer_callback);
+  suite_add_tcase(s, tc_callback);
+
+  return s;
+}
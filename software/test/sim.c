@@ -0,0 +1,388 @@
+/*
+ * sim.c
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sim.c
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ */
+
+#include "sim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ucontext.h>
+
+#define STACK_SIZE (1024 * 1024)
+
+// Chip selects on PORTB of the main MCU
+#define DAC_CS_MASK     (1 << 1)
+#define IOPANEL_SS_MASK (1 << 2)
+
+#define SHDN_MASK 0x1000
+
+typedef struct {
+  const sim_board* board;
+  ucontext_t ctx;
+  uint64_t now;
+  bool sleeping;
+  uint64_t wake;
+  sim_event events[SIM_CONF_EVENT_QUEUE_SIZE]; // Sorted by time
+  uint8_t nb_events;
+} mcu_state;
+
+static mcu_state mcus[SIM_NB_MCUS];
+static ucontext_t scheduler_ctx;
+static uint64_t sim_time;
+static uint64_t limit;
+
+// Wire state
+static uint8_t wire_portb;
+static uint8_t dac_shift[2];
+static uint8_t nb_dac_bytes;
+static unsigned int nb_ss_bytes;
+static sim_dac_hook dac_hook;
+static unsigned long nb_transfers;
+static unsigned long nb_dac_frames;
+static unsigned long nb_spi_bytes;
+
+
+uint64_t
+sim_get_next_event_time(sim_mcu mcu)
+{
+  mcu_state* m = &mcus[mcu];
+  return m->nb_events > 0 ? m->events[0].time : UINT64_MAX;
+}
+
+
+// Return the time up to which an MCU can be considered simulated
+static uint64_t
+get_key(sim_mcu mcu)
+{
+  mcu_state* m = &mcus[mcu];
+  if (m->sleeping) {
+    uint64_t next = sim_get_next_event_time(mcu);
+    return next < m->wake ? next : m->wake;
+  }
+  return m->now;
+}
+
+
+// Only the main MCU drives the wire, so the IO panel must not run ahead of it,
+// but the main MCU never has to wait for the IO panel
+static uint64_t
+get_horizon(sim_mcu mcu)
+{
+  uint64_t horizon = limit;
+  if (mcu == SIM_IOPANEL) {
+    uint64_t key = get_key(SIM_MAIN);
+    horizon = (key < horizon) ? key : horizon;
+  }
+  return horizon;
+}
+
+
+static void
+yield(sim_mcu mcu)
+{
+  swapcontext(&mcus[mcu].ctx, &scheduler_ctx);
+}
+
+
+// Let the IO panel catch up with the main MCU, before exchanging a byte
+static void
+catch_up(uint64_t now)
+{
+  mcus[SIM_MAIN].now = now;
+  if (get_key(SIM_IOPANEL) < now) {
+    yield(SIM_MAIN);
+  }
+}
+
+
+static void
+run_board(int mcu)
+{
+  mcus[mcu].board->start(mcu);
+  fprintf(stderr, "sim: firmware %d returned from main\n", mcu);
+  abort();
+}
+
+
+void
+sim_init(void)
+{
+  static bool started = false;
+  if (started) {
+    fprintf(stderr, "sim: the firmware images can only be started once\n");
+    abort();
+  }
+  started = true;
+
+  mcus[SIM_MAIN].board = &sim_psu_main;
+  mcus[SIM_IOPANEL].board = &sim_psu_iopanel;
+  for (sim_mcu i = 0; i < SIM_NB_MCUS; ++i) {
+    mcu_state* m = &mcus[i];
+    m->now = 0;
+    m->sleeping = false;
+    m->nb_events = 0;
+    getcontext(&m->ctx);
+    m->ctx.uc_stack.ss_sp = malloc(STACK_SIZE);
+    m->ctx.uc_stack.ss_size = STACK_SIZE;
+    m->ctx.uc_link = NULL;
+    makecontext(&m->ctx, (void (*)(void))run_board, 1, (int)i);
+  }
+  sim_time = 0;
+
+  // The pull-up on the slave select input of the IO panel
+  wire_portb = 0xFF;
+  sim_event ev = {
+    .time = 0,
+    .type = SIM_EVENT_PINS,
+    .pin_reg = SIM_PINB,
+    .mask = IOPANEL_SS_MASK,
+    .value = IOPANEL_SS_MASK,
+  };
+  sim_post_event(SIM_IOPANEL, &ev);
+  nb_dac_bytes = 0;
+  nb_ss_bytes = 0;
+  nb_transfers = 0;
+  nb_dac_frames = 0;
+  nb_spi_bytes = 0;
+}
+
+
+void
+sim_run(uint64_t ns)
+{
+  limit = sim_time + ns;
+  while (true) {
+    // Run the MCU that lags behind the most
+    sim_mcu next = 0;
+    uint64_t next_key = get_key(0);
+    for (sim_mcu i = 1; i < SIM_NB_MCUS; ++i) {
+      uint64_t key = get_key(i);
+      if (key < next_key) {
+	next = i;
+	next_key = key;
+      }
+    }
+    if (next_key >= limit) {
+      break;
+    }
+
+    mcu_state* m = &mcus[next];
+    if (m->sleeping) {
+      m->now = next_key;
+      m->sleeping = false;
+    }
+    swapcontext(&scheduler_ctx, &m->ctx);
+  }
+  sim_time = limit;
+}
+
+
+uint64_t
+sim_now_ns(void)
+{
+  return sim_time;
+}
+
+
+void
+sim_set_pins(sim_mcu mcu, uint8_t pin_reg, uint8_t mask, uint8_t value)
+{
+  sim_event ev = {
+    .time = sim_time,
+    .type = SIM_EVENT_PINS,
+    .pin_reg = pin_reg,
+    .mask = mask,
+    .value = value,
+  };
+  sim_post_event(mcu, &ev);
+}
+
+
+void
+sim_set_adc_input(sim_mcu mcu, uint8_t channel, uint16_t value)
+{
+  if (mcus[mcu].board->set_adc_input != NULL) {
+    mcus[mcu].board->set_adc_input(channel, value);
+  }
+}
+
+
+void
+sim_set_dac_hook(sim_dac_hook hook)
+{
+  dac_hook = hook;
+}
+
+
+unsigned long
+sim_get_nb_iopanel_transfers(void)
+{
+  return nb_transfers;
+}
+
+
+unsigned long
+sim_get_nb_dac_frames(void)
+{
+  return nb_dac_frames;
+}
+
+
+unsigned long
+sim_get_nb_spi_bytes(void)
+{
+  return nb_spi_bytes;
+}
+
+
+uint64_t
+sim_sync(sim_mcu mcu, uint64_t now)
+{
+  mcus[mcu].now = now;
+  if (now > get_horizon(mcu)) {
+    yield(mcu);
+  }
+  return mcus[mcu].now;
+}
+
+
+uint64_t
+sim_sleep(sim_mcu mcu, uint64_t now, uint64_t wake)
+{
+  mcu_state* m = &mcus[mcu];
+  m->now = now;
+  m->wake = wake;
+  m->sleeping = true;
+  yield(mcu);
+  return m->now;
+}
+
+
+void
+sim_post_event(sim_mcu mcu, const sim_event* ev)
+{
+  mcu_state* m = &mcus[mcu];
+  if (m->nb_events >= SIM_CONF_EVENT_QUEUE_SIZE) {
+    fprintf(stderr, "sim: event queue overflow\n");
+    abort();
+  }
+
+  // Events with the same time stay in the order they were posted
+  uint8_t i = m->nb_events;
+  while (i > 0 && m->events[i-1].time > ev->time) {
+    m->events[i] = m->events[i-1];
+    i -= 1;
+  }
+  m->events[i] = *ev;
+  m->nb_events += 1;
+}
+
+
+bool
+sim_pop_event(sim_mcu mcu, sim_event* ev)
+{
+  mcu_state* m = &mcus[mcu];
+  if (m->nb_events == 0) {
+    return false;
+  }
+
+  *ev = m->events[0];
+  m->nb_events -= 1;
+  for (uint8_t i = 0; i < m->nb_events; ++i) {
+    m->events[i] = m->events[i+1];
+  }
+  return true;
+}
+
+
+static void
+latch_dac(uint64_t now)
+{
+  uint16_t word = (dac_shift[0] << 8) | dac_shift[1];
+  nb_dac_bytes = 0;
+  nb_dac_frames += 1;
+  if (dac_hook != NULL) {
+    dac_hook(word >> 15, word & 0x0FFF, (word & SHDN_MASK) != 0, now);
+  }
+}
+
+
+void
+sim_wire_set_pins(sim_mcu mcu, uint8_t portb, uint64_t now)
+{
+  if (mcu != SIM_MAIN) {
+    return;
+  }
+
+  uint8_t changed = portb ^ wire_portb;
+  wire_portb = portb;
+  if (changed & DAC_CS_MASK) {
+    if ((portb & DAC_CS_MASK) && nb_dac_bytes == 2) {
+      latch_dac(now);
+    } else {
+      nb_dac_bytes = 0;
+    }
+  }
+  if (changed & IOPANEL_SS_MASK) {
+    sim_event ev = {
+      .time = now,
+      .type = SIM_EVENT_PINS,
+      .pin_reg = SIM_PINB,
+      .mask = IOPANEL_SS_MASK,
+      .value = portb,
+    };
+    sim_post_event(SIM_IOPANEL, &ev);
+    if ((portb & IOPANEL_SS_MASK) && nb_ss_bytes > 0) {
+      nb_transfers += 1;
+    }
+    nb_ss_bytes = 0;
+  }
+}
+
+
+uint8_t
+sim_wire_transfer(sim_mcu mcu, uint8_t mosi, uint64_t now)
+{
+  uint8_t miso = 0xFF;
+  if (mcu != SIM_MAIN) {
+    return miso;
+  }
+
+  nb_spi_bytes += 1;
+  if ((wire_portb & DAC_CS_MASK) == 0) {
+    if (nb_dac_bytes == 2) {
+      // The chip select went high and low again in between two observations
+      latch_dac(now);
+    }
+    dac_shift[nb_dac_bytes++] = mosi;
+  }
+  if ((wire_portb & IOPANEL_SS_MASK) == 0) {
+    nb_ss_bytes += 1;
+    catch_up(now);
+    miso = mcus[SIM_IOPANEL].board->spi_slave_transfer(mosi, now);
+  }
+  return miso;
+}
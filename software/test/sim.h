@@ -0,0 +1,228 @@
+/*
+ * sim.h
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+/**
+ * @file sim.h
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ *
+ * Host simulation of the complete PSU in virtual time.
+ *
+ * The simulator runs the unmodified psu-main and psu-iopanel firmware in a
+ * single process. Each firmware image is linked into a relocatable object of
+ * its own, in which all symbols but its board definition are local (see the
+ * Makefile), so each image has its own copy of the core modules and of the
+ * test mocks. The images run in coroutines and the simulator schedules them
+ * on a virtual clock per MCU. The mocks of TIMER0, TIMER2, the ADC, the SPI
+ * peripheral and the pin change interrupts act as the simulated hardware,
+ * driven by the board glue in sim_board.c.
+ *
+ * Virtual time advances according to a simple cost model: every dispatched
+ * event, every interrupt and every byte sent over SPI takes a fixed amount of
+ * CPU time, and a sleeping MCU skips ahead to its next interrupt. The
+ * simulation therefore runs much faster than real time. Only the main MCU
+ * drives the wire, so it runs ahead and the IO panel follows: the IO panel
+ * yields as soon as its clock passes that of the main MCU, and the main MCU
+ * only waits for the IO panel to catch up before exchanging a byte with it.
+ * The IO panel sees the actions of the main MCU at most one cost step late.
+ *
+ * The wiring follows the PSU schematic. The SPI bus of the main MCU is shared
+ * by the DAC, selected by PB1, and by the IO panel, whose slave select input
+ * PB2 is driven by PB2 of the main MCU. The DAC is modeled as a 16-bit shift
+ * register that is latched when its chip select goes high. Chip select edges
+ * are noticed when the main MCU sends a byte or its clock advances, which is
+ * as accurate as the cost model itself.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Time to shift a byte over the SPI wire at F_CPU/4
+#define SIM_SPI_BYTE_NS (8 * 4 * 1000000000ULL / F_CPU)
+
+// I/O addresses of the PIN registers
+#define SIM_PINB 0x23
+#define SIM_PINC 0x26
+#define SIM_PIND 0x29
+
+#ifndef SIM_CONF_EVENT_QUEUE_SIZE
+#define SIM_CONF_EVENT_QUEUE_SIZE 16
+#endif
+
+typedef enum {
+  SIM_MAIN,
+  SIM_IOPANEL,
+  SIM_NB_MCUS,
+} sim_mcu;
+
+typedef enum {
+  SIM_EVENT_PINS,
+  SIM_EVENT_SPI_TRANSFER_COMPLETE,
+} sim_event_type;
+
+/**
+ * An external event for an MCU, such as an input pin change.
+ */
+typedef struct {
+  uint64_t time;
+  sim_event_type type;
+  uint8_t pin_reg; // SIM_EVENT_PINS: I/O address of the PIN register
+  uint8_t mask;    // SIM_EVENT_PINS: pins to change
+  uint8_t value;   // SIM_EVENT_PINS: new value of the pins
+} sim_event;
+
+/**
+ * Board definition of a firmware image, see sim_board.c. The functions other
+ * than start() are called while the image is suspended, to model hardware
+ * that acts independently of its CPU.
+ */
+typedef struct {
+  void (*start)(sim_mcu mcu); // Runs the firmware, never returns
+  // Exchange a byte with the SPI slave of the MCU at the given time, or NULL
+  uint8_t (*spi_slave_transfer)(uint8_t mosi, uint64_t time);
+  // Set the input of an ADC channel, or NULL
+  void (*set_adc_input)(uint8_t channel, uint16_t value);
+} sim_board;
+
+extern const sim_board sim_psu_main;
+extern const sim_board sim_psu_iopanel;
+
+/**
+ * Callback for the values latched by the DAC. The value is the 12-bit DAC
+ * code, active is false if the channel was shut down.
+ */
+typedef void (*sim_dac_hook)(uint8_t channel, uint16_t value, bool active,
+			     uint64_t time);
+
+
+/********** Used by the benchmarks **********/
+
+/**
+ * Initialize the simulator and start both firmware images. The images can
+ * only be started once per process.
+ */
+void sim_init(void);
+
+/**
+ * Run the simulated system for a given amount of virtual time.
+ *
+ * @param ns The amount of virtual time to run for, in nanoseconds
+ */
+void sim_run(uint64_t ns);
+
+/**
+ * Return the virtual time up to which the system has been simulated, in
+ * nanoseconds.
+ */
+uint64_t sim_now_ns(void);
+
+/**
+ * Change input pins of an MCU at the current virtual time.
+ *
+ * @param mcu     The MCU of which to change the pins
+ * @param pin_reg The I/O address of the pins' PIN register, e.g. SIM_PINC
+ * @param mask    The pins to change
+ * @param value   The new value of the pins
+ */
+void sim_set_pins(sim_mcu mcu, uint8_t pin_reg, uint8_t mask, uint8_t value);
+
+/**
+ * Change the input of an ADC channel of an MCU.
+ */
+void sim_set_adc_input(sim_mcu mcu, uint8_t channel, uint16_t value);
+
+/**
+ * Set the function to call whenever the DAC latches a value, or NULL.
+ */
+void sim_set_dac_hook(sim_dac_hook hook);
+
+/**
+ * Return the number of SPI transfers with the IO panel so far, i.e. the
+ * number of times its slave select went high after at least one byte.
+ */
+unsigned long sim_get_nb_iopanel_transfers(void);
+
+/**
+ * Return the number of frames latched by the DAC so far.
+ */
+unsigned long sim_get_nb_dac_frames(void);
+
+/**
+ * Return the number of bytes sent over the SPI bus so far.
+ */
+unsigned long sim_get_nb_spi_bytes(void);
+
+
+/********** Used by the board glue **********/
+
+/**
+ * Report the virtual time of the running MCU. If the IO panel gets ahead of
+ * the main MCU, it is suspended until the main MCU has caught up.
+ *
+ * @return The virtual time at which the MCU continues, which is the given time
+ */
+uint64_t sim_sync(sim_mcu mcu, uint64_t now);
+
+/**
+ * Suspend the running MCU until the given wake-up time, or until an external
+ * event arrives for it, whichever comes first.
+ *
+ * @param now  The virtual time at which the MCU falls asleep
+ * @param wake The virtual time of the MCU's next interrupt, or UINT64_MAX
+ * @return The virtual time at which the MCU wakes up
+ */
+uint64_t sim_sleep(sim_mcu mcu, uint64_t now, uint64_t wake);
+
+/**
+ * Queue an external event for an MCU.
+ */
+void sim_post_event(sim_mcu mcu, const sim_event* ev);
+
+/**
+ * Return the time of the next external event for an MCU, or UINT64_MAX if
+ * there is none.
+ */
+uint64_t sim_get_next_event_time(sim_mcu mcu);
+
+/**
+ * Remove the next external event for an MCU from its queue.
+ *
+ * @return false if there is no event queued
+ */
+bool sim_pop_event(sim_mcu mcu, sim_event* ev);
+
+/**
+ * Report the value of the PORTB register of an MCU, which drives the chip
+ * select lines of the SPI bus.
+ */
+void sim_wire_set_pins(sim_mcu mcu, uint8_t portb, uint64_t now);
+
+/**
+ * Send a byte over the SPI bus of an MCU, as its master.
+ *
+ * @return The byte received from the selected slave, or 0xFF
+ */
+uint8_t sim_wire_transfer(sim_mcu mcu, uint8_t mosi, uint64_t now);
+
+#endif
@@ -0,0 +1,158 @@
+/*
+ * hd44780.h
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HD44780_H
+#define HD44780_H
+
+/**
+ * @file hd44780.h
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ *
+ * Model of the HD44780 LCD driver for the simulator, see sim.h. It replaces
+ * drivers/hd44780.h in the IO panel image, with the subset of the interface
+ * that the IO panel firmware uses. Characters written to the display end up
+ * in a DDRAM buffer and cost a fixed amount of CPU time each, which stands
+ * for queueing them in the instruction buffer of the real driver.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "hal/gpio.h"
+#include "sim_board.h"
+
+// CPU time of writing a character to the display
+#ifndef SIM_LCD_CONF_CHAR_NS
+#define SIM_LCD_CONF_CHAR_NS 1000
+#endif
+
+#define HD44780_20X4_LINE0 0x00
+#define HD44780_20X4_LINE1 0x40
+#define HD44780_20X4_LINE2 0x14
+#define HD44780_20X4_LINE3 0x54
+
+#define HD44780_DDRAM_SIZE 0x80
+
+typedef struct hd44780_lcd {
+  uint8_t address;
+  uint8_t ddram[HD44780_DDRAM_SIZE];
+  FILE* stream;
+} hd44780_lcd;
+
+typedef struct hd44780_cgram hd44780_cgram;
+
+typedef enum {
+  HD44780_ONE_ROW = 0,
+  HD44780_TWO_ROWS = 8,
+} hd44780_nb_rows;
+
+typedef enum {
+  HD44780_LEFT = 0,
+  HD44780_RIGHT = 2,
+} hd44780_direction;
+
+typedef enum {
+  HD44780_SETUP_OK,
+} hd44780_setup_status;
+
+#define NO_SHIFT_DISPLAY false
+#define ENABLE_DISPLAY true
+#define DISABLE_CURSOR false
+#define DISABLE_CURSOR_BLINK false
+
+static inline
+void hd44780_init(void)
+{ }
+
+static inline hd44780_setup_status
+hd44780_lcd_setup(hd44780_lcd* lcd, port_ptr data_port, port_ptr ctrl_port,
+		  uint8_t hnibble_pin, uint8_t e_pin, uint8_t rs_pin,
+		  uint8_t rw_pin, uint8_t* instr_buf, size_t instr_buf_sz,
+		  hd44780_cgram* cgram)
+{
+  lcd->address = 0;
+  lcd->stream = NULL;
+  return HD44780_SETUP_OK;
+}
+
+static inline
+void hd44780_lcd_init(hd44780_lcd* lcd, hd44780_nb_rows nb_rows)
+{
+  for (uint8_t i = 0; i < HD44780_DDRAM_SIZE; ++i) {
+    lcd->ddram[i] = ' ';
+  }
+}
+
+static inline
+void hd44780_lcd_set_entry_mode(hd44780_lcd* lcd, hd44780_direction cursor_dir,
+				bool shift_display)
+{ }
+
+static inline
+void hd44780_lcd_set_display(hd44780_lcd* lcd, bool display, bool cursor,
+			     bool cursor_blink)
+{ }
+
+static inline
+void hd44780_lcd_set_ddram_address(hd44780_lcd* lcd, uint8_t address)
+{
+  lcd->address = address % HD44780_DDRAM_SIZE;
+}
+
+static inline
+void hd44780_lcd_put(hd44780_lcd* lcd, uint8_t data)
+{
+  lcd->ddram[lcd->address] = data;
+  lcd->address = (lcd->address + 1) % HD44780_DDRAM_SIZE;
+}
+
+static inline
+void hd44780_lcd_write(hd44780_lcd* lcd, uint8_t data)
+{
+  hd44780_lcd_put(lcd, data);
+  sim_board_charge_ns(SIM_LCD_CONF_CHAR_NS);
+}
+
+static inline ssize_t
+hd44780_lcd_stream_write(void* cookie, const char* buf, size_t size)
+{
+  for (size_t i = 0; i < size; ++i) {
+    hd44780_lcd_put((hd44780_lcd*)cookie, buf[i]);
+  }
+  sim_board_charge_ns(size * SIM_LCD_CONF_CHAR_NS);
+  return size;
+}
+
+static inline
+FILE* hd44780_lcd_stream(hd44780_lcd* lcd)
+{
+  if (lcd->stream == NULL) {
+    cookie_io_functions_t io = { .write = hd44780_lcd_stream_write };
+    lcd->stream = fopencookie(lcd, "w", io);
+    setvbuf(lcd->stream, NULL, _IONBF, 0);
+  }
+  return lcd->stream;
+}
+
+#endif
@@ -0,0 +1,148 @@
+/*
+ * sim_bench.c
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sim_bench.c
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ */
+
+#include "sim_bench.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bench.h"
+#include "sim.h"
+
+#define MS_TO_NS(ms) ((ms) * 1000000ULL)
+#define US_TO_NS(us) ((us) * 1000ULL)
+
+#define SETTLE_TIME     MS_TO_NS(100)
+#define NB_STEPS        50
+// Each knob input level is held this long, plus a varying phase, so the steps
+// are not aligned with the debounce and the IO panel polling schedules
+#define HOLD_TIME       MS_TO_NS(30)
+#define HOLD_PHASE_STEP US_TO_NS(1370)
+#define HOLD_PHASE_MAX  MS_TO_NS(10)
+
+// Pins of the voltage rotary encoder on the IO panel, on PINC
+#define ROTV_A    (1 << 0)
+#define ROTV_B    (1 << 1)
+#define ROTV_PUSH (1 << 2)
+
+#define DAC_CHANNEL_A 0 // Voltage
+#define DAC_CHANNEL_B 1 // Current
+
+// Clockwise quadrature sequence of (B,A), a step completes on the odd entries
+static const uint8_t cw_sequence[] = {
+  ROTV_A,
+  ROTV_A | ROTV_B,
+  ROTV_B,
+  0,
+};
+
+static uint16_t dac_values[2];
+static uint8_t wait_channel;
+static uint64_t latch_ns;
+static unsigned int hold_index;
+
+static void
+dac_latched(uint8_t channel, uint16_t value, bool active, uint64_t time)
+{
+  if (active && channel == wait_channel && value != dac_values[channel] &&
+	     latch_ns == 0) {
+    latch_ns = time;
+  }
+  dac_values[channel] = value;
+}
+
+static void
+hold(void)
+{
+  sim_run(HOLD_TIME + (hold_index * HOLD_PHASE_STEP) % HOLD_PHASE_MAX);
+  hold_index += 1;
+}
+
+// Turn the knob clockwise and measure the time from the edge that completes
+// each step until the DAC channel takes on a new value
+static void
+turn_knob(const char* name, uint8_t channel)
+{
+  uint64_t total_ns = 0, max_ns = 0;
+  unsigned int nb_latencies = 0;
+  unsigned long transfers = sim_get_nb_iopanel_transfers();
+  unsigned long frames = sim_get_nb_dac_frames();
+  unsigned long bytes = sim_get_nb_spi_bytes();
+  uint64_t sim_start = sim_now_ns();
+  uint64_t host_start = bench_now_ns();
+
+  wait_channel = channel;
+  for (unsigned int i = 0; i < NB_STEPS * 2; ++i) {
+    uint8_t level = cw_sequence[i % sizeof(cw_sequence)];
+    latch_ns = 0;
+    uint64_t edge_ns = sim_now_ns();
+    sim_set_pins(SIM_IOPANEL, SIM_PINC, ROTV_A | ROTV_B, level);
+    hold();
+    if (i % 2 == 1 && latch_ns != 0) {
+      uint64_t latency = latch_ns - edge_ns;
+      total_ns += latency;
+      if (latency > max_ns) {
+	max_ns = latency;
+      }
+      nb_latencies += 1;
+    }
+  }
+
+  double host_s = (bench_now_ns() - host_start) / 1e9;
+  double sim_s = (sim_now_ns() - sim_start) / 1e9;
+  BENCH_REPORT(name, "%u/%u steps  latency avg %6.2f ms, max %6.2f ms",
+	       nb_latencies, NB_STEPS,
+	       nb_latencies ? total_ns / 1e6 / nb_latencies : 0.0,
+	       max_ns / 1e6);
+  BENCH_REPORT("", "%6.1f trx/s  %6.1f DAC frames/s  %7.1f SPI bytes/s  "
+	       "%6.1fx real time",
+	       (sim_get_nb_iopanel_transfers() - transfers) / sim_s,
+	       (sim_get_nb_dac_frames() - frames) / sim_s,
+	       (sim_get_nb_spi_bytes() - bytes) / sim_s,
+	       sim_s / host_s);
+}
+
+static void
+press_button(void)
+{
+  sim_set_pins(SIM_IOPANEL, SIM_PINC, ROTV_PUSH, ROTV_PUSH);
+  hold();
+  sim_set_pins(SIM_IOPANEL, SIM_PINC, ROTV_PUSH, 0);
+  hold();
+}
+
+void sim_bench(void)
+{
+  sim_init();
+  sim_set_dac_hook(dac_latched);
+  wait_channel = DAC_CHANNEL_A;
+  sim_run(SETTLE_TIME);
+
+  turn_knob("sim: voltage knob to DAC", DAC_CHANNEL_A);
+  press_button();
+  turn_knob("sim: current knob to DAC", DAC_CHANNEL_B);
+}
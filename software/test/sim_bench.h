@@ -0,0 +1,39 @@
+/*
+ * sim_bench.h
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SIM_BENCH_H
+#define SIM_BENCH_H
+
+/**
+ * @file sim_bench.h
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ */
+
+/**
+ * Simulate the complete PSU, see sim.h. Turn the voltage knob and then the
+ * current knob of the IO panel, and report the latency from each knob step to
+ * the new value being latched by the DAC, together with the SPI transaction
+ * rates and how much faster than real time the simulation runs.
+ */
+void sim_bench(void);
+
+#endif
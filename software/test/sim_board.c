@@ -0,0 +1,453 @@
+/*
+ * sim_board.c
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file sim_board.c
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ */
+
+#include "sim_board.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sim.h"
+#include "core/clock.h"
+#include "core/rtimer.h"
+#include "hal/adc.h"
+#include "hal/gpio.h"
+#include "hal/mock_timer.h"
+#include "hal/sleep.h"
+#include "hal/spi.h"
+#include "hal/timer1.h"
+#include "util/atomic.h"
+
+#ifndef SIM_BOARD_CONF_NAME
+#error "SIM_BOARD_CONF_NAME must name the board definition of the image"
+#endif
+
+#define CYCLES_TO_NS(c) ((uint64_t)(c) * 1000000000ULL / F_CPU)
+
+#define ADC_CONVERSION_NS CYCLES_TO_NS(13 * 64)
+
+// Process statistics timer, see process.c
+#define STATS_TMR_PRESCALER 8
+
+#define SPI_BUFFER_SIZE 16
+
+int main(void);
+#ifdef SIM_BOARD_CONF_ADC
+void adc_conversion_complete_vect(void);
+#endif
+#ifdef SIM_BOARD_CONF_SPI_SLAVE
+void pc_interrupt(void);
+void spi_transfer_complete_vect(void);
+#endif
+
+typedef struct {
+  mock_timer* tmr;
+  uint32_t tick_ns;
+  uint64_t next_tick; // Time of the next counter increment
+} sim_timer;
+
+static sim_mcu mcu;
+static uint64_t now;
+static bool in_isr;
+static unsigned long nb_isrs;
+static bool io_clock_halted;
+static uint64_t halted_since;
+static uint8_t last_portb;
+#ifdef SIM_BOARD_CONF_ADC
+static uint64_t next_conversion;
+#endif
+static sim_timer timers[] = {
+  { .tick_ns = CYCLES_TO_NS(CLOCK_TMR_PRESCALER) },
+  { .tick_ns = CYCLES_TO_NS(RTIMER_TMR_PRESCALER) },
+};
+#define NB_TIMERS (sizeof(timers) / sizeof(timers[0]))
+
+
+// Let the wire see changes of the chip select outputs
+static void
+check_pins(void)
+{
+  if (PORTB != last_portb) {
+    last_portb = PORTB;
+    sim_wire_set_pins(mcu, PORTB, now);
+  }
+}
+
+
+// Number of ticks until the counter reaches a value that causes an interrupt,
+// or 0 if no timer interrupt is enabled
+static uint32_t
+ticks_to_interrupt(mock_timer* tmr)
+{
+  const uint32_t top = 1UL << tmr->nb_bits;
+  uint32_t ticks = 0;
+  if (tmr->ovf_intr_enabled) {
+    ticks = top - tmr->cntr;
+  }
+  if (tmr->oca_intr_enabled) {
+    uint32_t d = (tmr->ocra - tmr->cntr) & (top - 1);
+    d = (d == 0) ? top : d;
+    ticks = (ticks == 0 || d < ticks) ? d : ticks;
+  }
+  if (tmr->ocb_intr_enabled) {
+    uint32_t d = (tmr->ocrb - tmr->cntr) & (top - 1);
+    d = (d == 0) ? top : d;
+    ticks = (ticks == 0 || d < ticks) ? d : ticks;
+  }
+  return ticks;
+}
+
+
+static uint64_t
+get_timer_interrupt_time(sim_timer* t)
+{
+  if (! t->tmr->clock_enabled || io_clock_halted) {
+    return UINT64_MAX;
+  }
+  uint32_t ticks = ticks_to_interrupt(t->tmr);
+  if (ticks == 0) {
+    return UINT64_MAX;
+  }
+  return t->next_tick + (uint64_t)(ticks - 1) * t->tick_ns;
+}
+
+
+// Advance the counter to the given time, without passing a tick that causes
+// an interrupt
+static void
+sync_timer(sim_timer* t, uint64_t until)
+{
+  if (! t->tmr->clock_enabled) {
+    t->next_tick = until + t->tick_ns;
+    return;
+  }
+  if (io_clock_halted || t->next_tick > until) {
+    return;
+  }
+
+  uint64_t ticks = (until - t->next_tick) / t->tick_ns + 1;
+  uint32_t limit = ticks_to_interrupt(t->tmr);
+  if (limit != 0 && ticks >= limit) {
+    ticks = limit - 1;
+  }
+  t->tmr->cntr = (t->tmr->cntr + ticks) & ((1UL << t->tmr->nb_bits) - 1);
+  t->next_tick += ticks * t->tick_ns;
+}
+
+
+static uint64_t
+get_conversion_time(void)
+{
+#ifdef SIM_BOARD_CONF_ADC
+  if (adc_mock_is_busy()) {
+    return next_conversion;
+  }
+#endif
+  return UINT64_MAX;
+}
+
+
+static uint64_t
+get_next_event_time(void)
+{
+  uint64_t next = sim_get_next_event_time(mcu);
+  for (uint8_t i = 0; i < NB_TIMERS; ++i) {
+    uint64_t t = get_timer_interrupt_time(&timers[i]);
+    next = (t < next) ? t : next;
+  }
+  uint64_t t = get_conversion_time();
+  return (t < next) ? t : next;
+}
+
+
+static void
+run_isr(void (*isr)(void))
+{
+  in_isr = true;
+  isr();
+  in_isr = false;
+  now += SIM_BOARD_CONF_ISR_NS;
+  nb_isrs += 1;
+  check_pins();
+}
+
+
+static void
+tick_timer(void)
+{
+  for (uint8_t i = 0; i < NB_TIMERS; ++i) {
+    sim_timer* t = &timers[i];
+    if (get_timer_interrupt_time(t) <= now) {
+      sync_timer(t, now);
+      mock_timer_tick(t->tmr);
+      t->next_tick += t->tick_ns;
+      return;
+    }
+  }
+}
+
+
+#ifdef SIM_BOARD_CONF_ADC
+static void
+convert(void)
+{
+  next_conversion += ADC_CONVERSION_NS;
+  adc_mock_convert(1);
+}
+#endif
+
+
+static void
+handle_external_event(void)
+{
+  sim_event ev;
+  sim_pop_event(mcu, &ev);
+  switch (ev.type) {
+  case SIM_EVENT_PINS: {
+    uint8_t* pin = &gpio_mock_io[ev.pin_reg];
+    uint8_t changed = (*pin ^ ev.value) & ev.mask;
+    *pin ^= changed;
+#ifdef SIM_BOARD_CONF_SPI_SLAVE
+    if (changed & gpio_mock_pcmsk[(ev.pin_reg - SIM_PINB) / 3]) {
+      run_isr(pc_interrupt);
+    }
+#endif
+    break;
+  }
+  case SIM_EVENT_SPI_TRANSFER_COMPLETE:
+#ifdef SIM_BOARD_CONF_SPI_SLAVE
+    if (spi_mock_is_interrupt_enabled(SPI_INTERRUPT_TC)) {
+      run_isr(spi_transfer_complete_vect);
+    }
+#endif
+    break;
+  }
+}
+
+
+// Handle the next hardware event, which must be due
+static void
+handle_next_event(void)
+{
+  if (sim_get_next_event_time(mcu) <= now) {
+    handle_external_event();
+  } else if (get_conversion_time() <= now) {
+#ifdef SIM_BOARD_CONF_ADC
+    run_isr(convert);
+#endif
+  } else {
+    run_isr(tick_timer);
+  }
+}
+
+
+// Handle the hardware events up to the given time
+static void
+handle_events(uint64_t until)
+{
+  uint64_t next;
+  while ((next = get_next_event_time()) <= until) {
+    if (next > now) {
+      now = next;
+    }
+    handle_next_event();
+  }
+}
+
+
+static void
+sync_hardware(void)
+{
+  for (uint8_t i = 0; i < NB_TIMERS; ++i) {
+    sync_timer(&timers[i], now);
+  }
+#ifdef SIM_BOARD_CONF_ADC
+  if (! adc_mock_is_busy()) {
+    next_conversion = now + ADC_CONVERSION_NS;
+  }
+#endif
+}
+
+
+// Let the CPU run for the given time
+static void
+run(uint32_t ns)
+{
+  check_pins();
+  if (in_isr || atomic_mock_is_masked()) {
+    now += ns;
+    return;
+  }
+
+  // Interrupts that preempt the CPU postpone the end of its work
+  uint64_t end = now + ns;
+  uint64_t next;
+  while ((next = get_next_event_time()) <= end) {
+    if (next > now) {
+      now = next;
+    }
+    const unsigned long isrs = nb_isrs;
+    handle_next_event();
+    end += (nb_isrs - isrs) * SIM_BOARD_CONF_ISR_NS;
+  }
+  now = end;
+  sync_hardware();
+  now = sim_sync(mcu, now);
+}
+
+
+void
+sim_board_charge_ns(uint32_t ns)
+{
+  run(ns);
+}
+
+
+// Process statistics timer read hook: process.c reads the timer right before
+// and right after running a process
+static void
+dispatch(void)
+{
+  run(SIM_BOARD_CONF_DISPATCH_NS / 2);
+  MOCK_TIMER(TIMER1)->cntr =
+    (uint16_t)(now * (F_CPU / STATS_TMR_PRESCALER / 1000000) / 1000);
+}
+
+
+static uint8_t
+transfer(uint8_t mosi)
+{
+  check_pins();
+  uint8_t miso = sim_wire_transfer(mcu, mosi, now);
+  run(SIM_SPI_BYTE_NS);
+  return miso;
+}
+
+
+static void
+wake_up(void)
+{
+  if (sleep_mock_state.mode == SLEEP_MODE_ADC) {
+    // Entering noise reduction sleep starts a conversion and stops the timers
+#ifdef SIM_BOARD_CONF_ADC
+    if (! adc_mock_is_busy()) {
+      adc_mock_start_conversion();
+      next_conversion = now + ADC_CONVERSION_NS;
+    }
+#endif
+    sync_hardware();
+    io_clock_halted = true;
+    halted_since = now;
+  }
+
+  const unsigned long isrs = nb_isrs;
+  while (nb_isrs == isrs) {
+    uint64_t next = get_next_event_time();
+    if (next > now) {
+      now = sim_sleep(mcu, now, next);
+    }
+    handle_events(now);
+  }
+
+  if (io_clock_halted) {
+    io_clock_halted = false;
+    for (uint8_t i = 0; i < NB_TIMERS; ++i) {
+      timers[i].next_tick += now - halted_since;
+    }
+  }
+}
+
+
+#ifdef SIM_BOARD_CONF_SPI_SLAVE
+static uint8_t
+slave_transfer(uint8_t mosi, uint64_t time)
+{
+  uint8_t miso = spi_mock_slave_transfer(mosi);
+  if (spi_mock_is_interrupt_enabled(SPI_INTERRUPT_TC)) {
+    sim_event ev = {
+      .time = time + SIM_SPI_BYTE_NS,
+      .type = SIM_EVENT_SPI_TRANSFER_COMPLETE,
+    };
+    sim_post_event(mcu, &ev);
+  }
+  return miso;
+}
+#endif
+
+
+#ifdef SIM_BOARD_CONF_ADC
+static void
+set_adc_input(uint8_t channel, uint16_t value)
+{
+  adc_mock_set_value(channel, value);
+}
+#endif
+
+
+static void
+start(sim_mcu id)
+{
+  mcu = id;
+  now = 0;
+  in_isr = false;
+  nb_isrs = 0;
+  io_clock_halted = false;
+  gpio_mock_init();
+  last_portb = PORTB;
+  spi_mock_init(SPI_BUFFER_SIZE);
+  spi_mock_set_transfer_hook(transfer);
+#ifdef SIM_BOARD_CONF_ADC
+  adc_mock_init();
+  next_conversion = ADC_CONVERSION_NS;
+#endif
+  sleep_mock_init(wake_up);
+  timers[0].tmr = MOCK_TIMER(CLOCK_TMR);
+  timers[1].tmr = MOCK_TIMER(RTIMER_TMR);
+  for (uint8_t i = 0; i < NB_TIMERS; ++i) {
+    timers[i].next_tick = timers[i].tick_ns;
+  }
+  mock_timer_set_read_hook(MOCK_TIMER(TIMER1), dispatch);
+  atomic_mock_set_exit_hook(check_pins);
+
+  // Apply the initial pin levels
+  handle_events(0);
+  main();
+}
+
+
+const sim_board SIM_BOARD_CONF_NAME = {
+  .start = start,
+#ifdef SIM_BOARD_CONF_SPI_SLAVE
+  .spi_slave_transfer = slave_transfer,
+#else
+  .spi_slave_transfer = NULL,
+#endif
+#ifdef SIM_BOARD_CONF_ADC
+  .set_adc_input = set_adc_input,
+#else
+  .set_adc_input = NULL,
+#endif
+};
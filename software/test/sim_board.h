@@ -0,0 +1,66 @@
+/*
+ * sim_board.h
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SIM_BOARD_H
+#define SIM_BOARD_H
+
+/**
+ * @file sim_board.h
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ *
+ * Board glue between a firmware image and the simulator, see sim.h.
+ *
+ * sim_board.c is compiled into each firmware image. It drives the mocks of
+ * the image as the hardware of the MCU would: timer ticks, ADC conversions,
+ * pin changes and SPI transfers are delivered as interrupts at their virtual
+ * time. Interrupts are only delivered when the firmware gives the simulator
+ * control, which is when a process is dispatched, when a byte is sent over
+ * SPI, when CPU time is charged and when the CPU sleeps, and never while
+ * interrupts are masked.
+ *
+ * An image is configured with these defines:
+ * - SIM_BOARD_CONF_NAME: name of the sim_board definition to export
+ * - SIM_BOARD_CONF_ADC: deliver ADC conversion complete interrupts
+ * - SIM_BOARD_CONF_SPI_SLAVE: deliver the interrupts of the SPI slave
+ */
+
+#include <stdint.h>
+
+// CPU time of dispatching an event to a process, including the process itself
+#ifndef SIM_BOARD_CONF_DISPATCH_NS
+#define SIM_BOARD_CONF_DISPATCH_NS 20000
+#endif
+
+// CPU time of an interrupt service routine
+#ifndef SIM_BOARD_CONF_ISR_NS
+#define SIM_BOARD_CONF_ISR_NS 4000
+#endif
+
+/**
+ * Charge CPU time to the running firmware, for simulated hardware that keeps
+ * the CPU busy, such as the LCD.
+ *
+ * @param ns The CPU time in nanoseconds
+ */
+void sim_board_charge_ns(uint32_t ns);
+
+#endif
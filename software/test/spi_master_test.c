@@ -32,9 +32,11 @@
 #include <check.h>
 
 #include "core/process.h"
+#include "core/rtimer.h"
 #include "core/spi_master.h"
 #include "hal/mock_timer.h"
 #include "hal/spi.h"
+#include "util/bit.h"
 #include "util/math.h"
 
 #include "spi_master_test.h"
@@ -351,6 +353,49 @@ START_TEST(test_trx_multiple)
 END_TEST
 
 
+// ****************************************************************************
+//                       test_frame_preempt
+// ****************************************************************************
+START_TEST(test_frame_preempt)
+{
+  static const uint8_t frame_data[2] = { 0xAB, 0xCD };
+  uint8_t frame_port = 0xFF;
+  spim_frame frame;
+  spim_trx_llp trx;
+  rtimer_init();
+  spim_frame_set(&frame, SPI_DUMMY_PIN, &frame_port, 2, frame_data);
+  spim_trx_init((spim_trx*)&trx);
+  spim_trx_llp_set(&trx, SPI_DUMMY_PIN, &dummy_port, 0x01,
+		   DUMMY_DATA_SIZE, dummy_data, 0, NULL, NULL);
+  spim_trx_queue((spim_trx*)&trx);
+
+  // Start the LLP transfer, which then waits between bytes
+  process_execute();
+  ck_assert(spim_trx_is_in_transmission((spim_trx*)&trx));
+  ck_assert(! (dummy_port & _BV(SPI_DUMMY_PIN)));
+  unsigned int nb_bytes = spi_mock_get_nb_bytes_transmitted();
+
+  // The frame is sent right away, with the slave of the transfer deselected
+  spim_frame_send(&frame);
+  ck_assert_uint_eq(spi_mock_get_nb_bytes_transmitted(), nb_bytes + 2);
+  ck_assert_uint_eq(spi_mock_get_last_transmitted_data(1), 0xAB);
+  ck_assert_uint_eq(spi_mock_get_last_transmitted_data(0), 0xCD);
+  ck_assert(dummy_port & _BV(SPI_DUMMY_PIN));
+  ck_assert(frame_port & _BV(SPI_DUMMY_PIN));
+
+  // The preempted transfer finishes with an error
+  int i = 0;
+  while (spim_trx_is_in_transmission((spim_trx*)&trx)) {
+    if (i > 1000) ck_abort_msg("Transmission timeout");
+    MOCK_TIMER_TICK(RTIMER_TMR);
+    process_execute();
+    i += 1;
+  }
+  ck_assert(spim_trx_llp_get_error_type(&trx) == SPIM_TRX_ERR_PREEMPTED);
+}
+END_TEST
+
+
 // ****************************************************************************
 //                           Test suite setup
 // ****************************************************************************
@@ -374,6 +419,7 @@ Suite *spi_master_suite(void)
   add_tcase(s, test_receive_bytes,            "Receive bytes");
   add_tcase(s, test_send_receive,             "Send/receive bytes");
   add_tcase(s, test_trx_multiple,             "Send/receive multiple trx");
+  add_tcase(s, test_frame_preempt,            "Frame preempt");
 
   return s;
 }
@@ -0,0 +1,90 @@
+/*
+ * atomic.c
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file atomic.c
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ */
+
+#include "atomic.h"
+
+#include <time.h>
+
+static uint8_t depth;
+static uint32_t nb_blocks;
+static bool timed;
+static uint64_t masked_ns;
+static struct timespec enter_time;
+static void (*exit_hook)(void);
+
+uint8_t atomic_mock_enter(void)
+{
+  if (depth == 0) {
+    nb_blocks += 1;
+    if (timed) {
+      clock_gettime(CLOCK_MONOTONIC, &enter_time);
+    }
+  }
+  depth += 1;
+  return depth;
+}
+
+void atomic_mock_exit(uint8_t* state)
+{
+  depth -= 1;
+  if (depth == 0 && timed) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    masked_ns += (uint64_t)(now.tv_sec - enter_time.tv_sec) * 1000000000ULL
+      + now.tv_nsec - enter_time.tv_nsec;
+  }
+  if (depth == 0 && exit_hook != NULL) {
+    exit_hook();
+  }
+}
+
+bool atomic_mock_is_masked(void)
+{
+  return depth > 0;
+}
+
+void atomic_mock_set_exit_hook(void (*hook)(void))
+{
+  exit_hook = hook;
+}
+
+void atomic_mock_reset(bool t)
+{
+  nb_blocks = 0;
+  masked_ns = 0;
+  timed = t;
+}
+
+uint32_t atomic_mock_get_nb_blocks(void)
+{
+  return nb_blocks;
+}
+
+uint64_t atomic_mock_get_masked_ns(void)
+{
+  return masked_ns;
+}
@@ -1,3 +1,84 @@
+/*
+ * atomic.h
+ *
+ * Copyright 2026 Pieter Agten
+ *
+ * This file is part of the lab-psu firmware.
+ *
+ * The firmware is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * The firmware is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with the firmware.  If not, see <http://www.gnu.org/licenses/>.
+ */
 
+#ifndef TST_ATOMIC_H
+#define TST_ATOMIC_H
 
-#define ATOMIC_BLOCK(type)
+/**
+ * @file atomic.h
+ * @author Pieter Agten <pieter.agten@gmail.com>
+ * @date 15 Oct 2026
+ *
+ * Mock of avr-libc's atomic blocks. Like the real implementation, the end of
+ * an atomic block is detected using the cleanup attribute, so leaving a block
+ * with return or break is handled correctly. The mock counts the number of
+ * atomic blocks that are entered and can optionally measure the amount of
+ * time spent inside them, i.e. the time during which interrupts would be
+ * masked on the target.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ATOMIC_RESTORESTATE						\
+  uint8_t atomic_mock_state __attribute__((__cleanup__(atomic_mock_exit))) \
+    = atomic_mock_enter()
+#define ATOMIC_FORCEON  ATOMIC_RESTORESTATE
+
+#define ATOMIC_BLOCK(type)						\
+  for (type, atomic_mock_todo = 1; atomic_mock_todo; atomic_mock_todo = 0)
+
+uint8_t atomic_mock_enter(void);
+void atomic_mock_exit(uint8_t* state);
+
+/**
+ * Return whether interrupts are masked, i.e. whether an atomic block is being
+ * executed.
+ */
+bool atomic_mock_is_masked(void);
+
+/**
+ * Set a function to call whenever the outermost atomic block is left, when the
+ * interrupts that became pending inside the block would be handled on the
+ * target. Use NULL to remove the hook.
+ */
+void atomic_mock_set_exit_hook(void (*hook)(void));
+
+/**
+ * Reset the atomic block statistics.
+ *
+ * @param timed Whether to measure the time spent in atomic blocks. Timing
+ *              adds considerable overhead, so it is disabled by default.
+ */
+void atomic_mock_reset(bool timed);
+
+/**
+ * Return the number of (outermost) atomic blocks entered since the last reset.
+ */
+uint32_t atomic_mock_get_nb_blocks(void);
+
+/**
+ * Return the time in nanoseconds spent in atomic blocks since the last reset,
+ * if timing is enabled.
+ */
+uint64_t atomic_mock_get_masked_ns(void);
+
+#endif
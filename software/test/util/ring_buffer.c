@@ -31,7 +31,7 @@ bool ring_buffer_empty (struct ring_buffer *rb)
  
 void ring_buffer_put(struct ring_buffer *rb, uint8_t value)
 {
-  rb->latest = rb->latest + 1 % rb->size;
+  rb->latest = (rb->latest + 1) % rb->size;
   rb->elems[rb->latest] = value;
   if (rb->count < rb->size)
     rb->count += 1;
@@ -44,5 +44,5 @@ uint8_t ring_buffer_get_latest(struct ring_buffer *rb, unsigned int i)
     return 0;
   }
 
-  return rb->elems[rb->latest - i % rb->size];
+  return rb->elems[(rb->latest + rb->size - i) % rb->size];
 }
@@ -30,6 +30,8 @@
 #ifndef BIT_H
 #define BIT_H
 
+#include <stdint.h>
+
 #define _BV(bit)   (1 << (bit))
 
 static inline
@@ -37,5 +39,24 @@ uint8_t bv8(uint8_t v) {
   return 1 << v; //TODO: check whether this gets optimized
 }
 
+/**
+ * Count the number of trailing zero bits in a byte, i.e. return the index of
+ * the least significant bit that is set. Returns 8 if no bits are set.
+ *
+ * AVR has no find-first-set instruction, so this uses a nibble lookup table,
+ * which takes a constant number of cycles.
+ */
+static inline
+uint8_t ctz8(uint8_t v) {
+  static const uint8_t nibble_ctz[16] = {
+    4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0
+  };
+  const uint8_t lo = nibble_ctz[v & 0x0F];
+  if (lo < 4) {
+    return lo;
+  }
+  return 4 + nibble_ctz[v >> 4];
+}
+
 
 #endif
@@ -48,6 +48,10 @@ void debug_init()
 
 #else 
 
+inline static
+void debug_init()
+{ }
+
 #define SET_DEBUG_LED(id)
 #define CLR_DEBUG_LED(id)
 #define TGL_DEBUG_LED(id)
@@ -32,6 +32,11 @@
 
 // Process
 LOG_COUNTER_ON(EVENT_QUEUE_FULL)
+LOG_COUNTER_ON(ISR_EVENT_QUEUE_FULL)
+LOG_COUNTER_ON(PROCESS_DEADLINE_MISSED)
+
+// Event timers
+LOG_COUNTER_ON(ETIMER_QUEUE_FULL)
 
 // SPI Master
 LOG_COUNTER_ON(SPIM_ERROR_RESPONSE)